@@ -110,18 +110,10 @@ _fetch_media_info (GtuberDlArgs *dl_args)
   return info;
 }
 
-static gboolean
-_same_itag_func (gconstpointer a, gconstpointer b)
-{
-  GtuberStream *stream = (GtuberStream *) a;
-  guint itag = GPOINTER_TO_UINT (b);
-
-  return (gtuber_stream_get_itag (stream) == itag);
-}
-
 static const gchar *
 _get_file_ext (GtuberDlArgs *dl_args, GtuberMediaInfo *info)
 {
+  GtuberStreamSelector *selector;
   gchar **itags;
   GtuberCodecFlags muxer_flags = 0;
   guint i;
@@ -129,6 +121,7 @@ _get_file_ext (GtuberDlArgs *dl_args, GtuberMediaInfo *info)
   if (!dl_args->itags)
     return NULL;
 
+  selector = gtuber_stream_selector_new (info);
   itags = g_strsplit (dl_args->itags, ",", 0);
 
   for (i = 0; itags[i]; ++i) {
@@ -138,27 +131,15 @@ _get_file_ext (GtuberDlArgs *dl_args, GtuberMediaInfo *info)
     itag = g_ascii_strtoull (itags[i], NULL, 10);
 
     if (itag > 0) {
-      GPtrArray *streams, *astreams;
-      GtuberStream *stream = NULL;
-      guint index = -1;
-
-      streams = gtuber_media_info_get_streams (info);
-      astreams = gtuber_media_info_get_adaptive_streams (info);
-
-      if (g_ptr_array_find_with_equal_func (astreams,
-          GUINT_TO_POINTER (itag), (GEqualFunc) _same_itag_func, &index)) {
-        stream = GTUBER_STREAM (g_ptr_array_index (astreams, index));
-      } else if (g_ptr_array_find_with_equal_func (streams,
-          GUINT_TO_POINTER (itag), (GEqualFunc) _same_itag_func, &index)) {
-        stream = GTUBER_STREAM (g_ptr_array_index (streams, index));
-      }
-
-      if (stream)
+      GtuberStream *stream;
+
+      if ((stream = gtuber_stream_selector_get_stream_by_itag (selector, itag)))
         muxer_flags |= gtuber_stream_get_codec_flags (stream);
     }
   }
 
   g_strfreev (itags);
+  g_object_unref (selector);
 
   return ((GTUBER_CODEC_MP4A & muxer_flags) == muxer_flags)
       ? ".m4a"
@@ -230,29 +211,11 @@ update_filename (GtuberDlArgs *dl_args, GtuberMediaInfo *info)
   GST_INFO ("Output file path: %s", dl_args->output);
 }
 
-static GtuberStream *
-_select_better_quality (GtuberStream *candidate, GtuberStream *prev)
-{
-  if (!prev
-      || gtuber_stream_get_height (candidate) > gtuber_stream_get_height (prev)
-      || gtuber_stream_get_width (candidate) > gtuber_stream_get_width (prev)
-      || gtuber_stream_get_fps (candidate) > gtuber_stream_get_fps (prev)
-      || gtuber_stream_get_codec_flags (candidate) > gtuber_stream_get_codec_flags (prev)
-      || gtuber_stream_get_bitrate (candidate) > gtuber_stream_get_bitrate (prev))
-    return candidate;
-
-  return prev;
-}
-
-static gboolean
-_can_be_muxed (GtuberStream *stream, const gchar *mux_name)
+static GtuberCodecFlags
+_get_muxer_flags (const gchar *mux_name)
 {
-  GtuberCodecFlags stream_flags = gtuber_stream_get_codec_flags (stream);
-  GtuberCodecFlags muxer_flags;
-  gboolean can_mux;
-
   /* Apply flags depending on what media container supports */
-  muxer_flags = (!strcmp (mux_name, MP4_MUX_NAME))
+  return (!strcmp (mux_name, MP4_MUX_NAME))
       ? MP4_MUX_FLAGS
       : (!strcmp (mux_name, WEBM_MUX_NAME))
       ? WEBM_MUX_FLAGS
@@ -261,52 +224,16 @@ _can_be_muxed (GtuberStream *stream, const gchar *mux_name)
       : (!strcmp (mux_name, OPUS_MUX_NAME))
       ? OPUS_MUX_FLAGS
       : (GTUBER_CODEC_UNKNOWN_VIDEO | GTUBER_CODEC_UNKNOWN_AUDIO);
-
-  can_mux = ((stream_flags & muxer_flags) > 0);
-
-  GST_LOG ("Can%s mux itag: %u", (can_mux) ? "" : "not",
-      gtuber_stream_get_itag (stream));
-
-  return can_mux;
-}
-
-static void
-_update_best_streams (GtuberStream *candidate, const gchar *mux_name,
-    gboolean audio_only, GtuberStream **best_v, GtuberStream **best_a,
-    GtuberStream **best_va)
-{
-  guint width, height, fps;
-  const gchar *vcodec, *acodec;
-  gboolean has_video, has_audio;
-
-  if (!_can_be_muxed (candidate, mux_name))
-    return;
-
-  width = gtuber_stream_get_width (candidate);
-  height = gtuber_stream_get_height (candidate);
-  fps = gtuber_stream_get_fps (candidate);
-  vcodec = gtuber_stream_get_video_codec (candidate);
-  acodec = gtuber_stream_get_audio_codec (candidate);
-
-  has_video = (width > 0 || height > 0 || fps > 0 || vcodec != NULL);
-  has_audio = (acodec != NULL);
-
-  if (has_video && has_audio && !audio_only)
-    *best_va = _select_better_quality (candidate, *best_va);
-  else if (has_video && !audio_only)
-    *best_v = _select_better_quality (candidate, *best_v);
-  else if (has_audio)
-    *best_a = _select_better_quality (candidate, *best_a);
 }
 
 static gchar *
 _determine_itags (GtuberDlArgs *dl_args, GtuberMediaInfo *info)
 {
-  GPtrArray *astreams, *streams;
+  GtuberStreamSelector *selector;
   GtuberStream *best_v = NULL, *best_a = NULL, *best_va = NULL;
   const gchar *mux_name;
   gboolean audio_only = FALSE;
-  guint i;
+  gchar *itags;
 
   if (!dl_args->non_interactive) {
     gtuber_dl_terminal_print_formats (info);
@@ -314,25 +241,31 @@ _determine_itags (GtuberDlArgs *dl_args, GtuberMediaInfo *info)
   }
 
   mux_name = _get_mux_name (dl_args, info, &audio_only);
-  astreams = gtuber_media_info_get_adaptive_streams (info);
-  streams = gtuber_media_info_get_adaptive_streams (info);
 
-  for (i = 0; i < streams->len; ++i) {
-    GtuberStream *stream = GTUBER_STREAM (g_ptr_array_index (streams, i));
-    _update_best_streams (stream, mux_name, audio_only, &best_v, &best_a, &best_va);
-  }
-  for (i = 0; i < astreams->len; ++i) {
-    GtuberStream *stream = GTUBER_STREAM (g_ptr_array_index (astreams, i));
-    _update_best_streams (stream, mux_name, audio_only, &best_v, &best_a, &best_va);
+  selector = gtuber_stream_selector_new (info);
+  gtuber_stream_selector_set_codecs (selector, _get_muxer_flags (mux_name));
+
+  best_a = gtuber_stream_selector_get_best_stream (selector,
+      GTUBER_STREAM_CONTENT_AUDIO, TRUE);
+
+  if (!audio_only) {
+    best_v = gtuber_stream_selector_get_best_stream (selector,
+        GTUBER_STREAM_CONTENT_VIDEO, TRUE);
+    best_va = gtuber_stream_selector_get_best_stream (selector,
+        GTUBER_STREAM_CONTENT_VIDEO_AUDIO, TRUE);
   }
 
-  return (audio_only && best_a)
+  itags = (audio_only && best_a)
       ? g_strdup_printf ("%u", gtuber_stream_get_itag (best_a))
       : (best_v && best_a)
       ? g_strdup_printf ("%u,%u", gtuber_stream_get_itag (best_v), gtuber_stream_get_itag (best_a))
       : (best_va)
       ? g_strdup_printf ("%u", gtuber_stream_get_itag (best_va))
       : NULL;
+
+  g_object_unref (selector);
+
+  return itags;
 }
 
 static void
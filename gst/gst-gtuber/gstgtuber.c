@@ -22,6 +22,7 @@
 #endif
 
 #include "gstgtuberelement.h"
+#include "gstgtubertracer.h"
 
 static gboolean
 plugin_init (GstPlugin *plugin)
@@ -33,10 +34,15 @@ plugin_init (GstPlugin *plugin)
       GST_PLUGIN_DEPENDENCY_FLAG_PATHS_ARE_DEFAULT_ONLY);
 
   res |= GST_ELEMENT_REGISTER (gtubersrc, plugin);
+  res |= GST_ELEMENT_REGISTER (gtuberrangesrc, plugin);
   res |= GST_ELEMENT_REGISTER (gtuberuridemux, plugin);
   res |= GST_ELEMENT_REGISTER (gtuberdashdemux, plugin);
   res |= GST_ELEMENT_REGISTER (gtuberhlsdemux, plugin);
 
+#ifndef GST_DISABLE_GST_TRACER_HOOKS
+  res |= gst_tracer_register (plugin, "gtuber", GST_TYPE_GTUBER_TRACER);
+#endif
+
   return res;
 }
 
@@ -21,12 +21,20 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "gstgtuberadaptivebin.h"
 #include "gstgtuberelement.h"
+#include "gstgtuberthroughput.h"
 
 #define DEFAULT_INITIAL_BITRATE  1600
 #define DEFAULT_TARGET_BITRATE   0
 
+/* Percentage of estimated throughput to start with */
+#define ESTIMATE_USAGE_PERCENT   80
+
+#define STATISTICS_MESSAGE_NAME  "adaptive-streaming-statistics"
+
 enum
 {
   PROP_0,
@@ -66,6 +74,16 @@ gst_gtuber_adaptive_bin_init (GstGtuberAdaptiveBin *self)
   GST_OBJECT_FLAG_SET (self, GST_BIN_FLAG_STREAMS_AWARE);
 }
 
+static void
+gst_gtuber_adaptive_bin_finalize (GObject *object)
+{
+  GstGtuberAdaptiveBin *self = GST_GTUBER_ADAPTIVE_BIN (object);
+
+  g_free (self->throughput_host);
+
+  GST_CALL_PARENT (G_OBJECT_CLASS, finalize, (object));
+}
+
 static void
 gst_gtuber_adaptive_bin_constructed (GObject* object)
 {
@@ -82,6 +100,19 @@ gst_gtuber_adaptive_bin_constructed (GObject* object)
   GST_CALL_PARENT (G_OBJECT_CLASS, constructed, (object));
 }
 
+/* Demuxer can be replaced from refresh thread */
+static GstElement *
+obtain_demuxer (GstGtuberAdaptiveBin *self)
+{
+  GstElement *demuxer;
+
+  GST_GTUBER_BIN_LOCK (self);
+  demuxer = (self->demuxer) ? gst_object_ref (self->demuxer) : NULL;
+  GST_GTUBER_BIN_UNLOCK (self);
+
+  return demuxer;
+}
+
 static void
 gst_gtuber_adaptive_bin_set_property (GObject *object, guint prop_id,
     const GValue *value, GParamSpec *pspec)
@@ -94,11 +125,16 @@ gst_gtuber_adaptive_bin_set_property (GObject *object, guint prop_id,
     case PROP_INITIAL_BITRATE:
       self->initial_bitrate = g_value_get_uint (value);
       break;
-    case PROP_TARGET_BITRATE:
+    case PROP_TARGET_BITRATE:{
+      GstElement *demuxer;
+
       self->target_bitrate = g_value_get_uint (value);
-      if (self->demuxer)
-        g_object_set (self->demuxer, "connection-speed", self->target_bitrate, NULL);
+      if ((demuxer = obtain_demuxer (self))) {
+        g_object_set (demuxer, "connection-speed", self->target_bitrate, NULL);
+        gst_object_unref (demuxer);
+      }
       break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -160,6 +196,10 @@ has_ghostpad_for_pad (GstGtuberAdaptiveBin *self, GstPad *src_pad,
           && gst_caps_is_always_compatible (my_caps, his_caps))))
         GST_DEBUG ("Found ghostpad \"%s\" for pad \"%s\"", name, pad_name);
 
+      /* Pads of demuxer replaced after refresh might not have caps yet */
+      if (!has_ghostpad && !his_caps)
+        has_ghostpad = g_str_equal (name, pad_name);
+
       gst_clear_caps (&my_caps);
       gst_clear_caps (&his_caps);
     }
@@ -217,10 +257,14 @@ demuxer_pad_link_with_ghostpad (GstPad *pad, GstGtuberAdaptiveBin *self)
 static void
 link_demuxer_pads (GstGtuberAdaptiveBin *self)
 {
+  GstElement *demuxer;
   GstIterator *iter;
   GValue value = G_VALUE_INIT;
 
-  iter = gst_element_iterate_src_pads (self->demuxer);
+  if (!(demuxer = obtain_demuxer (self)))
+    return;
+
+  iter = gst_element_iterate_src_pads (demuxer);
   GST_DEBUG_OBJECT (self, "Linking demuxer pads with ghostpads");
 
   while (gst_iterator_next (iter, &value) == GST_ITERATOR_OK) {
@@ -233,6 +277,8 @@ link_demuxer_pads (GstGtuberAdaptiveBin *self)
     g_value_unset (&value);
   }
   gst_iterator_free (iter);
+
+  gst_object_unref (demuxer);
 }
 
 static void
@@ -318,6 +364,8 @@ make_compatible_demuxer (GstGtuberAdaptiveBin *self)
 static gboolean
 gst_gtuber_adaptive_bin_prepare (GstGtuberAdaptiveBin *self)
 {
+  GstElement *demuxer;
+
   GST_GTUBER_BIN_LOCK (self);
 
   if (self->prepared) {
@@ -328,22 +376,26 @@ gst_gtuber_adaptive_bin_prepare (GstGtuberAdaptiveBin *self)
   self->prepared = TRUE;
   GST_GTUBER_BIN_UNLOCK (self);
 
-  if ((self->demuxer = make_compatible_demuxer (self))) {
-    GObjectClass *gobject_class = G_OBJECT_GET_CLASS (self->demuxer);
+  if ((demuxer = make_compatible_demuxer (self))) {
+    GObjectClass *gobject_class = G_OBJECT_GET_CLASS (demuxer);
     GstPad *pad;
 
     if (g_object_class_find_property (gobject_class, "low-watermark-time"))
-      g_object_set (self->demuxer, "low-watermark-time", 3 * GST_SECOND, NULL);
+      g_object_set (demuxer, "low-watermark-time", 3 * GST_SECOND, NULL);
+
+    gst_bin_add (GST_BIN (self), demuxer);
 
-    gst_bin_add (GST_BIN (self), self->demuxer);
+    GST_GTUBER_BIN_LOCK (self);
+    self->demuxer = demuxer;
+    GST_GTUBER_BIN_UNLOCK (self);
 
     if (!is_parent_streams_aware (self)) {
-      g_signal_connect (self->demuxer, "no-more-pads",
+      g_signal_connect (demuxer, "no-more-pads",
           (GCallback) demuxer_no_more_pads_cb, self);
     }
 
     /* Link with sink ghost pad */
-    pad = gst_element_get_static_pad (self->demuxer, "sink");
+    pad = gst_element_get_static_pad (demuxer, "sink");
     if (!gst_ghost_pad_set_target (GST_GHOST_PAD (self->sink_ghostpad), pad))
       GST_ERROR_OBJECT (self, "Could not set sink ghostpad target");
     gst_object_unref (pad);
@@ -351,18 +403,53 @@ gst_gtuber_adaptive_bin_prepare (GstGtuberAdaptiveBin *self)
     gst_pad_set_active (self->sink_ghostpad, TRUE);
   }
 
-  return (self->demuxer != NULL);
+  return (demuxer != NULL);
+}
+
+static gchar *
+obtain_upstream_host (GstGtuberAdaptiveBin *self)
+{
+  GstQuery *query;
+  gchar *uri = NULL, *host = NULL;
+
+  query = gst_query_new_uri ();
+
+  if (gst_pad_peer_query (self->sink_ghostpad, query))
+    gst_query_parse_uri (query, &uri);
+
+  gst_query_unref (query);
+
+  if (uri) {
+    GstUri *gst_uri;
+
+    if ((gst_uri = gst_uri_from_string (uri))) {
+      host = g_strdup (gst_uri_get_host (gst_uri));
+      gst_uri_unref (gst_uri);
+    }
+    g_free (uri);
+  }
+
+  return host;
 }
 
 static void
 gst_gtuber_adaptive_bin_configure (GstGtuberAdaptiveBin *self)
 {
-  guint initial_bitrate;
+  GstElement *demuxer;
+  guint initial_bitrate, estimate = 0;
+  gchar *host;
 
   GST_DEBUG ("Configuring");
 
+  /* CDN hosts differ between videos, so throughput
+   * is tracked per website instead */
+  if ((host = obtain_upstream_host (self)))
+    estimate = gst_gtuber_throughput_get_estimate (host);
+
   GST_GTUBER_BIN_LOCK (self);
   self->needs_playback_config = TRUE;
+  g_free (self->throughput_host);
+  self->throughput_host = host;
   GST_GTUBER_BIN_UNLOCK (self);
 
   GST_GTUBER_BIN_PROP_LOCK (self);
@@ -371,10 +458,23 @@ gst_gtuber_adaptive_bin_configure (GstGtuberAdaptiveBin *self)
       ? self->initial_bitrate
       : self->target_bitrate;
 
+  if (estimate > 0) {
+    initial_bitrate = estimate * ESTIMATE_USAGE_PERCENT / 100;
+
+    if (self->target_bitrate > 0)
+      initial_bitrate = MIN (initial_bitrate, self->target_bitrate);
+
+    GST_INFO_OBJECT (self, "Starting from estimated bitrate: %u kbps",
+        initial_bitrate);
+  }
+
   GST_GTUBER_BIN_PROP_UNLOCK (self);
 
-  g_object_set (self->demuxer,
-      "connection-speed", initial_bitrate, NULL);
+  if ((demuxer = obtain_demuxer (self))) {
+    g_object_set (demuxer,
+        "connection-speed", initial_bitrate, NULL);
+    gst_object_unref (demuxer);
+  }
 
   GST_DEBUG ("Configured");
 }
@@ -382,6 +482,7 @@ gst_gtuber_adaptive_bin_configure (GstGtuberAdaptiveBin *self)
 static void
 gst_gtuber_adaptive_bin_playback_configure (GstGtuberAdaptiveBin *self)
 {
+  GstElement *demuxer;
   guint target_bitrate;
 
   GST_GTUBER_BIN_LOCK (self);
@@ -400,12 +501,113 @@ gst_gtuber_adaptive_bin_playback_configure (GstGtuberAdaptiveBin *self)
   target_bitrate = self->target_bitrate;
   GST_GTUBER_BIN_PROP_UNLOCK (self);
 
-  g_object_set (self->demuxer,
-      "connection-speed", target_bitrate, NULL);
+  if ((demuxer = obtain_demuxer (self))) {
+    g_object_set (demuxer,
+        "connection-speed", target_bitrate, NULL);
+    gst_object_unref (demuxer);
+  }
 
   GST_DEBUG ("Configured playback");
 }
 
+static gboolean
+gst_gtuber_adaptive_bin_refresh (GstGtuberBin *bin, const gchar *data)
+{
+  GstGtuberAdaptiveBin *self = GST_GTUBER_ADAPTIVE_BIN_CAST (bin);
+  GstElement *old_demuxer, *demuxer;
+  GstCaps *caps;
+  GstPad *pad;
+  GstEvent *event;
+  GstSegment segment;
+  GstBuffer *buffer;
+  gchar *stream_id;
+  gsize size;
+  gboolean success;
+
+  /* Demuxers cannot swap manifest, so replace demuxer
+   * with a new one that gets the refreshed manifest */
+  if (!(caps = gst_pad_get_current_caps (self->sink_ghostpad)))
+    return FALSE;
+
+  GST_GTUBER_BIN_LOCK (self);
+  if ((old_demuxer = self->demuxer)) {
+    self->demuxer = NULL;
+    self->prepared = FALSE;
+  }
+  GST_GTUBER_BIN_UNLOCK (self);
+
+  if (!old_demuxer) {
+    gst_caps_unref (caps);
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (self, "Replacing demuxer");
+
+  gst_element_set_locked_state (old_demuxer, TRUE);
+  gst_element_set_state (old_demuxer, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN_CAST (self), old_demuxer);
+
+  if (!gst_gtuber_adaptive_bin_prepare (self)) {
+    gst_caps_unref (caps);
+    return FALSE;
+  }
+
+  gst_gtuber_adaptive_bin_configure (self);
+
+  demuxer = obtain_demuxer (self);
+  gst_element_sync_state_with_parent (demuxer);
+
+  pad = gst_element_get_static_pad (demuxer, "sink");
+  gst_object_unref (demuxer);
+
+  stream_id = g_strdup_printf ("%08x%08x/gtuber-refresh",
+      g_random_int (), g_random_int ());
+  event = gst_event_new_stream_start (stream_id);
+  gst_event_set_group_id (event, gst_util_group_id_next ());
+  g_free (stream_id);
+
+  gst_pad_send_event (pad, event);
+  gst_pad_send_event (pad, gst_event_new_caps (caps));
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_send_event (pad, gst_event_new_segment (&segment));
+
+  size = strlen (data);
+  buffer = gst_buffer_new_wrapped (g_memdup2 (data, size), size);
+
+  if ((success = (gst_pad_chain (pad, buffer) == GST_FLOW_OK)))
+    gst_pad_send_event (pad, gst_event_new_eos ());
+  else
+    GST_ERROR_OBJECT (self, "Demuxer did not accept refreshed manifest");
+
+  gst_object_unref (pad);
+  gst_caps_unref (caps);
+
+  return success;
+}
+
+static void
+record_fragment_statistics (GstGtuberAdaptiveBin *self,
+    const GstStructure *structure)
+{
+  guint64 size = 0;
+  GstClockTime download_time = GST_CLOCK_TIME_NONE;
+  gchar *host;
+
+  if (!gst_structure_get_uint64 (structure, "fragment-size", &size)
+      || !gst_structure_get_clock_time (structure, "fragment-download-time", &download_time))
+    return;
+
+  GST_GTUBER_BIN_LOCK (self);
+  host = g_strdup (self->throughput_host);
+  GST_GTUBER_BIN_UNLOCK (self);
+
+  if (host) {
+    gst_gtuber_throughput_add_sample (host, size, download_time);
+    g_free (host);
+  }
+}
+
 static void
 gst_gtuber_adaptive_bin_handle_message (GstBin *bin, GstMessage *message)
 {
@@ -413,6 +615,13 @@ gst_gtuber_adaptive_bin_handle_message (GstBin *bin, GstMessage *message)
     case GST_MESSAGE_STREAMS_SELECTED:
       link_demuxer_pads (GST_GTUBER_ADAPTIVE_BIN_CAST (bin));
       break;
+    case GST_MESSAGE_ELEMENT:{
+      const GstStructure *structure = gst_message_get_structure (message);
+
+      if (gst_structure_has_name (structure, STATISTICS_MESSAGE_NAME))
+        record_fragment_statistics (GST_GTUBER_ADAPTIVE_BIN_CAST (bin), structure);
+      break;
+    }
     default:
       break;
   }
@@ -443,6 +652,9 @@ gst_gtuber_adaptive_bin_change_state (GstElement *element, GstStateChange transi
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       gst_gtuber_adaptive_bin_playback_configure (self);
       break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_gtuber_throughput_save ();
+      break;
     default:
       break;
   }
@@ -456,6 +668,7 @@ gst_gtuber_adaptive_bin_class_init (GstGtuberAdaptiveBinClass *klass)
   GObjectClass *gobject_class = (GObjectClass *) klass;
   GstBinClass *gstbin_class = (GstBinClass *) klass;
   GstElementClass *gstelement_class = (GstElementClass *) klass;
+  GstGtuberBinClass *gtuberbin_class = (GstGtuberBinClass *) klass;
 
   GST_DEBUG_CATEGORY_INIT (gst_gtuber_adaptive_bin_debug, "gtuberadaptivebin", 0,
       "Gtuber Adaptive Bin");
@@ -465,11 +678,13 @@ gst_gtuber_adaptive_bin_class_init (GstGtuberAdaptiveBinClass *klass)
   gst_element_class_add_static_pad_template (gstelement_class, &subtitlesrc_template);
 
   gobject_class->constructed = gst_gtuber_adaptive_bin_constructed;
+  gobject_class->finalize = gst_gtuber_adaptive_bin_finalize;
   gobject_class->set_property = gst_gtuber_adaptive_bin_set_property;
   gobject_class->get_property = gst_gtuber_adaptive_bin_get_property;
 
   param_specs[PROP_INITIAL_BITRATE] = g_param_spec_uint ("initial-bitrate",
-      "Initial Bitrate", "Initial startup bitrate in kbps (0 = same as target-bitrate)",
+      "Initial Bitrate", "Initial startup bitrate in kbps when download speed "
+      "was not measured before (0 = same as target-bitrate)",
        0, G_MAXUINT, DEFAULT_INITIAL_BITRATE,
        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
@@ -483,4 +698,6 @@ gst_gtuber_adaptive_bin_class_init (GstGtuberAdaptiveBinClass *klass)
   gstbin_class->handle_message = gst_gtuber_adaptive_bin_handle_message;
 
   gstelement_class->change_state = gst_gtuber_adaptive_bin_change_state;
+
+  gtuberbin_class->refresh = gst_gtuber_adaptive_bin_refresh;
 }
@@ -52,6 +52,8 @@ struct _GstGtuberAdaptiveBin
 
   const gchar *demuxer_name;
   GstElement *demuxer;
+
+  gchar *throughput_host;
 };
 
 struct _GstGtuberAdaptiveBinClass
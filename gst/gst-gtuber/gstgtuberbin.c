@@ -30,11 +30,40 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 #define parent_class gst_gtuber_bin_parent_class
 G_DEFINE_TYPE_WITH_CODE (GstGtuberBin, gst_gtuber_bin, GST_TYPE_BIN, NULL);
 
+#define MAX_REFRESHES 3
+
+/* HTTP session context is shared only by sources within the same bin,
+ * as it carries settings (proxy, cookies, etc.) of its pipeline */
+static GstContext *
+_get_session_context (GstGtuberBin *self)
+{
+  GstContext *context = NULL;
+
+  GST_GTUBER_BIN_LOCK (self);
+  if (self->session_ctx)
+    context = gst_context_ref (self->session_ctx);
+  GST_GTUBER_BIN_UNLOCK (self);
+
+  return context;
+}
+
+static void
+_store_session_context (GstGtuberBin *self, GstContext *context)
+{
+  GST_GTUBER_BIN_LOCK (self);
+  if (self->session_ctx != context) {
+    GST_DEBUG_OBJECT (self, "Storing HTTP session context");
+    gst_context_replace (&self->session_ctx, context);
+  }
+  GST_GTUBER_BIN_UNLOCK (self);
+}
+
 static void
 gst_gtuber_bin_init (GstGtuberBin *self)
 {
   g_mutex_init (&self->bin_lock);
   g_mutex_init (&self->prop_lock);
+  g_mutex_init (&self->refresh_lock);
 }
 
 static void
@@ -51,8 +80,16 @@ gst_gtuber_bin_finalize (GObject *object)
   if (self->toc_event)
     gst_event_unref (self->toc_event);
 
+  if (self->session_ctx)
+    gst_context_unref (self->session_ctx);
+
+  /* Finished refresh thread might have been holding the last reference */
+  if (self->refresh_thread)
+    g_thread_unref (self->refresh_thread);
+
   g_mutex_clear (&self->bin_lock);
   g_mutex_clear (&self->prop_lock);
+  g_mutex_clear (&self->refresh_lock);
 
   GST_CALL_PARENT (G_OBJECT_CLASS, finalize, (object));
 }
@@ -127,6 +164,316 @@ gst_gtuber_bin_deep_element_added (GstBin *bin, GstBin *sub_bin, GstElement *chi
   }
 }
 
+static void
+gst_gtuber_bin_set_context (GstElement *element, GstContext *context)
+{
+  if (gst_context_has_context_type (context, GST_GTUBER_SOUP_SESSION_CONTEXT))
+    _store_session_context (GST_GTUBER_BIN_CAST (element), context);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+static gboolean
+is_error_expired_uri (GstMessage *message)
+{
+  GError *error = NULL;
+  const GstStructure *details = NULL;
+  guint status_code = 0;
+  gboolean expired;
+
+  gst_message_parse_error (message, &error, NULL);
+  gst_message_parse_error_details (message, &details);
+
+  if (details)
+    gst_structure_get_uint (details, "http-status-code", &status_code);
+
+  /* Signed stream URIs are rejected with "403 Forbidden" after they expire.
+   * Do not look into debug string, it contains the whole request URI */
+  expired = (status_code == 403
+      || g_error_matches (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_NOT_AUTHORIZED));
+
+  g_error_free (error);
+
+  return expired;
+}
+
+static GstElement *
+obtain_top_level_element (GstGtuberBin *self)
+{
+  GstObject *object, *parent;
+
+  object = gst_object_ref (GST_OBJECT_CAST (self));
+
+  while ((parent = gst_object_get_parent (object))) {
+    gst_object_unref (object);
+    object = parent;
+  }
+
+  return GST_ELEMENT_CAST (object);
+}
+
+static gboolean
+gst_gtuber_bin_is_stopping (GstGtuberBin *self)
+{
+  gboolean stopping;
+
+  GST_GTUBER_BIN_LOCK (self);
+  stopping = self->stopping;
+  GST_GTUBER_BIN_UNLOCK (self);
+
+  return stopping;
+}
+
+/* Our direct child that is or contains the message source */
+static GstObject *
+obtain_message_child (GstGtuberBin *self, GstMessage *message)
+{
+  GstObject *object, *parent;
+
+  if (!GST_MESSAGE_SRC (message))
+    return NULL;
+
+  object = gst_object_ref (GST_MESSAGE_SRC (message));
+
+  while ((parent = gst_object_get_parent (object))) {
+    if (parent == GST_OBJECT_CAST (self)) {
+      gst_object_unref (parent);
+      return object;
+    }
+    gst_object_unref (object);
+    object = parent;
+  }
+  gst_object_unref (object);
+
+  return NULL;
+}
+
+static void
+seek_back_cb (GstElement *top, gint64 *position)
+{
+  GST_DEBUG_OBJECT (top, "Seeking back to position before error");
+
+  gst_element_seek_simple (top, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, *position);
+}
+
+typedef struct
+{
+  GstGtuberBin *bin;
+  GstMessage *error_msg;
+} GstGtuberRefreshData;
+
+static gpointer
+refresh_thread_func (GstGtuberRefreshData *data)
+{
+  GstGtuberBin *self = data->bin;
+  GstGtuberBinClass *bin_class = GST_GTUBER_BIN_GET_CLASS (self);
+  GstElement *top;
+  GstQuery *query;
+  GstPad *sink_pad;
+  const gchar *new_data = NULL;
+  gint64 position = -1;
+  gboolean refreshed = FALSE;
+
+  top = obtain_top_level_element (self);
+
+  if (!gst_element_query_position (top, GST_FORMAT_TIME, &position))
+    position = -1;
+
+  GST_INFO_OBJECT (self, "Refreshing expired stream at position: %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (position));
+
+  query = gst_query_new_custom (GST_QUERY_CUSTOM,
+      gst_structure_new_empty (GST_GTUBER_REFRESH_QUERY));
+  sink_pad = gst_element_get_static_pad (GST_ELEMENT_CAST (self), "sink");
+
+  if (gst_pad_peer_query (sink_pad, query))
+    new_data = gst_structure_get_string (gst_query_get_structure (query), "data");
+
+  gst_object_unref (sink_pad);
+
+  /* Bin waits for this lock before stopping, so refresh
+   * does not touch children while they are being stopped */
+  if (new_data) {
+    g_mutex_lock (&self->refresh_lock);
+
+    if (!gst_gtuber_bin_is_stopping (self))
+      refreshed = bin_class->refresh (self, new_data);
+
+    g_mutex_unlock (&self->refresh_lock);
+  }
+
+  gst_query_unref (query);
+
+  /* Seeking takes state lock of top element, which application might be
+   * holding while waiting for us to finish, so do it from another thread */
+  if (refreshed && position >= 0 && !gst_gtuber_bin_is_stopping (self)) {
+    gint64 *seek_position = g_new (gint64, 1);
+
+    *seek_position = position;
+    gst_element_call_async (top, (GstElementCallAsyncFunc) seek_back_cb,
+        seek_position, (GDestroyNotify) g_free);
+  }
+
+  gst_object_unref (top);
+
+  GST_GTUBER_BIN_LOCK (self);
+  self->refreshing = FALSE;
+  gst_clear_object (&self->refresh_child);
+  GST_GTUBER_BIN_UNLOCK (self);
+
+  if (refreshed) {
+    GST_INFO_OBJECT (self, "Stream refreshed");
+    gst_message_unref (data->error_msg);
+  } else {
+    GST_WARNING_OBJECT (self, "Could not refresh stream");
+
+    /* Let the original error through after all */
+    GST_BIN_CLASS (parent_class)->handle_message (GST_BIN_CAST (self),
+        data->error_msg);
+  }
+
+  gst_object_unref (self);
+  g_free (data);
+
+  return NULL;
+}
+
+/* Takes ownership of message when returning %TRUE */
+static gboolean
+gst_gtuber_bin_try_refresh (GstGtuberBin *self, GstMessage *message)
+{
+  GstGtuberBinClass *bin_class = GST_GTUBER_BIN_GET_CLASS (self);
+  GstGtuberRefreshData *data;
+  GstObject *child;
+  GThread *prev_thread;
+  gboolean expired;
+
+  if (!bin_class->refresh)
+    return FALSE;
+
+  expired = is_error_expired_uri (message);
+  child = obtain_message_child (self, message);
+
+  GST_GTUBER_BIN_LOCK (self);
+
+  /* Source keeps posting errors after the one that started refresh
+   * (e.g. "Internal data stream error"), so hold all of them back */
+  if (self->refreshing) {
+    gboolean dropped = (child && child == self->refresh_child);
+
+    GST_GTUBER_BIN_UNLOCK (self);
+    gst_clear_object (&child);
+
+    if (dropped) {
+      GST_DEBUG_OBJECT (self, "Dropping error posted during refresh");
+      gst_message_unref (message);
+    }
+
+    return dropped;
+  }
+  if (!expired || self->stopping || self->n_refreshes >= MAX_REFRESHES) {
+    GST_GTUBER_BIN_UNLOCK (self);
+    gst_clear_object (&child);
+
+    return FALSE;
+  }
+
+  self->refreshing = TRUE;
+  self->n_refreshes++;
+  self->refresh_child = child;
+
+  /* Keep original error in case refresh does not work out */
+  data = g_new (GstGtuberRefreshData, 1);
+  data->bin = gst_object_ref (self);
+  data->error_msg = message;
+
+  /* Only one refresh at a time, so previous thread is done already */
+  prev_thread = self->refresh_thread;
+
+  /* Refreshing blocks on network, do not stall the posting thread */
+  self->refresh_thread = g_thread_new ("GstGtuberRefresh",
+      (GThreadFunc) refresh_thread_func, data);
+
+  GST_GTUBER_BIN_UNLOCK (self);
+
+  if (prev_thread)
+    g_thread_join (prev_thread);
+
+  return TRUE;
+}
+
+static void
+gst_gtuber_bin_join_refresh (GstGtuberBin *self)
+{
+  GThread *thread;
+
+  GST_GTUBER_BIN_LOCK (self);
+  thread = self->refresh_thread;
+  self->refresh_thread = NULL;
+  GST_GTUBER_BIN_UNLOCK (self);
+
+  if (!thread)
+    return;
+
+  /* Stopped from within refresh thread, e.g. by error it let through */
+  if (thread == g_thread_self ()) {
+    g_thread_unref (thread);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (self, "Waiting for refresh thread");
+  g_thread_join (thread);
+}
+
+static void
+gst_gtuber_bin_handle_message (GstBin *bin, GstMessage *message)
+{
+  GstGtuberBin *self = GST_GTUBER_BIN_CAST (bin);
+
+  switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_ERROR:
+      if (gst_gtuber_bin_try_refresh (self, message))
+        return;
+      break;
+    case GST_MESSAGE_NEED_CONTEXT:{
+      const gchar *context_type = NULL;
+      GstContext *context;
+
+      if (!gst_message_parse_context_type (message, &context_type)
+          || !g_str_equal (context_type, GST_GTUBER_SOUP_SESSION_CONTEXT))
+        break;
+
+      /* Answer directly, without asking the application */
+      if ((context = _get_session_context (self))) {
+        GST_DEBUG_OBJECT (self, "Providing HTTP session context");
+        gst_element_set_context (GST_ELEMENT_CAST (GST_MESSAGE_SRC (message)),
+            context);
+        gst_context_unref (context);
+        gst_message_unref (message);
+
+        return;
+      }
+      break;
+    }
+    case GST_MESSAGE_HAVE_CONTEXT:{
+      GstContext *context = NULL;
+
+      gst_message_parse_have_context (message, &context);
+
+      if (gst_context_has_context_type (context, GST_GTUBER_SOUP_SESSION_CONTEXT))
+        _store_session_context (self, context);
+
+      gst_context_unref (context);
+      break;
+    }
+    default:
+      break;
+  }
+
+  GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+}
+
 static void
 gst_gtuber_bin_push_event (GstGtuberBin *self, GstEvent *event)
 {
@@ -199,6 +546,51 @@ remove_sometimes_pad_cb (GstElement *element, GstPad *pad, gpointer user_data)
   return TRUE;
 }
 
+static GstPadProbeReturn
+startup_buffer_probe_cb (GstPad *pad, GstPadProbeInfo *info, GstGtuberBin *self)
+{
+  GstStructure *stats;
+  GstClockTime start_time;
+  gchar *pad_name;
+
+  /* Only the very first buffer from any of our pads counts. Src pads
+   * are removed when stopping, so new probes are added on next start */
+  if (!g_atomic_int_compare_and_exchange (&self->startup_pending, TRUE, FALSE))
+    return GST_PAD_PROBE_REMOVE;
+
+  GST_GTUBER_BIN_LOCK (self);
+  start_time = self->start_time;
+  GST_GTUBER_BIN_UNLOCK (self);
+
+  pad_name = gst_object_get_name (GST_OBJECT_CAST (pad));
+
+  stats = gst_structure_new (GST_GTUBER_STARTUP_STATS,
+      "startup-duration", G_TYPE_UINT64, gst_util_get_timestamp () - start_time,
+      "pad", G_TYPE_STRING, pad_name,
+      NULL);
+  g_free (pad_name);
+
+  GST_DEBUG_OBJECT (self, "Posting statistics: %" GST_PTR_FORMAT, stats);
+
+  gst_element_post_message (GST_ELEMENT_CAST (self),
+      gst_message_new_element (GST_OBJECT_CAST (self), stats));
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+static void
+gst_gtuber_bin_pad_added (GstElement *element, GstPad *pad)
+{
+  if (GST_PAD_IS_SRC (pad)) {
+    gst_pad_add_probe (pad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+        (GstPadProbeCallback) startup_buffer_probe_cb, element, NULL);
+  }
+
+  if (GST_ELEMENT_CLASS (parent_class)->pad_added)
+    GST_ELEMENT_CLASS (parent_class)->pad_added (element, pad);
+}
+
 static void
 gst_gtuber_bin_reset (GstGtuberBin *self)
 {
@@ -223,8 +615,42 @@ gst_gtuber_bin_reset (GstGtuberBin *self)
 static GstStateChangeReturn
 gst_gtuber_bin_change_state (GstElement *element, GstStateChange transition)
 {
+  GstGtuberBin *self = GST_GTUBER_BIN_CAST (element);
   GstStateChangeReturn ret;
 
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      GST_GTUBER_BIN_LOCK (self);
+      self->stopping = FALSE;
+      self->n_refreshes = 0;
+      self->start_time = gst_util_get_timestamp ();
+      GST_GTUBER_BIN_UNLOCK (self);
+
+      g_atomic_int_set (&self->startup_pending, TRUE);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* Tell ongoing refresh to not touch anything */
+      GST_GTUBER_BIN_LOCK (self);
+      self->stopping = TRUE;
+      GST_GTUBER_BIN_UNLOCK (self);
+
+      /* Wait until refresh that already started is done */
+      g_mutex_lock (&self->refresh_lock);
+      g_mutex_unlock (&self->refresh_lock);
+      break;
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      /* Upstream is stopped too by now, so refresh query returns quickly */
+      gst_gtuber_bin_join_refresh (self);
+
+      /* Pipeline settings might change before next use */
+      GST_GTUBER_BIN_LOCK (self);
+      gst_context_replace (&self->session_ctx, NULL);
+      GST_GTUBER_BIN_UNLOCK (self);
+      break;
+    default:
+      break;
+  }
+
   ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
   if (ret == GST_STATE_CHANGE_FAILURE)
     return ret;
@@ -301,5 +727,8 @@ gst_gtuber_bin_class_init (GstGtuberBinClass *klass)
 
   gobject_class->finalize = gst_gtuber_bin_finalize;
   gstbin_class->deep_element_added = gst_gtuber_bin_deep_element_added;
+  gstbin_class->handle_message = gst_gtuber_bin_handle_message;
   gstelement_class->change_state = gst_gtuber_bin_change_state;
+  gstelement_class->set_context = gst_gtuber_bin_set_context;
+  gstelement_class->pad_added = gst_gtuber_bin_pad_added;
 }
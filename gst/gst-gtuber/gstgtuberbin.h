@@ -58,11 +58,29 @@ struct _GstGtuberBin
 
   GstEvent *tag_event;
   GstEvent *toc_event;
+
+  GstContext *session_ctx;
+
+  GMutex refresh_lock;
+  GThread *refresh_thread;
+  GstObject *refresh_child;
+
+  gboolean refreshing;
+  gboolean stopping;
+  guint n_refreshes;
+
+  GstClockTime start_time;
+  gint startup_pending;
 };
 
 struct _GstGtuberBinClass
 {
   GstBinClass parent_class;
+
+  /* Called from a refresh thread with new data from upstream
+   * (URI or manifest), to be used instead of expired one.
+   * Bin does not start stopping until it returns */
+  gboolean (* refresh) (GstGtuberBin *bin, const gchar *data);
 };
 
 GType gst_gtuber_bin_get_type (void);
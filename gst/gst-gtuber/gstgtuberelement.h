@@ -25,9 +25,18 @@
 #define GST_GTUBER_REQ_HEADERS "request-headers"
 #define GST_GTUBER_HEADER_UA   "User-Agent"
 
+#define GST_GTUBER_SOUP_SESSION_CONTEXT "gst.soup.session"
+
+#define GST_GTUBER_REFRESH_QUERY "gtuber-refresh"
+
+/* Names of statistics element messages */
+#define GST_GTUBER_RESOLVE_STATS "gtuber-resolve-statistics"
+#define GST_GTUBER_STARTUP_STATS "gtuber-startup-statistics"
+
 G_BEGIN_DECLS
 
 GST_ELEMENT_REGISTER_DECLARE (gtubersrc);
+GST_ELEMENT_REGISTER_DECLARE (gtuberrangesrc);
 GST_ELEMENT_REGISTER_DECLARE (gtuberuridemux);
 GST_ELEMENT_REGISTER_DECLARE (gtuberdashdemux);
 GST_ELEMENT_REGISTER_DECLARE (gtuberhlsdemux);
@@ -0,0 +1,534 @@
+/*
+ * Copyright (C) 2021 Rafał Dzięgiel <rafostar.github@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Media info fetching shared by all gtuber elements within the process.
+ *
+ * A single GtuberClient is used together with a bounded pool of persistent
+ * worker threads, so creating many elements does not spawn a thread per fetch.
+ * Each worker keeps its own main context and HTTP session across fetches,
+ * reusing already established connections (and TLS sessions) to websites.
+ * Concurrent requests for the same URI are coalesced into one job and
+ * successful results are kept for a short while, making re-prerolling
+ * of the same URI instant.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstgtuberfetch.h"
+
+#define GST_CAT_DEFAULT gst_gtuber_fetch_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define FETCH_MAX_WORKERS 4
+#define CACHE_MAX_ENTRIES 32
+#define CACHE_TTL_SECONDS 300
+
+/* Set on media info once its fetch was claimed by a caller */
+#define FETCH_CLAIMED_KEY "gst-gtuber-fetch-claimed"
+
+typedef struct
+{
+  gint ref_count;
+
+  gchar *uri;
+  GCancellable *cancellable;
+  guint n_waiters;
+
+  /* Set when job prefetches segment indexes of this info instead */
+  GtuberMediaInfo *index_info;
+  GtuberAdaptiveStreamFilter index_filter;
+  gpointer index_filter_data;
+
+  gboolean done;
+  GtuberMediaInfo *info;
+  GError *error;
+} GstGtuberFetchJob;
+
+typedef struct
+{
+  GtuberMediaInfo *info;
+  gint64 expires;
+} GstGtuberCacheEntry;
+
+typedef struct
+{
+  GMainContext *context;
+  SoupSession *session;
+} GstGtuberFetchWorker;
+
+static void gst_gtuber_fetch_worker_free (GstGtuberFetchWorker *worker);
+
+static GMutex fetch_lock;
+static GCond fetch_cond;
+
+static GtuberClient *client = NULL;
+static GThreadPool *pool = NULL;
+
+/* Per worker thread state */
+static GPrivate worker_private = G_PRIVATE_INIT ((GDestroyNotify) gst_gtuber_fetch_worker_free);
+
+/* URI -> GstGtuberFetchJob (in progress) */
+static GHashTable *jobs = NULL;
+/* URI -> GstGtuberCacheEntry */
+static GHashTable *cache = NULL;
+
+static GstGtuberFetchJob *
+gst_gtuber_fetch_job_new (const gchar *uri)
+{
+  GstGtuberFetchJob *job;
+
+  job = g_new (GstGtuberFetchJob, 1);
+  job->ref_count = 1;
+  job->uri = g_strdup (uri);
+  job->cancellable = g_cancellable_new ();
+  job->n_waiters = 0;
+  job->done = FALSE;
+  job->index_info = NULL;
+  job->index_filter = NULL;
+  job->index_filter_data = NULL;
+  job->info = NULL;
+  job->error = NULL;
+
+  return job;
+}
+
+static GstGtuberFetchJob *
+gst_gtuber_fetch_job_ref (GstGtuberFetchJob *job)
+{
+  g_atomic_int_inc (&job->ref_count);
+
+  return job;
+}
+
+static void
+gst_gtuber_fetch_job_unref (GstGtuberFetchJob *job)
+{
+  if (!g_atomic_int_dec_and_test (&job->ref_count))
+    return;
+
+  g_free (job->uri);
+  g_object_unref (job->cancellable);
+  g_clear_object (&job->index_info);
+  g_clear_object (&job->info);
+  g_clear_error (&job->error);
+
+  g_free (job);
+}
+
+static GstGtuberFetchWorker *
+_get_worker (void)
+{
+  GstGtuberFetchWorker *worker;
+
+  if (!(worker = g_private_get (&worker_private))) {
+    worker = g_new (GstGtuberFetchWorker, 1);
+    worker->context = g_main_context_new ();
+
+    /* Session belongs to context that is thread default
+     * during its creation, so it must be our own one */
+    g_main_context_push_thread_default (worker->context);
+    worker->session = soup_session_new_with_options (
+        "timeout", 7,
+        NULL);
+    g_main_context_pop_thread_default (worker->context);
+
+    g_private_set (&worker_private, worker);
+  }
+
+  return worker;
+}
+
+static void
+gst_gtuber_fetch_worker_free (GstGtuberFetchWorker *worker)
+{
+  g_object_unref (worker->session);
+  g_main_context_unref (worker->context);
+
+  g_free (worker);
+}
+
+static void
+gst_gtuber_cache_entry_free (GstGtuberCacheEntry *entry)
+{
+  g_object_unref (entry->info);
+  g_free (entry);
+}
+
+/* Must be called with fetch_lock held */
+static void
+_cache_insert (const gchar *uri, GtuberMediaInfo *info)
+{
+  GstGtuberCacheEntry *entry;
+  gint64 now = g_get_monotonic_time ();
+
+  /* Drop expired entries first, then the one closest to expiry if still full */
+  if (g_hash_table_size (cache) >= CACHE_MAX_ENTRIES) {
+    GHashTableIter iter;
+    gpointer key, value;
+    const gchar *oldest_key = NULL;
+    gint64 oldest_expires = G_MAXINT64;
+
+    g_hash_table_iter_init (&iter, cache);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+      GstGtuberCacheEntry *old = (GstGtuberCacheEntry *) value;
+
+      if (old->expires <= now) {
+        g_hash_table_iter_remove (&iter);
+      } else if (old->expires < oldest_expires) {
+        oldest_expires = old->expires;
+        oldest_key = (const gchar *) key;
+      }
+    }
+    if (oldest_key && g_hash_table_size (cache) >= CACHE_MAX_ENTRIES)
+      g_hash_table_remove (cache, oldest_key);
+  }
+
+  entry = g_new (GstGtuberCacheEntry, 1);
+  entry->info = g_object_ref (info);
+  entry->expires = now + CACHE_TTL_SECONDS * G_USEC_PER_SEC;
+
+  g_hash_table_insert (cache, g_strdup (uri), entry);
+}
+
+/* Must be called with fetch_lock held */
+static GtuberMediaInfo *
+_cache_lookup (const gchar *uri)
+{
+  GstGtuberCacheEntry *entry;
+
+  if (!(entry = g_hash_table_lookup (cache, uri)))
+    return NULL;
+
+  if (entry->expires <= g_get_monotonic_time ()) {
+    GST_DEBUG ("Cached media info expired for URI: %s", uri);
+    g_hash_table_remove (cache, uri);
+
+    return NULL;
+  }
+
+  return g_object_ref (entry->info);
+}
+
+/* Must be called with fetch_lock held. Returns %TRUE only for the first
+ * caller, so statistics of a single fetch are not reported repeatedly
+ * when its result is shared or served from cache */
+static gboolean
+_claim_fetch (GtuberMediaInfo *info)
+{
+  if (g_object_get_data (G_OBJECT (info), FETCH_CLAIMED_KEY))
+    return FALSE;
+
+  g_object_set_data (G_OBJECT (info), FETCH_CLAIMED_KEY, GINT_TO_POINTER (TRUE));
+
+  return TRUE;
+}
+
+/* Must be called with fetch_lock held, returns borrowed job */
+static GstGtuberFetchJob *
+_start_job (const gchar *uri)
+{
+  GstGtuberFetchJob *job;
+
+  job = gst_gtuber_fetch_job_new (uri);
+  g_hash_table_insert (jobs, job->uri, job);
+
+  /* Pool takes over our job reference */
+  g_thread_pool_push (pool, job, NULL);
+
+  return job;
+}
+
+static void
+_run_index_job (GstGtuberFetchJob *job, GstGtuberFetchWorker *worker)
+{
+  GError *error = NULL;
+
+  GST_INFO ("Prefetching segment indexes");
+
+  g_main_context_push_thread_default (worker->context);
+  gtuber_client_prefetch_segment_indexes_with_session (client, job->index_info,
+      job->index_filter, job->index_filter_data, worker->session,
+      job->cancellable, &error);
+  g_main_context_pop_thread_default (worker->context);
+
+  g_mutex_lock (&fetch_lock);
+
+  job->error = error;
+  job->done = TRUE;
+
+  g_cond_broadcast (&fetch_cond);
+  g_mutex_unlock (&fetch_lock);
+
+  gst_gtuber_fetch_job_unref (job);
+}
+
+static void
+fetch_worker_func (GstGtuberFetchJob *job, gpointer user_data G_GNUC_UNUSED)
+{
+  GstGtuberFetchWorker *worker = _get_worker ();
+  GtuberMediaInfo *info;
+  GError *error = NULL;
+
+  if (job->index_info) {
+    _run_index_job (job, worker);
+    return;
+  }
+
+  g_main_context_push_thread_default (worker->context);
+
+  GST_INFO ("Fetching media info for URI: %s", job->uri);
+  info = gtuber_client_fetch_media_info_with_session (client, job->uri,
+      worker->session, job->cancellable, &error);
+
+  g_main_context_pop_thread_default (worker->context);
+
+  g_mutex_lock (&fetch_lock);
+
+  job->info = info;
+  job->error = error;
+  job->done = TRUE;
+
+  /* Job might have been already removed and replaced when cancelled */
+  if (g_hash_table_lookup (jobs, job->uri) == job)
+    g_hash_table_remove (jobs, job->uri);
+
+  if (info)
+    _cache_insert (job->uri, info);
+
+  g_cond_broadcast (&fetch_cond);
+  g_mutex_unlock (&fetch_lock);
+
+  GST_DEBUG ("Fetch %s for URI: %s",
+      (info) ? "finished" : "failed", job->uri);
+
+  gst_gtuber_fetch_job_unref (job);
+}
+
+static void
+_cancelled_cb (GCancellable *cancellable, gpointer user_data G_GNUC_UNUSED)
+{
+  /* Wake up waiters, so they can notice cancellation */
+  g_mutex_lock (&fetch_lock);
+  g_cond_broadcast (&fetch_cond);
+  g_mutex_unlock (&fetch_lock);
+}
+
+static void
+_fetch_init (void)
+{
+  static gsize initialized = FALSE;
+
+  if (g_once_init_enter (&initialized)) {
+    GST_DEBUG_CATEGORY_INIT (gst_gtuber_fetch_debug, "gtuberfetch", 0,
+        "Gtuber media info fetch");
+
+    client = gtuber_client_new ();
+    /* Exclusive, so threads (and their sessions) are not dropped when idle */
+    pool = g_thread_pool_new ((GFunc) fetch_worker_func, NULL,
+        FETCH_MAX_WORKERS, TRUE, NULL);
+
+    jobs = g_hash_table_new (g_str_hash, g_str_equal);
+    cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+        (GDestroyNotify) g_free, (GDestroyNotify) gst_gtuber_cache_entry_free);
+
+    g_once_init_leave (&initialized, TRUE);
+  }
+}
+
+/*
+ * Blocks until media info for URI is available, either from the cache,
+ * from another ongoing fetch of the same URI or from a new fetch queued
+ * in the shared worker pool. Returns a new reference or %NULL on error.
+ *
+ * When @fetched is given, it is set to %TRUE if caller is the first one
+ * to receive result of a network fetch (and should report its statistics).
+ */
+GtuberMediaInfo *
+gst_gtuber_fetch_media_info (const gchar *uri, GCancellable *cancellable,
+    gboolean *fetched, GError **error)
+{
+  GstGtuberFetchJob *job;
+  GtuberMediaInfo *info = NULL;
+  gulong handler_id = 0;
+
+  _fetch_init ();
+
+  if (fetched)
+    *fetched = FALSE;
+
+  g_mutex_lock (&fetch_lock);
+
+  if ((info = _cache_lookup (uri))) {
+    /* Result of a prefetch is not claimed yet */
+    if (fetched)
+      *fetched = _claim_fetch (info);
+
+    g_mutex_unlock (&fetch_lock);
+    GST_DEBUG ("Using cached media info for URI: %s", uri);
+
+    return info;
+  }
+
+  if ((job = g_hash_table_lookup (jobs, uri)))
+    GST_DEBUG ("Joining ongoing fetch for URI: %s", uri);
+  else
+    job = _start_job (uri);
+
+  gst_gtuber_fetch_job_ref (job);
+  job->n_waiters++;
+
+  g_mutex_unlock (&fetch_lock);
+
+  /* Connect outside of lock, callback is invoked
+   * immediately if already cancelled */
+  if (cancellable) {
+    handler_id = g_cancellable_connect (cancellable,
+        G_CALLBACK (_cancelled_cb), NULL, NULL);
+  }
+
+  g_mutex_lock (&fetch_lock);
+
+  while (!job->done && !g_cancellable_is_cancelled (cancellable))
+    g_cond_wait (&fetch_cond, &fetch_lock);
+
+  job->n_waiters--;
+
+  if (job->done) {
+    if (job->info) {
+      info = g_object_ref (job->info);
+
+      if (fetched)
+        *fetched = _claim_fetch (info);
+    } else {
+      g_propagate_error (error, g_error_copy (job->error));
+    }
+  } else {
+    /* Nobody else is interested in result anymore */
+    if (job->n_waiters == 0) {
+      GST_DEBUG ("Cancelling fetch for URI: %s", uri);
+
+      if (g_hash_table_lookup (jobs, job->uri) == job)
+        g_hash_table_remove (jobs, job->uri);
+
+      g_cancellable_cancel (job->cancellable);
+    }
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+        "Media info fetch was cancelled");
+  }
+
+  g_mutex_unlock (&fetch_lock);
+
+  if (handler_id)
+    g_cancellable_disconnect (cancellable, handler_id);
+
+  gst_gtuber_fetch_job_unref (job);
+
+  return info;
+}
+
+/*
+ * Starts fetching media info for URI in the background, so
+ * a later gst_gtuber_fetch_media_info() call can either join
+ * the fetch already in flight or use its cached result.
+ */
+void
+gst_gtuber_prefetch_media_info (const gchar *uri)
+{
+  GtuberMediaInfo *info;
+
+  _fetch_init ();
+
+  g_mutex_lock (&fetch_lock);
+
+  if ((info = _cache_lookup (uri))) {
+    g_object_unref (info);
+  } else if (!g_hash_table_contains (jobs, uri)) {
+    GST_DEBUG ("Prefetching media info for URI: %s", uri);
+    _start_job (uri);
+  }
+
+  g_mutex_unlock (&fetch_lock);
+}
+
+/*
+ * Prefetches segment indexes of adaptive streams within info (these
+ * that pass filter) on a worker of the shared pool, reusing its already
+ * established connections. Blocks until done, as filter is called from
+ * the worker. Returns %FALSE when cancelled.
+ */
+gboolean
+gst_gtuber_fetch_segment_indexes (GtuberMediaInfo *info,
+    GtuberAdaptiveStreamFilter filter, gpointer user_data,
+    GCancellable *cancellable, GError **error)
+{
+  GstGtuberFetchJob *job;
+  gboolean success;
+
+  _fetch_init ();
+
+  job = gst_gtuber_fetch_job_new (NULL);
+  job->index_info = g_object_ref (info);
+  job->index_filter = filter;
+  job->index_filter_data = user_data;
+
+  if (cancellable) {
+    g_object_unref (job->cancellable);
+    job->cancellable = g_object_ref (cancellable);
+  }
+
+  g_mutex_lock (&fetch_lock);
+
+  /* Pool takes over one of our job references */
+  g_thread_pool_push (pool, gst_gtuber_fetch_job_ref (job), NULL);
+
+  /* Wait even when cancelled, worker still uses filter data */
+  while (!job->done)
+    g_cond_wait (&fetch_cond, &fetch_lock);
+
+  if ((success = (job->error == NULL)))
+    GST_DEBUG ("Segment indexes prefetched");
+  else
+    g_propagate_error (error, g_error_copy (job->error));
+
+  g_mutex_unlock (&fetch_lock);
+
+  gst_gtuber_fetch_job_unref (job);
+
+  return success;
+}
+
+/*
+ * Drops cached media info of URI, so the next fetch obtains it again
+ * (e.g. when stream URIs within cached one already expired).
+ */
+void
+gst_gtuber_fetch_invalidate (const gchar *uri)
+{
+  _fetch_init ();
+
+  g_mutex_lock (&fetch_lock);
+
+  if (g_hash_table_remove (cache, uri))
+    GST_DEBUG ("Invalidated cached media info for URI: %s", uri);
+
+  g_mutex_unlock (&fetch_lock);
+}
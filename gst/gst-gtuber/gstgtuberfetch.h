@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2021 Rafał Dzięgiel <rafostar.github@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <gst/gst.h>
+#include <gtuber/gtuber.h>
+
+G_BEGIN_DECLS
+
+GtuberMediaInfo * gst_gtuber_fetch_media_info (const gchar *uri, GCancellable *cancellable, gboolean *fetched, GError **error);
+
+void              gst_gtuber_prefetch_media_info (const gchar *uri);
+
+gboolean          gst_gtuber_fetch_segment_indexes (GtuberMediaInfo *info, GtuberAdaptiveStreamFilter filter, gpointer user_data,
+                                                    GCancellable *cancellable, GError **error);
+
+void              gst_gtuber_fetch_invalidate (const gchar *uri);
+
+G_END_DECLS
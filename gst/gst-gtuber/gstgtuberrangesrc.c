@@ -0,0 +1,1013 @@
+/*
+ * Copyright (C) 2021 Rafał Dzięgiel <rafostar.github@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Source that downloads a single HTTP URI over multiple concurrent
+ * range requests. Some hosts throttle each connection separately,
+ * so splitting the download lets it reach the actual link speed.
+ *
+ * Chunks are downloaded by worker threads into a bounded ring and
+ * pushed downstream strictly in order.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstgtuberrangesrc.h"
+#include "gstgtuberelement.h"
+
+#define GST_CAT_DEFAULT gst_gtuber_range_src_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define DEFAULT_CONNECTIONS 4
+#define DEFAULT_CHUNK_SIZE  (1024 * 1024)
+#define DEFAULT_USER_AGENT  "GStreamer gtuberrangesrc " VERSION " "
+
+/* Each connection can have this many chunks downloaded ahead */
+#define SLOTS_PER_CONNECTION 2
+
+#define UNKNOWN_SIZE G_MAXUINT64
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_CONNECTIONS,
+  PROP_CHUNK_SIZE,
+  PROP_USER_AGENT,
+  PROP_EXTRA_HEADERS,
+  PROP_LAST
+};
+
+static GParamSpec *param_specs[PROP_LAST] = { NULL, };
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static void gst_gtuber_range_src_uri_handler_init (gpointer g_iface, gpointer iface_data);
+
+#define parent_class gst_gtuber_range_src_parent_class
+G_DEFINE_TYPE_WITH_CODE (GstGtuberRangeSrc, gst_gtuber_range_src,
+    GST_TYPE_PUSH_SRC, G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER,
+        gst_gtuber_range_src_uri_handler_init));
+GST_ELEMENT_REGISTER_DEFINE_WITH_CODE (gtuberrangesrc, "gtuberrangesrc",
+    GST_RANK_NONE, GST_TYPE_GTUBER_RANGE_SRC, gst_gtuber_element_init (plugin));
+
+static gboolean
+gst_gtuber_range_src_set_location (GstGtuberRangeSrc *self, const gchar *location,
+    GError **error)
+{
+  GstElement *element = GST_ELEMENT (self);
+
+  if (GST_STATE (element) == GST_STATE_PLAYING ||
+      GST_STATE (element) == GST_STATE_PAUSED) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_STATE,
+        "Cannot change location property while element is running");
+    return FALSE;
+  }
+  if (location && !gst_uri_has_protocol (location, "http")
+      && !gst_uri_has_protocol (location, "https")) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_UNSUPPORTED_PROTOCOL,
+        "Location URI protocol is not supported");
+    return FALSE;
+  }
+
+  g_mutex_lock (&self->prop_lock);
+
+  g_free (self->location);
+  self->location = g_strdup (location);
+  GST_DEBUG_OBJECT (self, "Location changed to: %s", self->location);
+
+  g_mutex_unlock (&self->prop_lock);
+
+  return TRUE;
+}
+
+static gboolean
+append_header_cb (GQuark field_id, const GValue *value, SoupMessageHeaders *headers)
+{
+  const gchar *name = g_quark_to_string (field_id);
+
+  if (G_VALUE_HOLDS_STRING (value)) {
+    soup_message_headers_append (headers, name, g_value_get_string (value));
+  } else {
+    GValue str_value = G_VALUE_INIT;
+
+    g_value_init (&str_value, G_TYPE_STRING);
+
+    if (g_value_transform (value, &str_value))
+      soup_message_headers_append (headers, name, g_value_get_string (&str_value));
+    else
+      GST_WARNING ("Could not convert header \"%s\" value to string", name);
+
+    g_value_unset (&str_value);
+  }
+
+  return TRUE;
+}
+
+/* Cancellable is replaced after flushing */
+static GCancellable *
+gst_gtuber_range_src_ref_cancellable (GstGtuberRangeSrc *self)
+{
+  GCancellable *cancellable;
+
+  g_mutex_lock (&self->lock);
+  cancellable = g_object_ref (self->cancellable);
+  g_mutex_unlock (&self->lock);
+
+  return cancellable;
+}
+
+/* Range end is inclusive, pass -1 as start to request whole resource */
+static GInputStream *
+_send_request (GstGtuberRangeSrc *self, goffset start, goffset end,
+    SoupMessage **out_msg, guint *status, GError **error)
+{
+  SoupMessage *msg;
+  SoupMessageHeaders *headers;
+  GInputStream *stream;
+  GCancellable *cancellable;
+  gchar *location;
+
+  *status = 0;
+
+  g_mutex_lock (&self->prop_lock);
+  location = g_strdup (self->location);
+  g_mutex_unlock (&self->prop_lock);
+
+  msg = (location) ? soup_message_new ("GET", location) : NULL;
+  g_free (location);
+
+  if (!msg) {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_OPEN_READ,
+        "Invalid or missing location");
+    return NULL;
+  }
+
+  headers = soup_message_get_request_headers (msg);
+
+  if (start >= 0)
+    soup_message_headers_set_range (headers, start, end);
+
+  g_mutex_lock (&self->prop_lock);
+  /* Session might be shared, so set it per message */
+  if (self->user_agent)
+    soup_message_headers_replace (headers, "User-Agent", self->user_agent);
+  if (self->extra_headers) {
+    gst_structure_foreach (self->extra_headers,
+        (GstStructureForeachFunc) append_header_cb, headers);
+  }
+  g_mutex_unlock (&self->prop_lock);
+
+  cancellable = gst_gtuber_range_src_ref_cancellable (self);
+  stream = soup_session_send (self->session, msg, cancellable, error);
+  *status = soup_message_get_status (msg);
+  g_object_unref (cancellable);
+
+  if (stream && !SOUP_STATUS_IS_SUCCESSFUL (*status)) {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "HTTP request failed: %u %s", *status,
+        soup_message_get_reason_phrase (msg));
+    g_input_stream_close (stream, NULL, NULL);
+    g_clear_object (&stream);
+  }
+
+  if (stream && out_msg)
+    *out_msg = g_object_ref (msg);
+
+  g_object_unref (msg);
+
+  return stream;
+}
+
+static GstBuffer *
+_download_range (GstGtuberRangeSrc *self, guint64 start, guint64 end,
+    guint *status, GError **error)
+{
+  GInputStream *stream;
+  GCancellable *cancellable;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gsize expected, n_read = 0;
+  gboolean success;
+
+  if (!(stream = _send_request (self, start, end, NULL, status, error)))
+    return NULL;
+
+  /* Server ignoring range would send us data from the beginning */
+  if (*status != SOUP_STATUS_PARTIAL_CONTENT) {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "Server did not respond with a requested range");
+    g_input_stream_close (stream, NULL, NULL);
+    g_object_unref (stream);
+
+    return NULL;
+  }
+
+  expected = end - start + 1;
+  buffer = gst_buffer_new_allocate (NULL, expected, NULL);
+
+  cancellable = gst_gtuber_range_src_ref_cancellable (self);
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  success = g_input_stream_read_all (stream, map.data, expected,
+      &n_read, cancellable, error);
+  gst_buffer_unmap (buffer, &map);
+
+  g_object_unref (cancellable);
+
+  g_input_stream_close (stream, NULL, NULL);
+  g_object_unref (stream);
+
+  if (success && n_read != expected) {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "Received %" G_GSIZE_FORMAT " bytes instead of %" G_GSIZE_FORMAT,
+        n_read, expected);
+    success = FALSE;
+  }
+
+  if (!success) {
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+
+  GST_BUFFER_OFFSET (buffer) = start;
+  GST_BUFFER_OFFSET_END (buffer) = end + 1;
+
+  GST_LOG_OBJECT (self, "Downloaded range %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT,
+      start, end);
+
+  return buffer;
+}
+
+static gpointer
+worker_thread_func (GstGtuberRangeSrc *self)
+{
+  while (TRUE) {
+    GstBuffer *buffer;
+    GError *error = NULL;
+    guint64 chunk, start, end;
+    guint status = 0;
+    gboolean cancelled;
+
+    g_mutex_lock (&self->lock);
+
+    /* Wait until there is free space in ring */
+    while (!self->shutdown && !self->error
+        && self->next_chunk - self->read_chunk >= self->n_slots)
+      g_cond_wait (&self->cond, &self->lock);
+
+    start = self->base_offset + self->next_chunk * self->slot_size;
+
+    if (self->shutdown || self->error || start >= self->size) {
+      g_mutex_unlock (&self->lock);
+      break;
+    }
+
+    chunk = self->next_chunk++;
+    end = MIN (start + self->slot_size, self->size) - 1;
+
+    g_mutex_unlock (&self->lock);
+
+    buffer = _download_range (self, start, end, &status, &error);
+
+    g_mutex_lock (&self->lock);
+
+    /* Also cancelled on flush, workers are restarted afterwards */
+    cancelled = (self->shutdown
+        || g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED));
+
+    if (cancelled) {
+      if (buffer)
+        gst_buffer_unref (buffer);
+    } else if (buffer) {
+      self->slots[chunk % self->n_slots] = buffer;
+    } else if (!self->error) {
+      GST_DEBUG_OBJECT (self, "Chunk %" G_GUINT64_FORMAT " download failed: %s",
+          chunk, error->message);
+
+      self->error = g_steal_pointer (&error);
+      self->error_status = status;
+    }
+
+    g_cond_broadcast (&self->cond);
+    g_mutex_unlock (&self->lock);
+
+    g_clear_error (&error);
+
+    if (cancelled)
+      break;
+  }
+
+  return NULL;
+}
+
+static void
+gst_gtuber_range_src_clear_slots (GstGtuberRangeSrc *self)
+{
+  guint i;
+
+  for (i = 0; i < self->n_slots; i++) {
+    if (self->slots[i])
+      gst_buffer_replace (&self->slots[i], NULL);
+  }
+}
+
+static void
+gst_gtuber_range_src_start_workers (GstGtuberRangeSrc *self)
+{
+  guint i;
+
+  self->shutdown = FALSE;
+
+  for (i = 0; i < self->n_workers; i++) {
+    self->workers[i] = g_thread_new ("GstGtuberRange",
+        (GThreadFunc) worker_thread_func, self);
+  }
+
+  GST_DEBUG_OBJECT (self, "Started %u download workers", self->n_workers);
+}
+
+static void
+gst_gtuber_range_src_stop_workers (GstGtuberRangeSrc *self)
+{
+  guint i;
+
+  g_mutex_lock (&self->lock);
+  self->shutdown = TRUE;
+  g_cancellable_cancel (self->cancellable);
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  for (i = 0; i < self->n_workers; i++) {
+    if (self->workers[i]) {
+      g_thread_join (self->workers[i]);
+      self->workers[i] = NULL;
+    }
+  }
+
+  /* No worker uses it anymore */
+  g_mutex_lock (&self->lock);
+  g_object_unref (self->cancellable);
+  self->cancellable = g_cancellable_new ();
+  g_mutex_unlock (&self->lock);
+}
+
+/* Drops downloaded chunks and restarts downloading from given offset */
+static void
+gst_gtuber_range_src_restart_workers (GstGtuberRangeSrc *self, guint64 offset)
+{
+  gst_gtuber_range_src_stop_workers (self);
+
+  g_mutex_lock (&self->lock);
+
+  gst_gtuber_range_src_clear_slots (self);
+  g_clear_error (&self->error);
+
+  self->base_offset = offset;
+  self->next_chunk = 0;
+  self->read_chunk = 0;
+
+  g_mutex_unlock (&self->lock);
+
+  gst_gtuber_range_src_start_workers (self);
+}
+
+static void
+gst_gtuber_range_src_post_error (GstGtuberRangeSrc *self, const GError *error,
+    guint status)
+{
+  if (status == SOUP_STATUS_UNAUTHORIZED || status == SOUP_STATUS_FORBIDDEN) {
+    GST_ELEMENT_ERROR_WITH_DETAILS (self, RESOURCE, NOT_AUTHORIZED,
+        ("%s", error->message), (NULL),
+        ("http-status-code", G_TYPE_UINT, status, NULL));
+  } else if (status == SOUP_STATUS_NOT_FOUND) {
+    GST_ELEMENT_ERROR_WITH_DETAILS (self, RESOURCE, NOT_FOUND,
+        ("%s", error->message), (NULL),
+        ("http-status-code", G_TYPE_UINT, status, NULL));
+  } else {
+    GST_ELEMENT_ERROR_WITH_DETAILS (self, RESOURCE, READ,
+        ("%s", error->message), (NULL),
+        ("http-status-code", G_TYPE_UINT, status, NULL));
+  }
+}
+
+static void
+gst_gtuber_range_src_query_session_context (GstGtuberRangeSrc *self)
+{
+  GstElement *element = GST_ELEMENT_CAST (self);
+  GstQuery *query;
+
+  query = gst_query_new_context (GST_GTUBER_SOUP_SESSION_CONTEXT);
+
+  if (gst_pad_peer_query (GST_BASE_SRC_PAD (self), query)) {
+    GstContext *context = NULL;
+
+    gst_query_parse_context (query, &context);
+    gst_element_set_context (element, context);
+  } else {
+    GstMessage *message;
+
+    /* Parent gtuber bin answers this one directly */
+    message = gst_message_new_need_context (GST_OBJECT_CAST (self),
+        GST_GTUBER_SOUP_SESSION_CONTEXT);
+    gst_element_post_message (element, message);
+  }
+
+  gst_query_unref (query);
+}
+
+static gboolean
+gst_gtuber_range_src_start (GstBaseSrc *base_src)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (base_src);
+  SoupMessage *msg = NULL;
+  SoupMessageHeaders *headers;
+  GInputStream *stream;
+  GError *error = NULL;
+  goffset range_start, range_end, total = -1;
+  guint status = 0;
+
+  GST_DEBUG_OBJECT (self, "Start");
+
+  gst_gtuber_range_src_query_session_context (self);
+
+  g_mutex_lock (&self->prop_lock);
+  if (self->external_session) {
+    GST_DEBUG_OBJECT (self, "Using HTTP session from context");
+    self->session = g_object_ref (self->external_session);
+  } else {
+    self->session = soup_session_new ();
+  }
+  self->n_workers = self->connections;
+  self->slot_size = self->chunk_size;
+  g_mutex_unlock (&self->prop_lock);
+
+  /* Probe with a single byte to learn size and whether ranges work */
+  if (!(stream = _send_request (self, 0, 0, &msg, &status, &error)))
+    goto fail;
+
+  headers = soup_message_get_response_headers (msg);
+
+  if (status == SOUP_STATUS_PARTIAL_CONTENT
+      && soup_message_headers_get_content_range (headers, &range_start, &range_end, &total)
+      && total > 0) {
+    g_input_stream_close (stream, NULL, NULL);
+    g_object_unref (stream);
+
+    self->size = total;
+    self->seekable = TRUE;
+  } else {
+    GST_INFO_OBJECT (self, "Server does not support ranges, "
+        "falling back to a single connection");
+
+    /* Response is a full resource already, unless range had unknown length */
+    if (status == SOUP_STATUS_PARTIAL_CONTENT) {
+      g_input_stream_close (stream, NULL, NULL);
+      g_object_unref (stream);
+      g_clear_object (&msg);
+
+      if (!(stream = _send_request (self, -1, -1, &msg, &status, &error)))
+        goto fail;
+
+      headers = soup_message_get_response_headers (msg);
+    }
+
+    total = soup_message_headers_get_content_length (headers);
+
+    self->fallback_stream = stream;
+    self->size = (total > 0) ? (guint64) total : UNKNOWN_SIZE;
+    self->seekable = FALSE;
+    self->n_workers = 0;
+  }
+
+  g_object_unref (msg);
+
+  GST_DEBUG_OBJECT (self, "Resource size: %" G_GUINT64_FORMAT ", seekable: %s",
+      self->size, (self->seekable) ? "yes" : "no");
+
+  self->workers = g_new0 (GThread *, self->n_workers);
+  self->n_slots = MAX (self->n_workers * SLOTS_PER_CONNECTION, 1);
+  self->slots = g_new0 (GstBuffer *, self->n_slots);
+
+  self->base_offset = 0;
+  self->next_chunk = 0;
+  self->read_chunk = 0;
+
+  if (self->n_workers > 0)
+    gst_gtuber_range_src_start_workers (self);
+
+  return TRUE;
+
+fail:
+  gst_gtuber_range_src_post_error (self, error, status);
+  g_clear_error (&error);
+  g_clear_object (&msg);
+  g_clear_object (&self->session);
+
+  return FALSE;
+}
+
+static gboolean
+gst_gtuber_range_src_stop (GstBaseSrc *base_src)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (base_src);
+
+  GST_DEBUG_OBJECT (self, "Stop");
+
+  if (self->workers) {
+    gst_gtuber_range_src_stop_workers (self);
+    g_clear_pointer (&self->workers, g_free);
+  }
+  if (self->slots) {
+    gst_gtuber_range_src_clear_slots (self);
+    g_clear_pointer (&self->slots, g_free);
+  }
+
+  if (self->fallback_stream) {
+    g_input_stream_close (self->fallback_stream, NULL, NULL);
+    g_clear_object (&self->fallback_stream);
+  }
+
+  g_clear_error (&self->error);
+  g_clear_object (&self->session);
+
+  /* Might have been cancelled by unlock in fallback mode */
+  if (g_cancellable_is_cancelled (self->cancellable)) {
+    g_mutex_lock (&self->lock);
+    g_object_unref (self->cancellable);
+    self->cancellable = g_cancellable_new ();
+    g_mutex_unlock (&self->lock);
+  }
+
+  self->n_workers = 0;
+  self->n_slots = 0;
+  self->size = UNKNOWN_SIZE;
+  self->seekable = FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_gtuber_range_src_do_seek (GstBaseSrc *base_src, GstSegment *segment)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (base_src);
+
+  GST_DEBUG_OBJECT (self, "Seek to: %" G_GUINT64_FORMAT, segment->start);
+
+  /* Without ranges we can only start reading from the beginning */
+  if (self->fallback_stream)
+    return (segment->start == 0 && self->read_chunk == 0);
+
+  g_mutex_lock (&self->lock);
+
+  /* Already downloaded chunks are still valid */
+  if (!self->error && !g_cancellable_is_cancelled (self->cancellable)
+      && segment->start == self->base_offset + self->read_chunk * self->slot_size) {
+    g_mutex_unlock (&self->lock);
+    return TRUE;
+  }
+
+  g_mutex_unlock (&self->lock);
+
+  gst_gtuber_range_src_restart_workers (self, segment->start);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_gtuber_range_src_create_fallback (GstGtuberRangeSrc *self, GstBuffer **outbuf)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  GCancellable *cancellable;
+  GError *error = NULL;
+  gsize n_read = 0;
+  gboolean success;
+
+  buffer = gst_buffer_new_allocate (NULL, self->slot_size, NULL);
+  cancellable = gst_gtuber_range_src_ref_cancellable (self);
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  success = g_input_stream_read_all (self->fallback_stream, map.data,
+      self->slot_size, &n_read, cancellable, &error);
+  gst_buffer_unmap (buffer, &map);
+
+  g_object_unref (cancellable);
+
+  if (!success) {
+    GstFlowReturn ret = GST_FLOW_FLUSHING;
+
+    if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      gst_gtuber_range_src_post_error (self, error, 0);
+      ret = GST_FLOW_ERROR;
+    }
+
+    g_error_free (error);
+    gst_buffer_unref (buffer);
+
+    return ret;
+  }
+
+  if (n_read == 0) {
+    gst_buffer_unref (buffer);
+    return GST_FLOW_EOS;
+  }
+
+  gst_buffer_set_size (buffer, n_read);
+
+  GST_BUFFER_OFFSET (buffer) = self->read_chunk * self->slot_size;
+  GST_BUFFER_OFFSET_END (buffer) = GST_BUFFER_OFFSET (buffer) + n_read;
+  self->read_chunk++;
+
+  *outbuf = buffer;
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_gtuber_range_src_create (GstPushSrc *push_src, GstBuffer **outbuf)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (push_src);
+  GstBuffer **slot;
+  GError *error = NULL;
+  guint error_status = 0;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (self->fallback_stream)
+    return gst_gtuber_range_src_create_fallback (self, outbuf);
+
+  g_mutex_lock (&self->lock);
+
+  slot = &self->slots[self->read_chunk % self->n_slots];
+
+  while (!self->flushing && !self->error && !*slot
+      && self->base_offset + self->read_chunk * self->slot_size < self->size)
+    g_cond_wait (&self->cond, &self->lock);
+
+  if (self->flushing) {
+    ret = GST_FLOW_FLUSHING;
+  } else if (*slot) {
+    *outbuf = *slot;
+    *slot = NULL;
+
+    self->read_chunk++;
+    g_cond_broadcast (&self->cond);
+  } else if (self->error) {
+    error = g_error_copy (self->error);
+    error_status = self->error_status;
+    ret = GST_FLOW_ERROR;
+  } else {
+    GST_DEBUG_OBJECT (self, "All chunks pushed");
+    ret = GST_FLOW_EOS;
+  }
+
+  g_mutex_unlock (&self->lock);
+
+  if (error) {
+    gst_gtuber_range_src_post_error (self, error, error_status);
+    g_error_free (error);
+  }
+
+  return ret;
+}
+
+static gboolean
+gst_gtuber_range_src_get_size (GstBaseSrc *base_src, guint64 *size)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (base_src);
+
+  if (self->size == UNKNOWN_SIZE)
+    return FALSE;
+
+  *size = self->size;
+
+  return TRUE;
+}
+
+static gboolean
+gst_gtuber_range_src_is_seekable (GstBaseSrc *base_src)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (base_src);
+
+  return self->seekable;
+}
+
+static gboolean
+gst_gtuber_range_src_unlock (GstBaseSrc *base_src)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (base_src);
+
+  GST_LOG_OBJECT (self, "Unlock");
+
+  g_mutex_lock (&self->lock);
+  self->flushing = TRUE;
+  g_cancellable_cancel (self->cancellable);
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_gtuber_range_src_unlock_stop (GstBaseSrc *base_src)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (base_src);
+
+  GST_LOG_OBJECT (self, "Unlock stop");
+
+  g_mutex_lock (&self->lock);
+  self->flushing = FALSE;
+  g_mutex_unlock (&self->lock);
+
+  if (!g_cancellable_is_cancelled (self->cancellable))
+    return TRUE;
+
+  /* Cancelled workers left some chunks undownloaded, so continue
+   * from the current position (replacing cancellable too) */
+  if (self->n_workers > 0) {
+    gst_gtuber_range_src_restart_workers (self,
+        self->base_offset + self->read_chunk * self->slot_size);
+  } else {
+    g_mutex_lock (&self->lock);
+    g_object_unref (self->cancellable);
+    self->cancellable = g_cancellable_new ();
+    g_mutex_unlock (&self->lock);
+  }
+
+  return TRUE;
+}
+
+static void
+gst_gtuber_range_src_set_context (GstElement *element, GstContext *context)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (element);
+
+  if (gst_context_has_context_type (context, GST_GTUBER_SOUP_SESSION_CONTEXT)) {
+    const GstStructure *structure = gst_context_get_structure (context);
+    const GValue *value = gst_structure_get_value (structure, "session");
+
+    g_mutex_lock (&self->prop_lock);
+    g_clear_object (&self->external_session);
+
+    /* Newer souphttpsrc puts its own wrapper type there,
+     * we can only use a plain session (e.g. from application) */
+    if (value && G_VALUE_HOLDS_OBJECT (value)
+        && SOUP_IS_SESSION (g_value_get_object (value)))
+      self->external_session = g_value_dup_object (value);
+
+    g_mutex_unlock (&self->prop_lock);
+  }
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+static void
+gst_gtuber_range_src_init (GstGtuberRangeSrc *self)
+{
+  g_mutex_init (&self->prop_lock);
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+
+  self->location = NULL;
+  self->connections = DEFAULT_CONNECTIONS;
+  self->chunk_size = DEFAULT_CHUNK_SIZE;
+  self->user_agent = g_strdup (DEFAULT_USER_AGENT);
+  self->extra_headers = NULL;
+
+  self->cancellable = g_cancellable_new ();
+  self->size = UNKNOWN_SIZE;
+
+  gst_base_src_set_format (GST_BASE_SRC (self), GST_FORMAT_BYTES);
+}
+
+static void
+gst_gtuber_range_src_finalize (GObject *object)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (object);
+
+  GST_TRACE ("Finalize");
+
+  g_free (self->location);
+  g_free (self->user_agent);
+  gst_clear_structure (&self->extra_headers);
+
+  g_clear_object (&self->external_session);
+  g_clear_object (&self->cancellable);
+
+  g_mutex_clear (&self->prop_lock);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  GST_CALL_PARENT (G_OBJECT_CLASS, finalize, (object));
+}
+
+static void
+gst_gtuber_range_src_set_property (GObject *object, guint prop_id,
+    const GValue *value, GParamSpec *pspec)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:{
+      GError *error = NULL;
+
+      if (!gst_gtuber_range_src_set_location (self, g_value_get_string (value), &error)) {
+        GST_ERROR_OBJECT (self, "%s", error->message);
+        g_clear_error (&error);
+      }
+      break;
+    }
+    case PROP_CONNECTIONS:
+      g_mutex_lock (&self->prop_lock);
+      self->connections = g_value_get_uint (value);
+      g_mutex_unlock (&self->prop_lock);
+      break;
+    case PROP_CHUNK_SIZE:
+      g_mutex_lock (&self->prop_lock);
+      self->chunk_size = g_value_get_uint (value);
+      g_mutex_unlock (&self->prop_lock);
+      break;
+    case PROP_USER_AGENT:
+      g_mutex_lock (&self->prop_lock);
+      g_free (self->user_agent);
+      self->user_agent = g_value_dup_string (value);
+      g_mutex_unlock (&self->prop_lock);
+      break;
+    case PROP_EXTRA_HEADERS:{
+      const GstStructure *headers = gst_value_get_structure (value);
+
+      g_mutex_lock (&self->prop_lock);
+      gst_clear_structure (&self->extra_headers);
+      if (headers)
+        self->extra_headers = gst_structure_copy (headers);
+      g_mutex_unlock (&self->prop_lock);
+      break;
+    }
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gtuber_range_src_get_property (GObject *object, guint prop_id,
+    GValue *value, GParamSpec *pspec)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (object);
+
+  g_mutex_lock (&self->prop_lock);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_value_set_string (value, self->location);
+      break;
+    case PROP_CONNECTIONS:
+      g_value_set_uint (value, self->connections);
+      break;
+    case PROP_CHUNK_SIZE:
+      g_value_set_uint (value, self->chunk_size);
+      break;
+    case PROP_USER_AGENT:
+      g_value_set_string (value, self->user_agent);
+      break;
+    case PROP_EXTRA_HEADERS:
+      gst_value_set_structure (value, self->extra_headers);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  g_mutex_unlock (&self->prop_lock);
+}
+
+static void
+gst_gtuber_range_src_class_init (GstGtuberRangeSrcClass *klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *gstelement_class = (GstElementClass *) klass;
+  GstBaseSrcClass *gstbasesrc_class = (GstBaseSrcClass *) klass;
+  GstPushSrcClass *gstpushsrc_class = (GstPushSrcClass *) klass;
+
+  GST_DEBUG_CATEGORY_INIT (gst_gtuber_range_src_debug, "gtuberrangesrc", 0,
+      "Gtuber range source");
+
+  gobject_class->finalize = gst_gtuber_range_src_finalize;
+  gobject_class->set_property = gst_gtuber_range_src_set_property;
+  gobject_class->get_property = gst_gtuber_range_src_get_property;
+
+  param_specs[PROP_LOCATION] = g_param_spec_string ("location",
+      "Location", "HTTP location of the resource", NULL,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_CONNECTIONS] = g_param_spec_uint ("connections",
+      "Connections", "Number of concurrent range requests",
+      1, 16, DEFAULT_CONNECTIONS,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_CHUNK_SIZE] = g_param_spec_uint ("chunk-size",
+      "Chunk Size", "Size of a single range request in bytes (up to "
+      G_STRINGIFY (SLOTS_PER_CONNECTION) " chunks per connection are kept in memory)",
+      16 * 1024, G_MAXINT, DEFAULT_CHUNK_SIZE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_USER_AGENT] = g_param_spec_string ("user-agent",
+      "User-Agent", "Value of the User-Agent HTTP request header field",
+      DEFAULT_USER_AGENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_EXTRA_HEADERS] = g_param_spec_boxed ("extra-headers",
+      "Extra Headers", "Extra headers to append to the HTTP requests",
+      GST_TYPE_STRUCTURE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
+
+  gst_element_class_add_static_pad_template (gstelement_class, &src_factory);
+
+  gstelement_class->set_context = GST_DEBUG_FUNCPTR (gst_gtuber_range_src_set_context);
+
+  gstbasesrc_class->start = GST_DEBUG_FUNCPTR (gst_gtuber_range_src_start);
+  gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_gtuber_range_src_stop);
+  gstbasesrc_class->get_size = GST_DEBUG_FUNCPTR (gst_gtuber_range_src_get_size);
+  gstbasesrc_class->is_seekable = GST_DEBUG_FUNCPTR (gst_gtuber_range_src_is_seekable);
+  gstbasesrc_class->do_seek = GST_DEBUG_FUNCPTR (gst_gtuber_range_src_do_seek);
+  gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_gtuber_range_src_unlock);
+  gstbasesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_gtuber_range_src_unlock_stop);
+
+  gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_gtuber_range_src_create);
+
+  gst_element_class_set_static_metadata (gstelement_class, "Gtuber range source",
+      "Source/Network", "Downloads HTTP resource over multiple concurrent "
+      "range requests",
+      "Rafał Dzięgiel <rafostar.github@gmail.com>");
+}
+
+/**
+ * GstURIHandlerInterface
+ */
+static GstURIType
+gst_gtuber_range_src_uri_handler_get_type_src (GType type)
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+gst_gtuber_range_src_uri_handler_get_protocols (GType type)
+{
+  static const gchar *protocols[] = { "http", "https", NULL };
+
+  return protocols;
+}
+
+static gchar *
+gst_gtuber_range_src_uri_handler_get_uri (GstURIHandler *handler)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (handler);
+  gchar *uri;
+
+  g_mutex_lock (&self->prop_lock);
+  uri = g_strdup (self->location);
+  g_mutex_unlock (&self->prop_lock);
+
+  return uri;
+}
+
+static gboolean
+gst_gtuber_range_src_uri_handler_set_uri (GstURIHandler *handler,
+    const gchar *uri, GError **error)
+{
+  GstGtuberRangeSrc *self = GST_GTUBER_RANGE_SRC (handler);
+
+  return gst_gtuber_range_src_set_location (self, uri, error);
+}
+
+static void
+gst_gtuber_range_src_uri_handler_init (gpointer g_iface, gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_gtuber_range_src_uri_handler_get_type_src;
+  iface->get_protocols = gst_gtuber_range_src_uri_handler_get_protocols;
+  iface->get_uri = gst_gtuber_range_src_uri_handler_get_uri;
+  iface->set_uri = gst_gtuber_range_src_uri_handler_set_uri;
+}
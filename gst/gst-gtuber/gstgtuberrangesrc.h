@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2021 Rafał Dzięgiel <rafostar.github@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <gst/gst.h>
+#include <gst/base/gstpushsrc.h>
+#include <libsoup/soup.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GTUBER_RANGE_SRC (gst_gtuber_range_src_get_type())
+G_DECLARE_FINAL_TYPE (GstGtuberRangeSrc, gst_gtuber_range_src, GST, GTUBER_RANGE_SRC, GstPushSrc)
+
+struct _GstGtuberRangeSrc
+{
+  GstPushSrc src;
+
+  GMutex prop_lock;
+
+  /* < properties > */
+  gchar *location;
+  guint connections;
+  guint chunk_size;
+  gchar *user_agent;
+  GstStructure *extra_headers;
+
+  /* From "gst.soup.session" context */
+  SoupSession *external_session;
+
+  SoupSession *session;
+  GCancellable *cancellable;
+
+  /* Used when server does not support ranges */
+  GInputStream *fallback_stream;
+
+  GMutex lock;
+  GCond cond;
+
+  GThread **workers;
+  guint n_workers;
+
+  /* Ring of downloaded chunks, waiting to be pushed in order */
+  GstBuffer **slots;
+  guint n_slots;
+  guint slot_size;
+
+  guint64 size;
+  guint64 base_offset;
+  guint64 next_chunk;
+  guint64 read_chunk;
+
+  gboolean seekable;
+  gboolean flushing;
+  gboolean shutdown;
+
+  GError *error;
+  guint error_status;
+};
+
+G_END_DECLS
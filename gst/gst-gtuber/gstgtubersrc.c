@@ -25,6 +25,7 @@
 
 #include "gstgtubersrc.h"
 #include "gstgtuberelement.h"
+#include "gstgtuberfetch.h"
 
 #define GST_CAT_DEFAULT gst_gtuber_src_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
@@ -32,6 +33,8 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 #define DEFAULT_CODECS     GTUBER_CODEC_AVC | GTUBER_CODEC_MP4A
 #define DEFAULT_MAX_HEIGHT 0
 #define DEFAULT_MAX_FPS    0
+#define DEFAULT_PREFETCH   FALSE
+#define DEFAULT_PREFETCH_INDEX FALSE
 
 enum
 {
@@ -42,6 +45,9 @@ enum
   PROP_MAX_FPS,
   PROP_ITAGS,
   PROP_MEDIA_INFO,
+  PROP_PREFETCH,
+  PROP_PREFETCH_INDEX,
+  PROP_NEXT_LOCATION,
   PROP_LAST
 };
 
@@ -67,6 +73,25 @@ location_to_uri (const gchar *location)
       : g_strdup (location);
 }
 
+static void
+gst_gtuber_src_maybe_prefetch (GstGtuberSrc *self)
+{
+  gchar *uri = NULL;
+
+  g_mutex_lock (&self->prop_lock);
+  if (self->prefetch && self->location && !self->info)
+    uri = location_to_uri (self->location);
+  g_mutex_unlock (&self->prop_lock);
+
+  if (!uri)
+    return;
+
+  GST_DEBUG_OBJECT (self, "Prefetching media info");
+  gst_gtuber_prefetch_media_info (uri);
+
+  g_free (uri);
+}
+
 static gboolean
 gst_gtuber_src_set_location (GstGtuberSrc *self, const gchar *location,
     GError **error)
@@ -128,6 +153,8 @@ gst_gtuber_src_set_location (GstGtuberSrc *self, const gchar *location,
 
   g_mutex_unlock (&self->prop_lock);
 
+  gst_gtuber_src_maybe_prefetch (self);
+
   return TRUE;
 }
 
@@ -139,27 +166,6 @@ gst_gtuber_src_set_itags (GstGtuberSrc *self, const gchar *itags_str)
   g_free (self->itags_str);
   self->itags_str = g_strdup (itags_str);
 
-  g_array_remove_range (self->itags, 0, self->itags->len);
-
-  if (self->itags_str) {
-    gchar **itags = g_strsplit (self->itags_str, ",", 0);
-    guint index = 0;
-
-    while (itags[index]) {
-      guint itag;
-
-      g_strstrip (itags[index]);
-      itag = g_ascii_strtoull (itags[index], NULL, 10);
-      if (itag > 0) {
-        g_array_append_val (self->itags, itag);
-        GST_DEBUG_OBJECT (self, "Added allowed itag: %u", itag);
-      }
-      index++;
-    }
-
-    g_strfreev (itags);
-  }
-
   g_mutex_unlock (&self->prop_lock);
 }
 
@@ -358,56 +364,180 @@ gst_gtuber_src_push_events (GstGtuberSrc *self, GtuberMediaInfo *info)
   GST_DEBUG_OBJECT (self, "Pushed all events");
 }
 
-/* Called with a lock on props */
+static GtuberStreamSelector *
+gst_gtuber_src_create_stream_selector (GstGtuberSrc *self, GtuberMediaInfo *info)
+{
+  GtuberStreamSelector *selector;
+
+  selector = gtuber_stream_selector_new (info);
+
+  g_mutex_lock (&self->prop_lock);
+  gtuber_stream_selector_set_codecs (selector, self->codecs);
+  gtuber_stream_selector_set_max_height (selector, self->max_height);
+  gtuber_stream_selector_set_max_fps (selector, self->max_fps);
+  gtuber_stream_selector_set_itags (selector, self->itags_str);
+  g_mutex_unlock (&self->prop_lock);
+
+  return selector;
+}
+
 static gboolean
-get_is_stream_allowed (GtuberStream *stream, GstGtuberSrc *self)
+astream_filter_func (GtuberAdaptiveStream *astream, GtuberStreamSelector *selector)
 {
-  if (self->codecs > 0) {
-    GtuberCodecFlags flags = gtuber_stream_get_codec_flags (stream);
+  return gtuber_stream_selector_is_stream_allowed (selector, GTUBER_STREAM (astream));
+}
 
-    if ((self->codecs & flags) != flags)
-      return FALSE;
-  }
+static void
+gst_gtuber_src_prefetch_indexes (GstGtuberSrc *self, GtuberStreamSelector *selector,
+    GCancellable *cancellable)
+{
+  GError *error = NULL;
 
-  if (gtuber_stream_get_video_codec (stream) != NULL) {
-    if (self->max_height > 0) {
-      guint height = gtuber_stream_get_height (stream);
+  GST_DEBUG_OBJECT (self, "Prefetching segment indexes");
 
-      if (height == 0 || height > self->max_height)
-        return FALSE;
-    }
-    if (self->max_fps > 0) {
-      guint fps = gtuber_stream_get_fps (stream);
+  g_object_ref (cancellable);
 
-      if (fps == 0 || fps > self->max_fps)
-        return FALSE;
-    }
+  /* Done by shared fetch pool, reusing its warm connections */
+  if (!gst_gtuber_fetch_segment_indexes (
+      gtuber_stream_selector_get_media_info (selector),
+      (GtuberAdaptiveStreamFilter) astream_filter_func, selector,
+      cancellable, &error)) {
+    GST_DEBUG_OBJECT (self, "Segment indexes prefetch failed: %s", error->message);
+    g_clear_error (&error);
   }
 
-  if (self->itags->len > 0) {
-    guint i, itag = gtuber_stream_get_itag (stream);
-    gboolean found = FALSE;
+  g_object_unref (cancellable);
+}
 
-    for (i = 0; i < self->itags->len; i++) {
-      if ((found = itag == g_array_index (self->itags, guint, i)))
-        break;
-    }
+static void
+gst_gtuber_src_maybe_prefetch_indexes (GstGtuberSrc *self, GtuberStreamSelector *selector,
+    GCancellable *cancellable)
+{
+  gboolean prefetch_index;
+
+  g_mutex_lock (&self->prop_lock);
+  prefetch_index = self->prefetch_index;
+  g_mutex_unlock (&self->prop_lock);
+
+  if (prefetch_index)
+    gst_gtuber_src_prefetch_indexes (self, selector, cancellable);
+}
+
+typedef struct
+{
+  GstGtuberSrc *src;
+  gchar *uri;
+  GCancellable *cancellable;
+} GstGtuberNextData;
+
+static gpointer
+next_prefetch_thread_func (GstGtuberNextData *data)
+{
+  GstGtuberSrc *self = data->src;
+  GtuberMediaInfo *info;
+  GError *error = NULL;
+
+  GST_DEBUG_OBJECT (self, "Preparing next location: %s", data->uri);
+
+  /* Fetch statistics are reported by element that later plays it */
+  if ((info = gst_gtuber_fetch_media_info (data->uri, data->cancellable, NULL, &error))) {
+    GtuberStreamSelector *selector;
 
-    if (!found)
-      return FALSE;
+    /* Index is stored within shared media info, so it is reused too */
+    selector = gst_gtuber_src_create_stream_selector (self, info);
+    gst_gtuber_src_maybe_prefetch_indexes (self, selector, data->cancellable);
+
+    g_object_unref (selector);
+    g_object_unref (info);
+
+    GST_DEBUG_OBJECT (self, "Next location prepared");
+  } else {
+    GST_DEBUG_OBJECT (self, "Could not prepare next location: %s", error->message);
+    g_clear_error (&error);
   }
 
-  return TRUE;
+  g_object_unref (data->cancellable);
+  g_free (data->uri);
+  g_free (data);
+
+  return NULL;
 }
 
-static gboolean
-astream_filter_func (GtuberAdaptiveStream *astream, GstGtuberSrc *self)
+/* Must be called with next_lock held */
+static void
+gst_gtuber_src_stop_next_prefetch (GstGtuberSrc *self)
 {
-  return get_is_stream_allowed ((GtuberStream *) astream, self);
+  GThread *thread;
+
+  g_mutex_lock (&self->prop_lock);
+
+  g_cancellable_cancel (self->next_cancellable);
+  g_object_unref (self->next_cancellable);
+  self->next_cancellable = g_cancellable_new ();
+
+  thread = self->next_thread;
+  self->next_thread = NULL;
+
+  g_mutex_unlock (&self->prop_lock);
+
+  /* Thread reads properties, so join without prop_lock */
+  if (thread) {
+    GST_DEBUG_OBJECT (self, "Stopping previous next location prefetch");
+    g_thread_join (thread);
+  }
+}
+
+static void
+gst_gtuber_src_set_next_location (GstGtuberSrc *self, const gchar *next_location)
+{
+  GstGtuberNextData *data;
+  GCancellable *cancellable;
+  gchar *uri = NULL;
+
+  g_mutex_lock (&self->next_lock);
+
+  /* Stop preparing previous one, at most one runs at a time */
+  gst_gtuber_src_stop_next_prefetch (self);
+
+  g_mutex_lock (&self->prop_lock);
+
+  g_free (self->next_location);
+  self->next_location = g_strdup (next_location);
+
+  cancellable = g_object_ref (self->next_cancellable);
+
+  if (self->next_location)
+    uri = location_to_uri (self->next_location);
+
+  g_mutex_unlock (&self->prop_lock);
+
+  if (!uri || !gtuber_has_plugin_for_uri (uri, NULL)) {
+    if (uri)
+      GST_WARNING_OBJECT (self, "Gtuber does not have a plugin for next location");
+
+    g_object_unref (cancellable);
+    g_free (uri);
+    g_mutex_unlock (&self->next_lock);
+
+    return;
+  }
+
+  /* Thread does not hold a reference, it is joined on finalize */
+  data = g_new (GstGtuberNextData, 1);
+  data->src = self;
+  data->uri = uri;
+  data->cancellable = cancellable;
+
+  g_mutex_lock (&self->prop_lock);
+  self->next_thread = g_thread_new ("GstGtuberNextPrefetch",
+      (GThreadFunc) next_prefetch_thread_func, data);
+  g_mutex_unlock (&self->prop_lock);
+
+  g_mutex_unlock (&self->next_lock);
 }
 
 static gchar *
-gst_gtuber_generate_manifest (GstGtuberSrc *self, GtuberMediaInfo *info,
+gst_gtuber_generate_manifest (GstGtuberSrc *self, GtuberStreamSelector *selector,
     GtuberAdaptiveStreamManifest *manifest_type)
 {
   GtuberManifestGenerator *gen;
@@ -415,21 +545,15 @@ gst_gtuber_generate_manifest (GstGtuberSrc *self, GtuberMediaInfo *info,
   gchar *data;
 
   gen = gtuber_manifest_generator_new ();
-  gtuber_manifest_generator_set_media_info (gen, info);
-
-  gtuber_manifest_generator_set_filter_func (gen,
-      (GtuberAdaptiveStreamFilter) astream_filter_func, self, NULL);
+  gtuber_manifest_generator_set_media_info (gen,
+      gtuber_stream_selector_get_media_info (selector));
+  gtuber_manifest_generator_set_stream_selector (gen, selector);
 
   for (type = GTUBER_ADAPTIVE_STREAM_MANIFEST_DASH;
       type <= GTUBER_ADAPTIVE_STREAM_MANIFEST_HLS; type++) {
     gtuber_manifest_generator_set_manifest_type (gen, type);
 
-    /* Props are accessed in filter callback */
-    g_mutex_lock (&self->prop_lock);
-    data = gtuber_manifest_generator_to_data (gen);
-    g_mutex_unlock (&self->prop_lock);
-
-    if (data)
+    if ((data = gtuber_manifest_generator_to_data (gen)))
       break;
   }
 
@@ -445,94 +569,130 @@ gst_gtuber_generate_manifest (GstGtuberSrc *self, GtuberMediaInfo *info,
   return data;
 }
 
-static void
-_rate_streams_vals (guint a_num, guint b_num, guint weight,
-    guint *a_pts, guint *b_pts)
+static gchar *
+gst_gtuber_generate_best_uri_data (GstGtuberSrc *self, GtuberStreamSelector *selector)
 {
-  if (a_num > b_num)
-    *a_pts += weight;
-  else if (a_num < b_num)
-    *b_pts += weight;
+  GtuberStream *best_stream;
+
+  best_stream = gtuber_stream_selector_get_best_stream (selector,
+      GTUBER_STREAM_CONTENT_UNKNOWN, FALSE);
+
+  if (!best_stream)
+    return NULL;
+
+  GST_DEBUG_OBJECT (self, "Best stream itag: %u",
+      gtuber_stream_get_itag (best_stream));
+
+  return g_strdup (gtuber_stream_get_uri (best_stream));
 }
 
 static gchar *
-gst_gtuber_generate_best_uri_data (GstGtuberSrc *self, GtuberMediaInfo *info)
+gst_gtuber_selected_itags_to_string (GtuberStreamSelector *selector,
+    GtuberAdaptiveStreamManifest manifest_type)
 {
-  GPtrArray *streams;
-  GtuberStream *best_stream = NULL;
-  gchar *data = NULL;
+  GString *string;
   guint i;
 
-  streams = gtuber_media_info_get_streams (info);
-
-  for (i = 0; i < streams->len; i++) {
-    GtuberStream *stream;
-
-    stream = g_ptr_array_index (streams, i);
-
-    if (get_is_stream_allowed (stream, self)) {
-      guint best_pts = 0, curr_pts = 0;
-
-      if (best_stream) {
-        _rate_streams_vals (
-            gtuber_stream_get_height (best_stream),
-            gtuber_stream_get_height (stream),
-            8, &best_pts, &curr_pts);
-        _rate_streams_vals (
-            gtuber_stream_get_width (best_stream),
-            gtuber_stream_get_width (stream),
-            4, &best_pts, &curr_pts);
-        _rate_streams_vals (
-            gtuber_stream_get_bitrate (best_stream),
-            gtuber_stream_get_bitrate (stream),
-            2, &best_pts, &curr_pts);
-        _rate_streams_vals (
-            gtuber_stream_get_fps (best_stream),
-            gtuber_stream_get_fps (stream),
-            1, &best_pts, &curr_pts);
-      }
+  string = g_string_new (NULL);
 
-      if (!best_stream || curr_pts > best_pts) {
-        best_stream = stream;
-        GST_DEBUG ("Current best stream itag: %u",
-            gtuber_stream_get_itag (best_stream));
-      }
+  if (manifest_type != GTUBER_ADAPTIVE_STREAM_MANIFEST_UNKNOWN) {
+    GPtrArray *astreams;
+
+    astreams = gtuber_stream_selector_get_allowed_adaptive_streams (selector);
+
+    for (i = 0; i < astreams->len; i++) {
+      GtuberAdaptiveStream *astream = g_ptr_array_index (astreams, i);
+
+      if (gtuber_adaptive_stream_get_manifest_type (astream) != manifest_type)
+        continue;
+
+      if (string->len > 0)
+        g_string_append_c (string, ',');
+
+      g_string_append_printf (string, "%u",
+          gtuber_stream_get_itag (GTUBER_STREAM (astream)));
     }
+
+    g_ptr_array_unref (astreams);
+  } else {
+    GtuberStream *best_stream;
+
+    best_stream = gtuber_stream_selector_get_best_stream (selector,
+        GTUBER_STREAM_CONTENT_UNKNOWN, FALSE);
+
+    if (best_stream)
+      g_string_append_printf (string, "%u", gtuber_stream_get_itag (best_stream));
   }
 
-  if (best_stream)
-    data = g_strdup (gtuber_stream_get_uri (best_stream));
+  return g_string_free (string, FALSE);
+}
 
-  return data;
+static void
+gst_gtuber_src_post_statistics (GstGtuberSrc *self, GstStructure *stats)
+{
+  GST_DEBUG_OBJECT (self, "Posting statistics: %" GST_PTR_FORMAT, stats);
+
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_element (GST_OBJECT (self), stats));
 }
 
 static GstBuffer *
 gst_gtuber_media_info_to_buffer (GstGtuberSrc *self, GtuberMediaInfo *info,
-    GError **error)
+    GstStructure *stats, GError **error)
 {
-  GtuberAdaptiveStreamManifest manifest_type;
+  GtuberStreamSelector *selector;
+  GtuberAdaptiveStreamManifest manifest_type = GTUBER_ADAPTIVE_STREAM_MANIFEST_UNKNOWN;
   GstBuffer *buffer;
   GstCaps *caps = NULL;
-  gchar *data;
+  GstClockTime gen_start;
+  const gchar *type_name = NULL;
+  gchar *data, *itags;
+
+  /* Streams are classified once and reused by all steps below */
+  selector = gst_gtuber_src_create_stream_selector (self, info);
+
+  gst_gtuber_src_maybe_prefetch_indexes (self, selector, self->cancellable);
+
+  gen_start = gst_util_get_timestamp ();
 
-  if ((data = gst_gtuber_generate_manifest (self, info, &manifest_type))) {
+  if ((data = gst_gtuber_generate_manifest (self, selector, &manifest_type))) {
     GST_INFO ("Using adaptive streaming");
 
     switch (manifest_type) {
       case GTUBER_ADAPTIVE_STREAM_MANIFEST_DASH:
         caps = gst_caps_new_empty_simple ("application/dash+xml");
+        type_name = "dash";
         break;
       case GTUBER_ADAPTIVE_STREAM_MANIFEST_HLS:
         caps = gst_caps_new_empty_simple ("application/x-hls");
+        type_name = "hls";
         break;
       default:
         GST_WARNING_OBJECT (self, "Unsupported gtuber manifest type");
         break;
     }
-  } else if ((data = gst_gtuber_generate_best_uri_data (self, info))) {
+  } else if ((data = gst_gtuber_generate_best_uri_data (self, selector))) {
     GST_INFO ("Using direct stream");
     caps = gst_caps_new_empty_simple ("text/uri-list");
-  } else {
+    type_name = "uri";
+  }
+
+  if (data) {
+    itags = gst_gtuber_selected_itags_to_string (selector, manifest_type);
+
+    gst_structure_set (stats,
+        "manifest-type", G_TYPE_STRING, type_name,
+        "manifest-size", G_TYPE_UINT64, (guint64) strlen (data),
+        "manifest-duration", G_TYPE_UINT64, gst_util_get_timestamp () - gen_start,
+        "itags", G_TYPE_STRING, itags,
+        NULL);
+
+    g_free (itags);
+  }
+
+  g_object_unref (selector);
+
+  if (!data) {
     g_set_error (error, GTUBER_MANIFEST_GENERATOR_ERROR,
         GTUBER_MANIFEST_GENERATOR_ERROR_NO_DATA,
         "No manifest data was generated");
@@ -555,112 +715,87 @@ gst_gtuber_media_info_to_buffer (GstGtuberSrc *self, GtuberMediaInfo *info,
   return buffer;
 }
 
-typedef struct
+static GtuberMediaInfo *
+gst_gtuber_src_fetch_media_info (GstGtuberSrc *self, gboolean *fetched,
+    GError **error)
 {
-  GstGtuberSrc *src;
   GtuberMediaInfo *info;
-  GError *error;
-  gboolean fired;
-} GstGtuberThreadData;
-
-static GstGtuberThreadData *
-gst_gtuber_thread_data_new (GstGtuberSrc *self)
-{
-  GstGtuberThreadData *data;
-
-  data = g_new (GstGtuberThreadData, 1);
-  data->src = gst_object_ref (self);
-  data->info = NULL;
-  data->error = NULL;
-  data->fired = FALSE;
-
-  return data;
-}
-
-static void
-gst_gtuber_thread_data_free (GstGtuberThreadData *data)
-{
-  gst_object_unref (data->src);
-  g_clear_object (&data->info);
-  g_clear_error (&data->error);
-
-  g_free (data);
-}
-
-static gpointer
-client_thread_func (GstGtuberThreadData *data)
-{
-  GstGtuberSrc *self = data->src;
-  GtuberClient *client;
-  GMainContext *ctx;
+  GCancellable *cancellable;
   gchar *uri;
 
-  g_mutex_lock (&self->client_lock);
-  GST_DEBUG ("Entered new GtuberClient thread");
+  GST_DEBUG_OBJECT (self, "Fetching media info");
 
   g_mutex_lock (&self->prop_lock);
   uri = location_to_uri (self->location);
   g_mutex_unlock (&self->prop_lock);
 
-  ctx = g_main_context_new ();
-  g_main_context_push_thread_default (ctx);
-
-  GST_INFO ("Fetching media info for URI: %s", uri);
-
-  client = gtuber_client_new ();
-  data->info = gtuber_client_fetch_media_info (client, uri,
-      self->cancellable, &data->error);
-  g_object_unref (client);
-
-  g_main_context_pop_thread_default (ctx);
-  g_main_context_unref (ctx);
+  cancellable = g_object_ref (self->cancellable);
+  info = gst_gtuber_fetch_media_info (uri, cancellable, fetched, error);
+  g_object_unref (cancellable);
 
   g_free (uri);
 
-  GST_DEBUG ("Leaving GtuberClient thread");
+  if (info)
+    GST_DEBUG_OBJECT (self, "Fetched media info");
 
-  data->fired = TRUE;
-  g_cond_signal (&self->client_finished);
-  g_mutex_unlock (&self->client_lock);
-
-  return NULL;
+  return info;
 }
 
-static GtuberMediaInfo *
-gst_gtuber_fetch_media_info (GstGtuberSrc *self, GError **error)
+static gboolean
+gst_gtuber_src_handle_refresh_query (GstGtuberSrc *self, GstQuery *query)
 {
   GtuberMediaInfo *info;
-  GstGtuberThreadData *data;
-
-  GST_DEBUG_OBJECT (self, "Fetching media info");
-
-  g_mutex_lock (&self->client_lock);
+  GtuberStreamSelector *selector;
+  GstStructure *structure;
+  GError *error = NULL;
+  gchar *uri = NULL, *data;
 
-  data = gst_gtuber_thread_data_new (self);
-  self->client_thread = g_thread_new ("GstGtuberClientThread",
-      (GThreadFunc) client_thread_func, data);
+  g_mutex_lock (&self->prop_lock);
+  if (self->location)
+    uri = location_to_uri (self->location);
+  g_mutex_unlock (&self->prop_lock);
 
-  while (!data->fired)
-    g_cond_wait (&self->client_finished, &self->client_lock);
+  if (!uri) {
+    GST_WARNING_OBJECT (self, "Cannot refresh media info without location");
+    return FALSE;
+  }
 
-  g_thread_unref (self->client_thread);
-  self->client_thread = NULL;
+  GST_INFO_OBJECT (self, "Refreshing media info");
 
-  g_mutex_unlock (&self->client_lock);
+  /* Cached one is what contains expired URIs */
+  gst_gtuber_fetch_invalidate (uri);
+  g_free (uri);
 
-  if (!data->info) {
-    *error = g_error_copy (data->error);
-    gst_gtuber_thread_data_free (data);
+  if (!(info = gst_gtuber_src_fetch_media_info (self, NULL, &error))) {
+    GST_WARNING_OBJECT (self, "Could not refresh media info: %s", error->message);
+    g_clear_error (&error);
 
     return FALSE;
   }
 
-  GST_DEBUG_OBJECT (self, "Fetched media info");
-  info = g_object_ref (data->info);
+  selector = gst_gtuber_src_create_stream_selector (self, info);
 
-  gst_gtuber_thread_data_free (data);
+  gst_gtuber_src_maybe_prefetch_indexes (self, selector, self->cancellable);
 
-  return info;
+  if (!(data = gst_gtuber_generate_manifest (self, selector, NULL)))
+    data = gst_gtuber_generate_best_uri_data (self, selector);
+
+  g_object_unref (selector);
+
+  if (data) {
+    structure = gst_query_writable_structure (query);
+    gst_structure_set (structure, "data", G_TYPE_STRING, data, NULL);
+    g_free (data);
+
+    GST_INFO_OBJECT (self, "Refreshed media info");
+  }
+
+  g_mutex_lock (&self->prop_lock);
+  g_clear_object (&self->info);
+  self->info = info;
+  g_mutex_unlock (&self->prop_lock);
+
+  return (data != NULL);
 }
 
 static GstFlowReturn
@@ -668,7 +803,9 @@ gst_gtuber_src_create (GstPushSrc *push_src, GstBuffer **outbuf)
 {
   GstGtuberSrc *self = GST_GTUBER_SRC (push_src);
   GtuberMediaInfo *info = NULL;
+  GstStructure *stats;
   GError *error = NULL;
+  gboolean fetched = FALSE;
 
   /* When non-zero, we already returned complete data */
   if (self->buf_size > 0)
@@ -681,18 +818,40 @@ gst_gtuber_src_create (GstPushSrc *push_src, GstBuffer **outbuf)
   }
   g_mutex_unlock (&self->prop_lock);
 
+  stats = gst_structure_new_empty (GST_GTUBER_RESOLVE_STATS);
+
   if (!info) {
-    if (!(info = gst_gtuber_fetch_media_info (self, &error))) {
+    GstClockTime fetch_start = gst_util_get_timestamp ();
+
+    if (!(info = gst_gtuber_src_fetch_media_info (self, &fetched, &error))) {
       GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND,
           ("%s", error->message), (NULL));
       g_clear_error (&error);
+      gst_structure_free (stats);
 
       return GST_FLOW_ERROR;
     }
+
+    /* Duration of waiting here, info itself might come from cache */
+    gst_structure_set (stats,
+        "resolve-duration", G_TYPE_UINT64, gst_util_get_timestamp () - fetch_start,
+        NULL);
+  }
+
+  /* Cached or user provided media info did not cost us any requests */
+  if (fetched && gtuber_media_info_get_plugin_name (info)) {
+    gst_structure_set (stats,
+        "plugin", G_TYPE_STRING, gtuber_media_info_get_plugin_name (info),
+        "http-requests", G_TYPE_UINT, gtuber_media_info_get_n_requests (info),
+        NULL);
   }
 
-  if ((*outbuf = gst_gtuber_media_info_to_buffer (self, info, &error)))
+  if ((*outbuf = gst_gtuber_media_info_to_buffer (self, info, stats, &error))) {
     gst_gtuber_src_push_events (self, info);
+    gst_gtuber_src_post_statistics (self, stats);
+  } else {
+    gst_structure_free (stats);
+  }
 
   /* Hold media info in order for data in it to stay valid */
   g_mutex_lock (&self->prop_lock);
@@ -721,6 +880,13 @@ gst_gtuber_src_query (GstBaseSrc *base_src, GstQuery *query)
         ret = TRUE;
       }
       break;
+    case GST_QUERY_CUSTOM:{
+      const GstStructure *structure = gst_query_get_structure (query);
+
+      if (gst_structure_has_name (structure, GST_GTUBER_REFRESH_QUERY))
+        return gst_gtuber_src_handle_refresh_query (self, query);
+      break;
+    }
     default:
       ret = FALSE;
       break;
@@ -736,19 +902,20 @@ static void
 gst_gtuber_src_init (GstGtuberSrc *self)
 {
   g_mutex_init (&self->prop_lock);
-
-  g_mutex_init (&self->client_lock);
-  g_cond_init (&self->client_finished);
+  g_mutex_init (&self->next_lock);
 
   self->location = NULL;
+  self->next_location = NULL;
+  self->next_thread = NULL;
   self->codecs = DEFAULT_CODECS;
   self->max_height = DEFAULT_MAX_HEIGHT;
   self->max_fps = DEFAULT_MAX_FPS;
+  self->prefetch = DEFAULT_PREFETCH;
+  self->prefetch_index = DEFAULT_PREFETCH_INDEX;
   self->itags_str = NULL;
 
-  self->itags = g_array_new (FALSE, FALSE, sizeof (guint));
-
   self->cancellable = g_cancellable_new ();
+  self->next_cancellable = g_cancellable_new ();
   self->buf_size = 0;
 }
 
@@ -759,25 +926,21 @@ gst_gtuber_src_finalize (GObject *object)
 
   GST_TRACE ("Finalize");
 
-  g_mutex_lock (&self->client_lock);
-
-  if (self->client_thread)
-    g_thread_unref (self->client_thread);
-
-  g_mutex_unlock (&self->client_lock);
+  g_mutex_lock (&self->next_lock);
+  gst_gtuber_src_stop_next_prefetch (self);
+  g_mutex_unlock (&self->next_lock);
 
   g_free (self->location);
   g_free (self->itags_str);
 
-  g_array_unref (self->itags);
+  g_free (self->next_location);
 
   g_clear_object (&self->cancellable);
+  g_clear_object (&self->next_cancellable);
   g_clear_object (&self->info);
 
-  g_mutex_clear (&self->client_lock);
-  g_cond_clear (&self->client_finished);
-
   g_mutex_clear (&self->prop_lock);
+  g_mutex_clear (&self->next_lock);
 
   GST_CALL_PARENT (G_OBJECT_CLASS, finalize, (object));
 }
@@ -822,6 +985,21 @@ gst_gtuber_src_set_property (GObject *object, guint prop_id,
       self->info = g_value_dup_object (value);
       g_mutex_unlock (&self->prop_lock);
       break;
+    case PROP_PREFETCH:
+      g_mutex_lock (&self->prop_lock);
+      self->prefetch = g_value_get_boolean (value);
+      g_mutex_unlock (&self->prop_lock);
+
+      gst_gtuber_src_maybe_prefetch (self);
+      break;
+    case PROP_PREFETCH_INDEX:
+      g_mutex_lock (&self->prop_lock);
+      self->prefetch_index = g_value_get_boolean (value);
+      g_mutex_unlock (&self->prop_lock);
+      break;
+    case PROP_NEXT_LOCATION:
+      gst_gtuber_src_set_next_location (self, g_value_get_string (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -855,6 +1033,15 @@ gst_gtuber_src_get_property (GObject *object, guint prop_id,
     case PROP_MEDIA_INFO:
       g_value_set_object (value, self->info);
       break;
+    case PROP_PREFETCH:
+      g_value_set_boolean (value, self->prefetch);
+      break;
+    case PROP_PREFETCH_INDEX:
+      g_value_set_boolean (value, self->prefetch_index);
+      break;
+    case PROP_NEXT_LOCATION:
+      g_value_set_string (value, self->next_location);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -906,6 +1093,21 @@ gst_gtuber_src_class_init (GstGtuberSrcClass *klass)
       "or for reading fetched one after start",
       GTUBER_TYPE_MEDIA_INFO, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  param_specs[PROP_PREFETCH] = g_param_spec_boolean ("prefetch",
+      "Prefetch", "Start fetching media info in background as soon as "
+      "location is set, without waiting for the element to start",
+      DEFAULT_PREFETCH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_PREFETCH_INDEX] = g_param_spec_boolean ("prefetch-index",
+      "Prefetch Index", "Download DASH streams init and index ranges in parallel "
+      "before generating manifest, so it can list media segments directly",
+      DEFAULT_PREFETCH_INDEX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_NEXT_LOCATION] = g_param_spec_string ("next-location",
+      "Next Location", "Location that will be played next, to be resolved "
+      "in background, so switching to it does not wait for the network", NULL,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
 
   gst_element_class_add_static_pad_template (gstelement_class, &src_factory);
@@ -33,20 +33,22 @@ struct _GstGtuberSrc
 
   GMutex prop_lock;
 
-  GMutex client_lock;
-  GCond client_finished;
-  GThread *client_thread;
-
   /* < properties > */
   gchar *location;
   GtuberCodecFlags codecs;
   guint max_height;
   guint max_fps;
   gchar *itags_str;
-
-  GArray *itags;
+  gboolean prefetch;
+  gboolean prefetch_index;
+  gchar *next_location;
 
   GCancellable *cancellable;
+
+  /* Serializes changes of next location */
+  GMutex next_lock;
+  GThread *next_thread;
+  GCancellable *next_cancellable;
   gsize buf_size;
 
   GtuberMediaInfo *info;
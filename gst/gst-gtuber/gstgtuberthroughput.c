@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2021 Rafał Dzięgiel <rafostar.github@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Small persistent store of measured download throughput per host.
+ *
+ * Each host keeps an exponentially weighted moving average of throughput
+ * observed while downloading media fragments, so the next playback from
+ * the same host can start at a sensible bitrate instead of a fixed guess.
+ *
+ * Samples are added from streaming threads, so the store is only written
+ * to disk with gst_gtuber_throughput_save() when playback stops.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstgtuberthroughput.h"
+
+#define GST_CAT_DEFAULT gst_gtuber_throughput_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define STORE_FILENAME     "gst-throughput.ini"
+#define STORE_GROUP_PREFIX "host "
+
+/* Weight of a new sample in the average */
+#define EWMA_ALPHA 0.3
+
+/* Samples that are too small mostly measure latency, not throughput */
+#define MIN_SAMPLE_BYTES (64 * 1024)
+#define MIN_SAMPLE_TIME  (10 * GST_MSECOND)
+
+#define ESTIMATE_MAX_AGE (7 * 24 * 60 * 60)
+
+static GMutex store_lock;
+static GKeyFile *store = NULL;
+static gboolean store_dirty = FALSE;
+
+static gchar *
+_obtain_store_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+      GTUBER_API_NAME, STORE_FILENAME, NULL);
+}
+
+/* Must be called with store_lock held */
+static void
+_ensure_store (void)
+{
+  gchar *path;
+  GError *error = NULL;
+
+  if (G_LIKELY (store != NULL))
+    return;
+
+  GST_DEBUG_CATEGORY_INIT (gst_gtuber_throughput_debug, "gtuberthroughput", 0,
+      "Gtuber throughput store");
+
+  store = g_key_file_new ();
+  path = _obtain_store_path ();
+
+  if (!g_key_file_load_from_file (store, path, G_KEY_FILE_NONE, &error)) {
+    if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+      GST_WARNING ("Could not load throughput store: %s", error->message);
+
+    g_clear_error (&error);
+  } else {
+    GST_DEBUG ("Loaded throughput store from: %s", path);
+  }
+
+  g_free (path);
+}
+
+/* Must be called with store_lock held */
+static void
+_save_store (void)
+{
+  gchar *path, *dir;
+  GError *error = NULL;
+
+  if (!store || !store_dirty)
+    return;
+
+  path = _obtain_store_path ();
+  dir = g_path_get_dirname (path);
+
+  if (g_mkdir_with_parents (dir, 0755) == 0
+      && g_key_file_save_to_file (store, path, &error)) {
+    GST_DEBUG ("Saved throughput store to: %s", path);
+    store_dirty = FALSE;
+  } else {
+    GST_WARNING ("Could not save throughput store: %s",
+        (error) ? error->message : "cannot create directory");
+    g_clear_error (&error);
+  }
+
+  g_free (dir);
+  g_free (path);
+}
+
+/*
+ * Returns throughput estimate for host in kbps
+ * or 0 when it was never measured (or is outdated).
+ */
+guint
+gst_gtuber_throughput_get_estimate (const gchar *host)
+{
+  gchar *group;
+  gint64 updated;
+  gdouble kbps = 0;
+
+  g_return_val_if_fail (host != NULL, 0);
+
+  group = g_strconcat (STORE_GROUP_PREFIX, host, NULL);
+
+  g_mutex_lock (&store_lock);
+  _ensure_store ();
+
+  updated = g_key_file_get_int64 (store, group, "updated", NULL);
+
+  if (updated + ESTIMATE_MAX_AGE > g_get_real_time () / G_USEC_PER_SEC)
+    kbps = g_key_file_get_double (store, group, "kbps", NULL);
+
+  g_mutex_unlock (&store_lock);
+
+  GST_DEBUG ("Throughput estimate for %s: %.0f kbps", host, kbps);
+  g_free (group);
+
+  return (guint) kbps;
+}
+
+void
+gst_gtuber_throughput_add_sample (const gchar *host, guint64 bytes,
+    GstClockTime download_time)
+{
+  gchar *group;
+  gdouble sample, kbps;
+
+  g_return_if_fail (host != NULL);
+
+  if (bytes < MIN_SAMPLE_BYTES || !GST_CLOCK_TIME_IS_VALID (download_time)
+      || download_time < MIN_SAMPLE_TIME)
+    return;
+
+  /* bits per millisecond == kbps */
+  sample = (gdouble) bytes * 8 / ((gdouble) download_time / GST_MSECOND);
+  group = g_strconcat (STORE_GROUP_PREFIX, host, NULL);
+
+  g_mutex_lock (&store_lock);
+  _ensure_store ();
+
+  if (g_key_file_has_key (store, group, "kbps", NULL)) {
+    kbps = g_key_file_get_double (store, group, "kbps", NULL);
+    kbps = EWMA_ALPHA * sample + (1.0 - EWMA_ALPHA) * kbps;
+  } else {
+    kbps = sample;
+  }
+
+  g_key_file_set_double (store, group, "kbps", kbps);
+  g_key_file_set_int64 (store, group, "updated",
+      g_get_real_time () / G_USEC_PER_SEC);
+  store_dirty = TRUE;
+
+  GST_LOG ("Throughput sample for %s: %.0f kbps, average: %.0f kbps",
+      host, sample, kbps);
+
+  g_mutex_unlock (&store_lock);
+
+  g_free (group);
+}
+
+void
+gst_gtuber_throughput_save (void)
+{
+  g_mutex_lock (&store_lock);
+  _save_store ();
+  g_mutex_unlock (&store_lock);
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2021 Rafał Dzięgiel <rafostar.github@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Collects statistics messages posted by gtuber elements from all
+ * pipelines within the process. Enable with: GST_TRACERS="gtuber"
+ * and see results with: GST_DEBUG="gtubertracer:5"
+ *
+ * Aggregated results are logged after each update, as the tracer
+ * itself is only finalized when application calls gst_deinit().
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstgtubertracer.h"
+#include "gstgtuberelement.h"
+
+#define GST_CAT_DEFAULT gst_gtuber_tracer_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define parent_class gst_gtuber_tracer_parent_class
+G_DEFINE_TYPE (GstGtuberTracer, gst_gtuber_tracer, GST_TYPE_TRACER);
+
+static void
+_stat_add (GstGtuberTracerStat *stat, guint64 value)
+{
+  stat->count++;
+  stat->total += value;
+
+  if (value > stat->max)
+    stat->max = value;
+}
+
+static void
+_stat_log (const gchar *name, GstGtuberTracerStat *stat)
+{
+  if (stat->count == 0)
+    return;
+
+  GST_DEBUG ("%s: count %u, average %" GST_TIME_FORMAT ", max %" GST_TIME_FORMAT,
+      name, stat->count, GST_TIME_ARGS (stat->total / stat->count),
+      GST_TIME_ARGS (stat->max));
+}
+
+static void
+_count_name (GHashTable *table, const gchar *name)
+{
+  guint count;
+
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (table, name));
+  g_hash_table_insert (table, g_strdup (name), GUINT_TO_POINTER (count + 1));
+}
+
+static void
+_log_name_count_cb (const gchar *name, gpointer count, const gchar *prefix)
+{
+  GST_DEBUG ("%s %s: %u", prefix, name, GPOINTER_TO_UINT (count));
+}
+
+static void
+gst_gtuber_tracer_add_resolve_stats (GstGtuberTracer *self,
+    const GstStructure *stats)
+{
+  const gchar *str;
+  guint64 value;
+  guint n_requests;
+
+  if (gst_structure_get_uint64 (stats, "resolve-duration", &value))
+    _stat_add (&self->resolve, value);
+  if ((str = gst_structure_get_string (stats, "plugin")))
+    _count_name (self->plugins, str);
+  if (gst_structure_get_uint (stats, "http-requests", &n_requests))
+    self->n_requests += n_requests;
+
+  if ((str = gst_structure_get_string (stats, "manifest-type")))
+    _count_name (self->manifest_types, str);
+  if (gst_structure_get_uint64 (stats, "manifest-duration", &value))
+    _stat_add (&self->manifest, value);
+  if (gst_structure_get_uint64 (stats, "manifest-size", &value))
+    self->manifest_bytes += value;
+}
+
+/* Must be called with lock held */
+static void
+gst_gtuber_tracer_log_summary (GstGtuberTracer *self)
+{
+  _stat_log ("Resolve", &self->resolve);
+  _stat_log ("Manifest generation", &self->manifest);
+  _stat_log ("Startup", &self->startup);
+
+  if (self->resolve.count > 0) {
+    GST_DEBUG ("HTTP requests: %" G_GUINT64_FORMAT, self->n_requests);
+    GST_DEBUG ("Manifest bytes: %" G_GUINT64_FORMAT, self->manifest_bytes);
+  }
+
+  g_hash_table_foreach (self->plugins,
+      (GHFunc) _log_name_count_cb, "Plugin");
+  g_hash_table_foreach (self->manifest_types,
+      (GHFunc) _log_name_count_cb, "Manifest type");
+}
+
+static void
+do_post_message_pre (GstGtuberTracer *self, guint64 ts, GstElement *element,
+    GstMessage *message)
+{
+  const GstStructure *stats;
+
+  if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_ELEMENT)
+    return;
+
+  stats = gst_message_get_structure (message);
+
+  if (gst_structure_has_name (stats, GST_GTUBER_RESOLVE_STATS)) {
+    GST_INFO_OBJECT (element, "%" GST_PTR_FORMAT, stats);
+
+    g_mutex_lock (&self->lock);
+    gst_gtuber_tracer_add_resolve_stats (self, stats);
+    gst_gtuber_tracer_log_summary (self);
+    g_mutex_unlock (&self->lock);
+  } else if (gst_structure_has_name (stats, GST_GTUBER_STARTUP_STATS)) {
+    guint64 value;
+
+    GST_INFO_OBJECT (element, "%" GST_PTR_FORMAT, stats);
+
+    if (!gst_structure_get_uint64 (stats, "startup-duration", &value))
+      return;
+
+    g_mutex_lock (&self->lock);
+    _stat_add (&self->startup, value);
+    gst_gtuber_tracer_log_summary (self);
+    g_mutex_unlock (&self->lock);
+  }
+}
+
+
+static void
+gst_gtuber_tracer_init (GstGtuberTracer *self)
+{
+  g_mutex_init (&self->lock);
+
+  self->plugins = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->manifest_types = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  gst_tracing_register_hook (GST_TRACER (self), "element-post-message-pre",
+      G_CALLBACK (do_post_message_pre));
+}
+
+static void
+gst_gtuber_tracer_finalize (GObject *object)
+{
+  GstGtuberTracer *self = GST_GTUBER_TRACER (object);
+
+  GST_TRACE ("Finalize");
+
+  g_hash_table_unref (self->plugins);
+  g_hash_table_unref (self->manifest_types);
+
+  g_mutex_clear (&self->lock);
+
+  GST_CALL_PARENT (G_OBJECT_CLASS, finalize, (object));
+}
+
+static void
+gst_gtuber_tracer_class_init (GstGtuberTracerClass *klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  GST_DEBUG_CATEGORY_INIT (gst_gtuber_tracer_debug, "gtubertracer", 0,
+      "Gtuber Tracer");
+
+  gobject_class->finalize = gst_gtuber_tracer_finalize;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 Rafał Dzięgiel <rafostar.github@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GTUBER_TRACER            (gst_gtuber_tracer_get_type ())
+#define GST_IS_GTUBER_TRACER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_GTUBER_TRACER))
+#define GST_IS_GTUBER_TRACER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_GTUBER_TRACER))
+#define GST_GTUBER_TRACER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_TYPE_GTUBER_TRACER, GstGtuberTracerClass))
+#define GST_GTUBER_TRACER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_GTUBER_TRACER, GstGtuberTracer))
+#define GST_GTUBER_TRACER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_GTUBER_TRACER, GstGtuberTracerClass))
+#define GST_GTUBER_TRACER_CAST(obj)       ((GstGtuberTracer*)(obj))
+
+typedef struct _GstGtuberTracer GstGtuberTracer;
+typedef struct _GstGtuberTracerClass GstGtuberTracerClass;
+
+typedef struct
+{
+  guint count;
+  guint64 total;
+  guint64 max;
+} GstGtuberTracerStat;
+
+struct _GstGtuberTracer
+{
+  GstTracer parent;
+
+  GMutex lock;
+
+  GstGtuberTracerStat resolve;
+  GstGtuberTracerStat manifest;
+  GstGtuberTracerStat startup;
+
+  guint64 n_requests;
+  guint64 manifest_bytes;
+
+  /* Name -> number of occurrences */
+  GHashTable *plugins;
+  GHashTable *manifest_types;
+};
+
+struct _GstGtuberTracerClass
+{
+  GstTracerClass parent_class;
+};
+
+GType gst_gtuber_tracer_get_type (void);
+
+G_END_DECLS
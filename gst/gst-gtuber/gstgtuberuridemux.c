@@ -27,6 +27,19 @@
 #define GST_CAT_DEFAULT gst_gtuber_uri_demux_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
+#define DEFAULT_CONNECTIONS 1
+#define DEFAULT_CHUNK_SIZE  (1024 * 1024)
+
+enum
+{
+  PROP_0,
+  PROP_CONNECTIONS,
+  PROP_CHUNK_SIZE,
+  PROP_LAST
+};
+
+static GParamSpec *param_specs[PROP_LAST] = { NULL, };
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -43,6 +56,35 @@ G_DEFINE_TYPE_WITH_CODE (GstGtuberUriDemux, gst_gtuber_uri_demux,
 GST_ELEMENT_REGISTER_DEFINE_WITH_CODE (gtuberuridemux, "gtuberuridemux",
     GST_RANK_PRIMARY + 10, GST_TYPE_GTUBER_URI_DEMUX, gst_gtuber_element_init (plugin));
 
+static GstElement *
+gst_gtuber_uri_demux_make_uri_handler (GstGtuberUriDemux *self, const gchar *uri)
+{
+  GstElement *uri_handler = NULL;
+  guint connections, chunk_size;
+
+  GST_GTUBER_BIN_PROP_LOCK (self);
+  connections = self->connections;
+  chunk_size = self->chunk_size;
+  GST_GTUBER_BIN_PROP_UNLOCK (self);
+
+  /* Splitting download is only possible with HTTP ranges */
+  if (connections > 1 && (gst_uri_has_protocol (uri, "http")
+      || gst_uri_has_protocol (uri, "https"))) {
+    if ((uri_handler = gst_element_factory_make ("gtuberrangesrc", NULL))) {
+      GST_DEBUG_OBJECT (self, "Using range source with %u connections", connections);
+      g_object_set (uri_handler,
+          "connections", connections,
+          "chunk-size", chunk_size,
+          NULL);
+    }
+  }
+
+  if (!uri_handler)
+    uri_handler = gst_element_make_from_uri (GST_URI_SRC, uri, NULL, NULL);
+
+  return uri_handler;
+}
+
 static gboolean
 gst_gtuber_uri_demux_process_buffer (GstGtuberUriDemux *self, GstBuffer *buffer)
 {
@@ -52,6 +94,7 @@ gst_gtuber_uri_demux_process_buffer (GstGtuberUriDemux *self, GstBuffer *buffer)
   mem = gst_buffer_peek_memory (buffer, 0);
 
   if (mem && gst_memory_map (mem, &info, GST_MAP_READ)) {
+    GstElement *uri_handler;
     GstPad *uri_handler_src, *typefind_sink, *src_ghostpad;
     GstPadLinkReturn pad_link_ret;
 
@@ -71,10 +114,15 @@ gst_gtuber_uri_demux_process_buffer (GstGtuberUriDemux *self, GstBuffer *buffer)
           g_clear_object (&self->typefind_src);
         }
 
-        gst_bin_remove (GST_BIN_CAST (self), self->uri_handler);
-        gst_bin_remove (GST_BIN_CAST (self), self->typefind);
+        uri_handler = self->uri_handler;
 
+        GST_GTUBER_BIN_LOCK (self);
         self->uri_handler = NULL;
+        GST_GTUBER_BIN_UNLOCK (self);
+
+        gst_bin_remove (GST_BIN_CAST (self), uri_handler);
+        gst_bin_remove (GST_BIN_CAST (self), self->typefind);
+
         self->typefind = NULL;
       }
     }
@@ -82,10 +130,10 @@ gst_gtuber_uri_demux_process_buffer (GstGtuberUriDemux *self, GstBuffer *buffer)
     if (!self->uri_handler) {
       GST_DEBUG ("Creating new URI handler element");
 
-      self->uri_handler = gst_element_make_from_uri (GST_URI_SRC,
-          (gchar *) info.data, NULL, NULL);
+      uri_handler = gst_gtuber_uri_demux_make_uri_handler (self,
+          (gchar *) info.data);
 
-      if (G_UNLIKELY (!self->uri_handler)) {
+      if (G_UNLIKELY (!uri_handler)) {
         GST_ERROR ("Could not create URI handler element");
 
         GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN,
@@ -95,9 +143,14 @@ gst_gtuber_uri_demux_process_buffer (GstGtuberUriDemux *self, GstBuffer *buffer)
         return FALSE;
       }
 
-      gst_uri_handler_set_uri (GST_URI_HANDLER (self->uri_handler),
+      gst_uri_handler_set_uri (GST_URI_HANDLER (uri_handler),
           (gchar *) info.data, NULL);
-      gst_bin_add (GST_BIN_CAST (self), self->uri_handler);
+      gst_bin_add (GST_BIN_CAST (self), uri_handler);
+
+      /* Refresh thread might be reading it */
+      GST_GTUBER_BIN_LOCK (self);
+      self->uri_handler = uri_handler;
+      GST_GTUBER_BIN_UNLOCK (self);
 
       self->typefind = gst_element_factory_make ("typefind", NULL);
       gst_bin_add (GST_BIN_CAST (self), self->typefind);
@@ -138,6 +191,38 @@ gst_gtuber_uri_demux_process_buffer (GstGtuberUriDemux *self, GstBuffer *buffer)
   return TRUE;
 }
 
+static gboolean
+gst_gtuber_uri_demux_refresh (GstGtuberBin *bin, const gchar *data)
+{
+  GstGtuberUriDemux *self = GST_GTUBER_URI_DEMUX_CAST (bin);
+  GstElement *uri_handler;
+  gboolean success;
+
+  if (!gst_uri_is_valid (data))
+    return FALSE;
+
+  GST_GTUBER_BIN_LOCK (self);
+  uri_handler = (self->uri_handler) ? gst_object_ref (self->uri_handler) : NULL;
+  GST_GTUBER_BIN_UNLOCK (self);
+
+  if (!uri_handler)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (self, "Refreshed stream URI: %s", data);
+
+  /* Most URI handlers allow changing URI only when not running */
+  gst_element_set_state (uri_handler, GST_STATE_READY);
+
+  if ((success = gst_uri_handler_set_uri (GST_URI_HANDLER (uri_handler), data, NULL)))
+    gst_element_sync_state_with_parent (uri_handler);
+  else
+    GST_ERROR_OBJECT (self, "Could not set refreshed URI");
+
+  gst_object_unref (uri_handler);
+
+  return success;
+}
+
 static gboolean
 gst_gtuber_uri_demux_sink_event (GstPad *pad, GstObject *parent, GstEvent *event)
 {
@@ -190,6 +275,9 @@ gst_gtuber_uri_demux_init (GstGtuberUriDemux *self)
 {
   GstPad *sink_pad;
 
+  self->connections = DEFAULT_CONNECTIONS;
+  self->chunk_size = DEFAULT_CHUNK_SIZE;
+
   self->input_adapter = gst_adapter_new ();
 
   sink_pad = gst_pad_new_from_template (gst_element_class_get_pad_template (
@@ -218,16 +306,80 @@ gst_gtuber_uri_demux_finalize (GObject *object)
   GST_CALL_PARENT (G_OBJECT_CLASS, finalize, (object));
 }
 
+static void
+gst_gtuber_uri_demux_set_property (GObject *object, guint prop_id,
+    const GValue *value, GParamSpec *pspec)
+{
+  GstGtuberUriDemux *self = GST_GTUBER_URI_DEMUX (object);
+
+  GST_GTUBER_BIN_PROP_LOCK (self);
+
+  switch (prop_id) {
+    case PROP_CONNECTIONS:
+      self->connections = g_value_get_uint (value);
+      break;
+    case PROP_CHUNK_SIZE:
+      self->chunk_size = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  GST_GTUBER_BIN_PROP_UNLOCK (self);
+}
+
+static void
+gst_gtuber_uri_demux_get_property (GObject *object, guint prop_id,
+    GValue *value, GParamSpec *pspec)
+{
+  GstGtuberUriDemux *self = GST_GTUBER_URI_DEMUX (object);
+
+  GST_GTUBER_BIN_PROP_LOCK (self);
+
+  switch (prop_id) {
+    case PROP_CONNECTIONS:
+      g_value_set_uint (value, self->connections);
+      break;
+    case PROP_CHUNK_SIZE:
+      g_value_set_uint (value, self->chunk_size);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  GST_GTUBER_BIN_PROP_UNLOCK (self);
+}
+
 static void
 gst_gtuber_uri_demux_class_init (GstGtuberUriDemuxClass *klass)
 {
   GObjectClass *gobject_class = (GObjectClass *) klass;
   GstElementClass *gstelement_class = (GstElementClass *) klass;
+  GstGtuberBinClass *gtuberbin_class = (GstGtuberBinClass *) klass;
 
   GST_DEBUG_CATEGORY_INIT (gst_gtuber_uri_demux_debug, "gtuberuridemux", 0,
       "Gtuber URI demux");
 
   gobject_class->finalize = gst_gtuber_uri_demux_finalize;
+  gobject_class->set_property = gst_gtuber_uri_demux_set_property;
+  gobject_class->get_property = gst_gtuber_uri_demux_get_property;
+  gtuberbin_class->refresh = gst_gtuber_uri_demux_refresh;
+
+  param_specs[PROP_CONNECTIONS] = g_param_spec_uint ("connections",
+      "Connections", "Number of concurrent HTTP range requests used to download "
+      "stream (1 = use regular source element)",
+      1, 16, DEFAULT_CONNECTIONS,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_CHUNK_SIZE] = g_param_spec_uint ("chunk-size",
+      "Chunk Size", "Size of a single HTTP range request in bytes "
+      "when using multiple connections",
+      16 * 1024, G_MAXINT, DEFAULT_CHUNK_SIZE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
 
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
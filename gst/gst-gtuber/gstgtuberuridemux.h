@@ -45,6 +45,10 @@ struct _GstGtuberUriDemux
 {
   GstGtuberBin parent;
 
+  /* < properties > */
+  guint connections;
+  guint chunk_size;
+
   GstAdapter *input_adapter;
 
   GstElement *uri_handler;
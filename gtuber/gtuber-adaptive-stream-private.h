@@ -23,6 +23,22 @@
 
 G_BEGIN_DECLS
 
+typedef struct
+{
+  guint64 start;
+  guint64 end;
+  guint64 duration;
+} GtuberSegmentRef;
+
+typedef struct
+{
+  guint32 timescale;
+  guint64 earliest_pts;
+
+  /* Array of GtuberSegmentRef */
+  GArray *segments;
+} GtuberSegmentIndex;
+
 struct _GtuberAdaptiveStream
 {
   GtuberStream parent;
@@ -34,6 +50,9 @@ struct _GtuberAdaptiveStream
 
   guint64 index_start;
   guint64 index_end;
+
+  /* Set once, when index was prefetched */
+  GtuberSegmentIndex *segment_index;
 };
 
 struct _GtuberAdaptiveStreamClass
@@ -41,4 +60,10 @@ struct _GtuberAdaptiveStreamClass
   GtuberStreamClass parent_class;
 };
 
+G_GNUC_INTERNAL
+gboolean gtuber_adaptive_stream_parse_segment_index (GtuberAdaptiveStream *stream, const guint8 *data, gsize size, guint64 data_offset);
+
+G_GNUC_INTERNAL
+const GtuberSegmentIndex * gtuber_adaptive_stream_get_segment_index (GtuberAdaptiveStream *stream);
+
 G_END_DECLS
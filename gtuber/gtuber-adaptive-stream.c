@@ -29,6 +29,8 @@
  * @title: GtuberAdaptiveStream Development
  */
 
+#include <string.h>
+
 #include "gtuber-stream.h"
 #include "gtuber-stream-private.h"
 #include "gtuber-adaptive-stream.h"
@@ -49,6 +51,7 @@ static GParamSpec *param_specs[PROP_LAST] = { NULL, };
 
 static void gtuber_adaptive_stream_get_property (GObject *object, guint prop_id,
     GValue *value, GParamSpec *pspec);
+static void gtuber_adaptive_stream_finalize (GObject *object);
 
 static void
 gtuber_adaptive_stream_init (GtuberAdaptiveStream *self)
@@ -62,6 +65,8 @@ gtuber_adaptive_stream_init (GtuberAdaptiveStream *self)
 
   self->index_start = 0;
   self->index_end = 0;
+
+  self->segment_index = NULL;
 }
 
 static void
@@ -70,6 +75,7 @@ gtuber_adaptive_stream_class_init (GtuberAdaptiveStreamClass *klass)
   GObjectClass *gobject_class = (GObjectClass *) klass;
 
   gobject_class->get_property = gtuber_adaptive_stream_get_property;
+  gobject_class->finalize = gtuber_adaptive_stream_finalize;
 
   param_specs[PROP_MANIFEST_TYPE] = g_param_spec_enum ("manifest-type",
       "Adaptive Stream Manifest Type", "The manifest type adaptive stream belongs to",
@@ -95,6 +101,24 @@ gtuber_adaptive_stream_get_property (GObject *object, guint prop_id,
   }
 }
 
+static void
+_segment_index_free (GtuberSegmentIndex *index)
+{
+  g_array_unref (index->segments);
+  g_free (index);
+}
+
+static void
+gtuber_adaptive_stream_finalize (GObject *object)
+{
+  GtuberAdaptiveStream *self = GTUBER_ADAPTIVE_STREAM (object);
+
+  if (self->segment_index)
+    _segment_index_free (self->segment_index);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 /**
  * gtuber_adaptive_stream_new:
  *
@@ -233,3 +257,124 @@ gtuber_adaptive_stream_set_index_range (GtuberAdaptiveStream *self,
   self->index_start = start;
   self->index_end = end;
 }
+
+static inline guint16
+_read_uint16_be (const guint8 *data)
+{
+  return ((guint16) data[0] << 8) | data[1];
+}
+
+static inline guint32
+_read_uint32_be (const guint8 *data)
+{
+  return ((guint32) _read_uint16_be (data) << 16) | _read_uint16_be (data + 2);
+}
+
+static inline guint64
+_read_uint64_be (const guint8 *data)
+{
+  return ((guint64) _read_uint32_be (data) << 32) | _read_uint32_be (data + 4);
+}
+
+/*
+ * Parses ISO BMFF "sidx" box found within data that starts at
+ * data_offset byte of the stream. Stores result as stream segment
+ * index, unless some other thread already did that first.
+ */
+gboolean
+gtuber_adaptive_stream_parse_segment_index (GtuberAdaptiveStream *self,
+    const guint8 *data, gsize size, guint64 data_offset)
+{
+  GtuberSegmentIndex *index;
+  const guint8 *box = NULL;
+  guint64 box_size = 0, offset, first_offset;
+  gsize pos = 0, hdr_size;
+  guint8 version;
+  guint16 i, n_refs;
+
+  g_return_val_if_fail (GTUBER_IS_ADAPTIVE_STREAM (self), FALSE);
+
+  /* Find top level "sidx" box */
+  while (pos + 8 <= size) {
+    box_size = _read_uint32_be (data + pos);
+
+    if (box_size < 8)
+      return FALSE;
+
+    if (!memcmp (data + pos + 4, "sidx", 4)) {
+      box = data + pos;
+      break;
+    }
+    pos += box_size;
+  }
+
+  if (!box || pos + box_size > size || box_size < 32)
+    return FALSE;
+
+  version = box[8];
+  hdr_size = (version == 0) ? 32 : 40;
+
+  if (box_size < hdr_size)
+    return FALSE;
+
+  index = g_new (GtuberSegmentIndex, 1);
+  index->timescale = _read_uint32_be (box + 16);
+
+  if (version == 0) {
+    index->earliest_pts = _read_uint32_be (box + 20);
+    first_offset = _read_uint32_be (box + 24);
+  } else {
+    index->earliest_pts = _read_uint64_be (box + 20);
+    first_offset = _read_uint64_be (box + 28);
+  }
+  n_refs = _read_uint16_be (box + hdr_size - 2);
+
+  index->segments = g_array_sized_new (FALSE, FALSE,
+      sizeof (GtuberSegmentRef), n_refs);
+
+  /* Offsets are relative to the first byte after this box */
+  offset = data_offset + pos + box_size + first_offset;
+
+  for (i = 0; i < n_refs; i++) {
+    const guint8 *ref = box + hdr_size + i * 12;
+    GtuberSegmentRef seg;
+    guint32 ref_size;
+
+    if (hdr_size + (i + 1) * 12 > box_size)
+      goto error;
+
+    ref_size = _read_uint32_be (ref);
+
+    /* Hierarchical indexes are not supported */
+    if (ref_size & 0x80000000)
+      goto error;
+
+    seg.start = offset;
+    seg.end = offset + ref_size - 1;
+    seg.duration = _read_uint32_be (ref + 4);
+
+    g_array_append_val (index->segments, seg);
+    offset += ref_size;
+  }
+
+  if (index->timescale == 0 || index->segments->len == 0)
+    goto error;
+
+  if (!g_atomic_pointer_compare_and_exchange (&self->segment_index, NULL, index))
+    _segment_index_free (index);
+
+  return TRUE;
+
+error:
+  _segment_index_free (index);
+
+  return FALSE;
+}
+
+const GtuberSegmentIndex *
+gtuber_adaptive_stream_get_segment_index (GtuberAdaptiveStream *self)
+{
+  g_return_val_if_fail (GTUBER_IS_ADAPTIVE_STREAM (self), NULL);
+
+  return g_atomic_pointer_get (&self->segment_index);
+}
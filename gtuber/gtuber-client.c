@@ -30,9 +30,13 @@
 #include "gtuber-client.h"
 #include "gtuber-media-info.h"
 #include "gtuber-media-info-private.h"
+#include "gtuber-adaptive-stream-private.h"
 #include "gtuber-loader-private.h"
 #include "gtuber-website.h"
 
+#define CHUNK_SIZE 16384
+#define MAX_INDEX_PREFETCH_SIZE (512 * 1024)
+
 struct _GtuberClient
 {
   GObject parent;
@@ -104,6 +108,334 @@ gtuber_client_verify_media_info (GtuberClient *self,
       "Plugin returned media info without any streams");
 }
 
+static GtuberFlow
+gtuber_client_feed_data_chunks (GtuberClient *self, GtuberWebsite *website,
+    GInputStream *stream, GtuberMediaInfo *info, gboolean *finished,
+    GCancellable *cancellable, GError **error)
+{
+  GtuberWebsiteClass *website_class = GTUBER_WEBSITE_GET_CLASS (website);
+  GtuberFlow flow = GTUBER_FLOW_OK;
+  gchar *buf;
+
+  buf = g_malloc (CHUNK_SIZE);
+
+  while (!*finished) {
+    gssize n_read;
+
+    n_read = g_input_stream_read (stream, buf, CHUNK_SIZE, cancellable, error);
+    if (n_read < 0) {
+      flow = GTUBER_FLOW_ERROR;
+      break;
+    }
+
+    flow = website_class->parse_data_chunk (website,
+        (n_read > 0) ? buf : NULL, n_read, info, finished, error);
+
+    if (*error)
+      flow = GTUBER_FLOW_ERROR;
+    if (flow != GTUBER_FLOW_OK || n_read == 0)
+      break;
+  }
+
+  g_free (buf);
+
+  if (*finished)
+    g_debug ("Plugin finished parsing before end of data");
+
+  return flow;
+}
+
+typedef struct
+{
+  SoupMessage *msg;
+  GBytes *bytes;
+  GError *error;
+  guint *n_pending;
+
+  /* Requests in order of completion */
+  GPtrArray *completed;
+} GtuberClientFanoutRequest;
+
+static void
+_fanout_request_free (GtuberClientFanoutRequest *req)
+{
+  if (req->bytes)
+    g_bytes_unref (req->bytes);
+  if (req->error)
+    g_error_free (req->error);
+
+  g_free (req);
+}
+
+static void
+_fanout_send_and_read_cb (SoupSession *session, GAsyncResult *res,
+    GtuberClientFanoutRequest *req)
+{
+  req->bytes = soup_session_send_and_read_finish (session, res, &req->error);
+  g_ptr_array_add (req->completed, req);
+  (*req->n_pending)--;
+}
+
+static void
+_fanout_cancel_race_cb (GCancellable *cancellable, GCancellable *race_cancellable)
+{
+  g_cancellable_cancel (race_cancellable);
+}
+
+static GtuberFlow
+gtuber_client_read_fanout (GtuberClient *self, GtuberWebsite *website,
+    GPtrArray *msgs, GPtrArray *reqs, GtuberMediaInfo *info,
+    GCancellable *cancellable, GError **error)
+{
+  GtuberWebsiteClass *website_class = GTUBER_WEBSITE_GET_CLASS (website);
+  GtuberFlow flow = GTUBER_FLOW_OK;
+  GPtrArray *bodies;
+  guint i;
+
+  bodies = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+
+  g_debug ("Reading responses...");
+  for (i = 0; i < reqs->len; i++) {
+    GtuberClientFanoutRequest *req = g_ptr_array_index (reqs, i);
+
+    if (req->error) {
+      if (!g_cancellable_is_cancelled (cancellable)) {
+        g_debug ("Fanout request failed: %s", req->error->message);
+        flow = website_class->send_failed (website, req->msg, &req->error);
+      }
+      if (req->error) {
+        g_propagate_error (error, req->error);
+        req->error = NULL;
+        flow = GTUBER_FLOW_ERROR;
+      }
+      if (flow != GTUBER_FLOW_OK)
+        break;
+
+      /* Plugin decided to carry on without this response */
+      g_ptr_array_add (bodies, g_bytes_new (NULL, 0));
+      continue;
+    }
+
+    flow = website_class->read_response (website, req->msg, error);
+
+    if (*error)
+      flow = GTUBER_FLOW_ERROR;
+    if (flow != GTUBER_FLOW_OK)
+      break;
+
+    g_ptr_array_add (bodies, g_bytes_ref (req->bytes));
+  }
+
+  if (flow == GTUBER_FLOW_OK) {
+    g_debug ("Parsing fanout responses...");
+    flow = website_class->parse_responses (website, msgs, bodies, info, error);
+
+    if (*error)
+      flow = GTUBER_FLOW_ERROR;
+  }
+
+  g_ptr_array_unref (bodies);
+
+  return flow;
+}
+
+static GtuberFlow
+gtuber_client_race_fanout (GtuberClient *self, GtuberWebsite *website,
+    GMainContext *context, GPtrArray *completed, guint *n_pending,
+    GtuberMediaInfo *info, SoupMessage **winner,
+    GCancellable *cancellable, GError **error)
+{
+  GtuberWebsiteClass *website_class = GTUBER_WEBSITE_GET_CLASS (website);
+  GtuberFlow flow = GTUBER_FLOW_OK;
+  GError *last_error = NULL;
+  guint next = 0;
+
+  g_debug ("Racing responses...");
+  while (*n_pending > 0 || next < completed->len) {
+    GtuberClientFanoutRequest *req;
+    GPtrArray *msgs, *bodies;
+    GError *my_error = NULL;
+
+    if (next == completed->len) {
+      g_main_context_iteration (context, TRUE);
+      continue;
+    }
+    req = g_ptr_array_index (completed, next++);
+
+    if (req->error) {
+      if (g_cancellable_is_cancelled (cancellable)) {
+        g_propagate_error (error, req->error);
+        req->error = NULL;
+        return GTUBER_FLOW_ERROR;
+      }
+
+      g_debug ("Fanout request failed: %s", req->error->message);
+      flow = website_class->send_failed (website, req->msg, &req->error);
+
+      if (req->error) {
+        g_clear_error (&last_error);
+        last_error = req->error;
+        req->error = NULL;
+      } else if (flow != GTUBER_FLOW_OK) {
+        break;
+      }
+      continue;
+    }
+
+    flow = website_class->read_response (website, req->msg, &my_error);
+
+    if (!my_error && flow != GTUBER_FLOW_OK)
+      break;
+
+    if (!my_error) {
+      msgs = g_ptr_array_new ();
+      g_ptr_array_add (msgs, req->msg);
+
+      bodies = g_ptr_array_new ();
+      g_ptr_array_add (bodies, req->bytes);
+
+      flow = website_class->parse_responses (website, msgs, bodies, info, &my_error);
+
+      g_ptr_array_unref (msgs);
+      g_ptr_array_unref (bodies);
+    }
+
+    /* Response rejected by plugin, wait for another one */
+    if (my_error) {
+      g_debug ("Fanout response rejected: %s", my_error->message);
+      g_clear_error (&last_error);
+      last_error = my_error;
+      continue;
+    }
+
+    *winner = req->msg;
+    break;
+  }
+
+  if (!*winner && flow == GTUBER_FLOW_OK) {
+    if (last_error) {
+      g_propagate_error (error, last_error);
+      last_error = NULL;
+    } else {
+      g_set_error (error, GTUBER_WEBSITE_ERROR,
+          GTUBER_WEBSITE_ERROR_OTHER,
+          "None of the fanout responses was accepted");
+    }
+    flow = GTUBER_FLOW_ERROR;
+  }
+
+  g_clear_error (&last_error);
+
+  return flow;
+}
+
+static GtuberFlow
+gtuber_client_send_fanout (GtuberClient *self, GtuberWebsite *website,
+    SoupSession *session, GMainContext *context, GtuberMediaInfo *info,
+    SoupMessage **last_msg, guint *n_requests, GCancellable *cancellable,
+    GError **error)
+{
+  GtuberWebsiteClass *website_class = GTUBER_WEBSITE_GET_CLASS (website);
+  GtuberFlow flow;
+  GPtrArray *msgs, *reqs, *completed;
+  GCancellable *race_cancellable = NULL;
+  SoupMessage *winner = NULL;
+  gulong cancel_id = 0;
+  gboolean race;
+  guint i, n_pending = 0;
+
+  msgs = g_ptr_array_new_with_free_func (g_object_unref);
+
+  g_debug ("Creating fanout requests...");
+  flow = website_class->create_requests (website, info, msgs, error);
+
+  if (*error)
+    flow = GTUBER_FLOW_ERROR;
+  if (flow != GTUBER_FLOW_OK)
+    goto finish;
+
+  if (msgs->len == 0) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_OTHER,
+        "Plugin fanout request messages have not been created");
+    flow = GTUBER_FLOW_ERROR;
+    goto finish;
+  }
+
+  /* In race mode, requests still in flight are cancelled
+   * as soon as plugin accepts one of the responses */
+  if ((race = gtuber_website_get_fanout_race (website))) {
+    race_cancellable = g_cancellable_new ();
+
+    if (cancellable) {
+      cancel_id = g_cancellable_connect (cancellable,
+          G_CALLBACK (_fanout_cancel_race_cb), race_cancellable, NULL);
+    }
+  }
+
+  reqs = g_ptr_array_new_with_free_func ((GDestroyNotify) _fanout_request_free);
+  completed = g_ptr_array_new ();
+
+  g_debug ("Sending %u requests...", msgs->len);
+  *n_requests += msgs->len;
+
+  for (i = 0; i < msgs->len; i++) {
+    SoupMessage *msg = g_ptr_array_index (msgs, i);
+    GtuberClientFanoutRequest *req;
+
+    gtuber_client_configure_msg (self, msg);
+
+    req = g_new0 (GtuberClientFanoutRequest, 1);
+    req->msg = msg;
+    req->n_pending = &n_pending;
+    req->completed = completed;
+    g_ptr_array_add (reqs, req);
+
+    n_pending++;
+    soup_session_send_and_read_async (session, msg, G_PRIORITY_DEFAULT,
+        (race) ? race_cancellable : cancellable,
+        (GAsyncReadyCallback) _fanout_send_and_read_cb, req);
+  }
+
+  if (race) {
+    flow = gtuber_client_race_fanout (self, website, context, completed,
+        &n_pending, info, &winner, cancellable, error);
+
+    /* Drop the remaining requests */
+    g_cancellable_cancel (race_cancellable);
+  }
+
+  while (n_pending > 0)
+    g_main_context_iteration (context, TRUE);
+
+  if (!race) {
+    flow = gtuber_client_read_fanout (self, website, msgs, reqs,
+        info, cancellable, error);
+  }
+
+  g_ptr_array_unref (completed);
+  g_ptr_array_unref (reqs);
+
+  if (*error)
+    flow = GTUBER_FLOW_ERROR;
+  if (flow != GTUBER_FLOW_OK)
+    goto finish;
+
+  /* Last (or accepted) message is used for user request headers */
+  *last_msg = g_object_ref ((winner) ? winner
+      : g_ptr_array_index (msgs, msgs->len - 1));
+
+finish:
+  if (race_cancellable) {
+    g_cancellable_disconnect (cancellable, cancel_id);
+    g_object_unref (race_cancellable);
+  }
+
+  g_ptr_array_unref (msgs);
+
+  return flow;
+}
+
 /**
  * gtuber_client_new:
  *
@@ -117,27 +449,18 @@ gtuber_client_new (void)
   return g_object_new (GTUBER_TYPE_CLIENT, NULL);
 }
 
-/**
- * gtuber_client_fetch_media_info:
- * @client: a #GtuberClient
- * @uri: a media source URI
- * @cancellable: (nullable): optional #GCancellable object,
- *     %NULL to ignore
- * @error: (nullable): return location for a #GError, or %NULL
- *
- * Synchronously obtains media info for requested URI.
- *
- * Returns: (transfer full): a #GtuberMediaInfo or %NULL on error.
- */
-GtuberMediaInfo *
-gtuber_client_fetch_media_info (GtuberClient *self, const gchar *uri,
-    GCancellable *cancellable, GError **error)
+static GtuberMediaInfo *
+gtuber_client_fetch_media_info_internal (GtuberClient *self, const gchar *uri,
+    SoupSession *user_session, GCancellable *cancellable, GError **error)
 {
   GtuberMediaInfo *info = NULL;
   GtuberWebsite *website = NULL;
   GtuberWebsiteClass *website_class;
   GtuberFlow flow = GTUBER_FLOW_ERROR;
+  gboolean finished = FALSE;
+  guint n_requests = 0;
 
+  GMainContext *context;
   SoupSession *session = NULL;
   SoupMessage *msg = NULL;
   GInputStream *stream = NULL;
@@ -146,12 +469,17 @@ gtuber_client_fetch_media_info (GtuberClient *self, const gchar *uri,
   GModule *module = NULL;
   GError *my_error = NULL;
 
-  g_return_val_if_fail (GTUBER_IS_CLIENT (self), NULL);
-  g_return_val_if_fail (uri != NULL, NULL);
-  g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
-
   g_debug ("Requested URI: %s", uri);
 
+  /* Private context for concurrent requests, unless caller
+   * keeps session (and its connections) within its own one */
+  if (user_session) {
+    context = g_main_context_ref_thread_default ();
+  } else {
+    context = g_main_context_new ();
+    g_main_context_push_thread_default (context);
+  }
+
   guri = g_uri_parse (uri, G_URI_FLAGS_ENCODED, &my_error);
   if (!guri)
     goto error;
@@ -170,6 +498,10 @@ reconfigure:
 
     g_free (latest_uri);
 
+    if (!user_session)
+      g_main_context_pop_thread_default (context);
+    g_main_context_unref (context);
+
     return NULL;
   }
   g_uri_unref (guri);
@@ -179,16 +511,28 @@ reconfigure:
 
   info = g_object_new (GTUBER_TYPE_MEDIA_INFO, NULL);
 
-  session = soup_session_new_with_options (
-      "timeout", 7,
-      NULL);
+  session = (user_session)
+      ? g_object_ref (user_session)
+      : soup_session_new_with_options (
+          "timeout", 7,
+          NULL);
 
 beginning:
+  finished = FALSE;
+
   g_debug ("Creating request...");
   flow = website_class->create_request (website, info, &msg, &my_error);
 
   if (my_error)
     flow = GTUBER_FLOW_ERROR;
+  if (flow == GTUBER_FLOW_FANOUT) {
+    flow = gtuber_client_send_fanout (self, website, session, context,
+        info, &msg, &n_requests, cancellable, &my_error);
+    if (flow != GTUBER_FLOW_OK)
+      goto decide_flow;
+
+    goto parsed;
+  }
   if (flow != GTUBER_FLOW_OK)
     goto decide_flow;
   if (!msg)
@@ -198,25 +542,58 @@ beginning:
 
   g_debug ("Sending request...");
   stream = soup_session_send (session, msg, cancellable, &my_error);
+  n_requests++;
+
+  if (my_error && !g_cancellable_is_cancelled (cancellable)) {
+    g_debug ("Request failed: %s", my_error->message);
+    flow = website_class->send_failed (website, msg, &my_error);
+
+    /* Only retrying makes sense here */
+    if (my_error || flow == GTUBER_FLOW_OK)
+      flow = GTUBER_FLOW_ERROR;
+
+    goto decide_flow;
+  }
 
   if (!my_error) {
     g_debug ("Reading response...");
     flow = website_class->read_response (website, msg, &my_error);
 
-    if (flow != GTUBER_FLOW_OK)
-      goto decide_flow;
+    /* Body is not wanted, but stream still needs closing */
+    if (my_error || flow != GTUBER_FLOW_OK)
+      finished = TRUE;
   }
 
-  if (!my_error) {
-    g_debug ("Parsing response input stream...");
-    flow = website_class->parse_input_stream (website, stream, info, &my_error);
+  if (!my_error && flow == GTUBER_FLOW_OK) {
+    if (gtuber_website_get_chunked_parse (website)) {
+      g_debug ("Parsing response data chunks...");
+      flow = gtuber_client_feed_data_chunks (self, website, stream, info,
+          &finished, cancellable, &my_error);
+    } else {
+      g_debug ("Parsing response input stream...");
+      flow = website_class->parse_input_stream (website, stream, info, &my_error);
+    }
   }
   if (stream) {
-    if (g_input_stream_close (stream, NULL, NULL))
+    GCancellable *close_cancellable = NULL;
+
+    /* Closing with cancelled cancellable makes soup drop the
+     * connection instead of reading the rest of the body */
+    if (finished) {
+      close_cancellable = g_cancellable_new ();
+      g_cancellable_cancel (close_cancellable);
+    }
+
+    if (g_input_stream_close (stream, close_cancellable, NULL))
       g_debug ("Input stream closed");
+    else if (finished)
+      g_debug ("Input stream closed before end of data");
     else
       g_warning ("Input stream could not be closed");
 
+    if (close_cancellable)
+      g_object_unref (close_cancellable);
+
     g_object_unref (stream);
   }
 
@@ -225,6 +602,7 @@ beginning:
   if (flow != GTUBER_FLOW_OK)
     goto decide_flow;
 
+parsed:
   g_debug ("Parsed response");
 
   if (!my_error) {
@@ -244,6 +622,9 @@ beginning:
   if (flow != GTUBER_FLOW_OK)
     goto decide_flow;
 
+  gtuber_media_info_set_fetch_stats (info,
+      G_OBJECT_TYPE_NAME (website), n_requests);
+
 error:
   if (msg)
     g_object_unref (msg);
@@ -254,6 +635,10 @@ error:
   if (module)
     gtuber_loader_close_module (module);
 
+  if (!user_session)
+    g_main_context_pop_thread_default (context);
+  g_main_context_unref (context);
+
 invalid_info:
   if (my_error) {
     g_propagate_error (error, my_error);
@@ -298,6 +683,13 @@ decide_flow:
         module = NULL;
       }
       goto reconfigure;
+    case GTUBER_FLOW_FANOUT:
+      if (!my_error) {
+        g_set_error (&my_error, GTUBER_WEBSITE_ERROR,
+            GTUBER_WEBSITE_ERROR_OTHER,
+            "Plugin requested fanout outside of request creation");
+      }
+      goto error;
     case GTUBER_FLOW_ERROR:
       if (!my_error) {
         g_set_error (&my_error, GTUBER_WEBSITE_ERROR,
@@ -311,6 +703,62 @@ decide_flow:
   }
 }
 
+/**
+ * gtuber_client_fetch_media_info:
+ * @client: a #GtuberClient
+ * @uri: a media source URI
+ * @cancellable: (nullable): optional #GCancellable object,
+ *     %NULL to ignore
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * Synchronously obtains media info for requested URI.
+ *
+ * Returns: (transfer full): a #GtuberMediaInfo or %NULL on error.
+ */
+GtuberMediaInfo *
+gtuber_client_fetch_media_info (GtuberClient *self, const gchar *uri,
+    GCancellable *cancellable, GError **error)
+{
+  g_return_val_if_fail (GTUBER_IS_CLIENT (self), NULL);
+  g_return_val_if_fail (uri != NULL, NULL);
+  g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+
+  return gtuber_client_fetch_media_info_internal (self, uri,
+      NULL, cancellable, error);
+}
+
+/**
+ * gtuber_client_fetch_media_info_with_session:
+ * @client: a #GtuberClient
+ * @uri: a media source URI
+ * @session: a #SoupSession to send requests with
+ * @cancellable: (nullable): optional #GCancellable object,
+ *     %NULL to ignore
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * Same as gtuber_client_fetch_media_info(), but sends all requests
+ *   with passed @session, so its connections can be reused by the
+ *   following fetches.
+ *
+ * Concurrent requests are dispatched within the thread-default
+ *   #GMainContext of calling thread, which should always be the same
+ *   one when using given @session.
+ *
+ * Returns: (transfer full): a #GtuberMediaInfo or %NULL on error.
+ */
+GtuberMediaInfo *
+gtuber_client_fetch_media_info_with_session (GtuberClient *self, const gchar *uri,
+    SoupSession *session, GCancellable *cancellable, GError **error)
+{
+  g_return_val_if_fail (GTUBER_IS_CLIENT (self), NULL);
+  g_return_val_if_fail (uri != NULL, NULL);
+  g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+  g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+
+  return gtuber_client_fetch_media_info_internal (self, uri,
+      session, cancellable, error);
+}
+
 static void
 fetch_media_info_async_thread (GTask *task, gpointer source, gpointer task_data,
     GCancellable *cancellable)
@@ -388,3 +836,502 @@ gtuber_client_fetch_media_info_finish (GtuberClient *self, GAsyncResult *res,
 
   return g_task_propagate_pointer (G_TASK (res), error);
 }
+
+/* Default number of collection entries resolved at once */
+#define COLLECTION_DEFAULT_PARALLEL 4
+
+typedef struct
+{
+  GtuberClient *client;
+  GtuberWebsite *website;
+  SoupSession *session;
+  GCancellable *cancellable;
+
+  GtuberCollectionEntryFunc func;
+  gpointer user_data;
+
+  /* Entry URIs waiting for resolution */
+  GQueue *queue;
+  guint max_parallel;
+  guint n_running;
+
+  SoupMessage *page_msg;
+
+  GError *error;
+} GtuberClientCollection;
+
+typedef struct
+{
+  GtuberClientCollection *col;
+  gchar *uri;
+} GtuberClientCollectionEntry;
+
+static void _collection_page_cb (SoupSession *session, GAsyncResult *res,
+    GtuberClientCollection *col);
+
+static void
+_collection_request_page (GtuberClientCollection *col, const gchar *continuation)
+{
+  GtuberWebsiteClass *website_class = GTUBER_WEBSITE_GET_CLASS (col->website);
+  SoupMessage *msg = NULL;
+  GtuberFlow flow;
+
+  g_debug ("Creating collection request, continuation: %s", continuation);
+  flow = website_class->create_collection_request (col->website,
+      continuation, &msg, &col->error);
+
+  if (!col->error && (flow != GTUBER_FLOW_OK || !msg)) {
+    if (!continuation) {
+      g_set_error (&col->error, GTUBER_CLIENT_ERROR,
+          GTUBER_CLIENT_ERROR_NO_COLLECTION,
+          "Plugin cannot expand URI into a collection");
+    } else {
+      g_set_error (&col->error, GTUBER_WEBSITE_ERROR,
+          GTUBER_WEBSITE_ERROR_OTHER,
+          "Plugin could not request next collection page");
+    }
+  }
+  if (col->error) {
+    g_clear_object (&msg);
+    return;
+  }
+
+  gtuber_client_configure_msg (col->client, msg);
+  col->page_msg = msg;
+
+  soup_session_send_and_read_async (col->session, msg, G_PRIORITY_DEFAULT,
+      col->cancellable, (GAsyncReadyCallback) _collection_page_cb, col);
+}
+
+static void
+_collection_page_cb (SoupSession *session, GAsyncResult *res,
+    GtuberClientCollection *col)
+{
+  GtuberWebsiteClass *website_class = GTUBER_WEBSITE_GET_CLASS (col->website);
+  SoupMessage *msg = col->page_msg;
+  GBytes *bytes;
+  GInputStream *stream;
+  GPtrArray *entries;
+  gchar *continuation = NULL;
+  GtuberFlow flow = GTUBER_FLOW_ERROR;
+  guint i;
+
+  col->page_msg = NULL;
+
+  bytes = soup_session_send_and_read_finish (session, res, &col->error);
+  if (col->error)
+    goto finish;
+
+  flow = website_class->read_response (col->website, msg, &col->error);
+  if (col->error || flow != GTUBER_FLOW_OK)
+    goto finish;
+
+  entries = g_ptr_array_new_with_free_func (g_free);
+
+  g_debug ("Parsing collection page...");
+  stream = g_memory_input_stream_new_from_bytes (bytes);
+  flow = website_class->parse_collection_page (col->website,
+      stream, entries, &continuation, &col->error);
+  g_object_unref (stream);
+
+  if (!col->error && flow == GTUBER_FLOW_OK) {
+    g_debug ("Collection page entries: %u", entries->len);
+
+    for (i = 0; i < entries->len; i++)
+      g_queue_push_tail (col->queue, g_strdup (g_ptr_array_index (entries, i)));
+  }
+  g_ptr_array_unref (entries);
+
+finish:
+  if (!col->error && flow != GTUBER_FLOW_OK) {
+    g_set_error (&col->error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_OTHER,
+        "Plugin could not read collection page");
+  }
+
+  /* Request next page while current entries are resolved */
+  if (!col->error && continuation)
+    _collection_request_page (col, continuation);
+
+  g_free (continuation);
+
+  if (bytes)
+    g_bytes_unref (bytes);
+
+  g_object_unref (msg);
+}
+
+static void
+_collection_entry_cb (GtuberClient *self, GAsyncResult *res,
+    GtuberClientCollectionEntry *entry)
+{
+  GtuberClientCollection *col = entry->col;
+  GtuberMediaInfo *info;
+  GError *error = NULL;
+
+  info = gtuber_client_fetch_media_info_finish (self, res, &error);
+
+  /* Entries cancelled after collection failed are not reported */
+  if (!col->error)
+    col->func (self, entry->uri, info, error, col->user_data);
+
+  if (info)
+    g_object_unref (info);
+  if (error)
+    g_error_free (error);
+
+  g_free (entry->uri);
+  g_free (entry);
+
+  col->n_running--;
+}
+
+static void
+_collection_cancelled_cb (GCancellable *cancellable, GCancellable *col_cancellable)
+{
+  g_cancellable_cancel (col_cancellable);
+}
+
+static void
+_collection_resolve_next (GtuberClientCollection *col)
+{
+  while (!col->error && col->n_running < col->max_parallel
+      && !g_queue_is_empty (col->queue)) {
+    GtuberClientCollectionEntry *entry;
+
+    entry = g_new0 (GtuberClientCollectionEntry, 1);
+    entry->col = col;
+    entry->uri = g_queue_pop_head (col->queue);
+
+    g_debug ("Resolving collection entry: %s", entry->uri);
+
+    col->n_running++;
+    gtuber_client_fetch_media_info_async (col->client, entry->uri, col->cancellable,
+        (GAsyncReadyCallback) _collection_entry_cb, entry);
+  }
+}
+
+/**
+ * gtuber_client_expand_collection:
+ * @client: a #GtuberClient
+ * @uri: a collection (e.g. playlist or channel) URI
+ * @max_parallel: maximal number of entries to resolve at once or 0 for default
+ * @func: (scope call): a #GtuberCollectionEntryFunc to call for each entry
+ * @user_data: (closure): the data to pass to @func
+ * @cancellable: (nullable): optional #GCancellable object,
+ *     %NULL to ignore
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * Synchronously expands collection into its entries and obtains media info
+ * of each of them. Collection pages are requested one after another while
+ * entries from already received pages are being resolved in parallel.
+ *
+ * @func is called from the calling thread as soon as each entry is resolved
+ * (not necessarily in collection order), also for entries that failed.
+ * When expanding collection itself fails, entries that are still being
+ * resolved are cancelled and not passed to @func.
+ *
+ * Returns: %TRUE if whole collection was expanded, %FALSE on error.
+ */
+gboolean
+gtuber_client_expand_collection (GtuberClient *self, const gchar *uri,
+    guint max_parallel, GtuberCollectionEntryFunc func, gpointer user_data,
+    GCancellable *cancellable, GError **error)
+{
+  GtuberClientCollection col = { NULL, };
+  GMainContext *context;
+  GModule *module = NULL;
+  GUri *guri;
+  gulong cancel_id = 0;
+  gboolean success;
+
+  g_return_val_if_fail (GTUBER_IS_CLIENT (self), FALSE);
+  g_return_val_if_fail (uri != NULL, FALSE);
+  g_return_val_if_fail (func != NULL, FALSE);
+  g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+
+  g_debug ("Requested collection URI: %s", uri);
+
+  context = g_main_context_new ();
+  g_main_context_push_thread_default (context);
+
+  guri = g_uri_parse (uri, G_URI_FLAGS_ENCODED, &col.error);
+  if (!guri)
+    goto finish;
+
+  col.website = gtuber_loader_get_website_for_uri (guri, &module);
+  g_uri_unref (guri);
+
+  if (!col.website) {
+    g_debug ("No plugin for URI: %s", uri);
+    g_set_error (&col.error, GTUBER_CLIENT_ERROR, GTUBER_CLIENT_ERROR_NO_PLUGIN,
+        "None of the installed plugins could handle URI: %s", uri);
+    goto finish;
+  }
+
+  GTUBER_WEBSITE_GET_CLASS (col.website)->prepare (col.website);
+
+  col.client = self;
+  col.session = soup_session_new_with_options (
+      "timeout", 7,
+      NULL);
+  col.func = func;
+  col.user_data = user_data;
+  col.queue = g_queue_new ();
+  col.max_parallel = (max_parallel > 0) ? max_parallel : COLLECTION_DEFAULT_PARALLEL;
+
+  /* Own cancellable, so remaining entries can be stopped on error */
+  col.cancellable = g_cancellable_new ();
+  if (cancellable) {
+    cancel_id = g_cancellable_connect (cancellable,
+        G_CALLBACK (_collection_cancelled_cb), col.cancellable, NULL);
+  }
+
+  _collection_request_page (&col, NULL);
+
+  while (TRUE) {
+    _collection_resolve_next (&col);
+
+    if (!col.page_msg && col.n_running == 0)
+      break;
+
+    /* Do not wait for entries that are no longer needed */
+    if (col.error && !g_cancellable_is_cancelled (col.cancellable)) {
+      g_debug ("Collection failed, cancelling %u running entries", col.n_running);
+      g_cancellable_cancel (col.cancellable);
+    }
+
+    g_main_context_iteration (context, TRUE);
+  }
+
+  if (cancel_id)
+    g_cancellable_disconnect (cancellable, cancel_id);
+  g_object_unref (col.cancellable);
+
+  g_queue_free_full (col.queue, (GDestroyNotify) g_free);
+  g_object_unref (col.session);
+  g_object_unref (col.website);
+
+finish:
+  if (module)
+    gtuber_loader_close_module (module);
+
+  g_main_context_pop_thread_default (context);
+  g_main_context_unref (context);
+
+  if ((success = (col.error == NULL)))
+    g_debug ("Collection expanded");
+  else
+    g_propagate_error (error, col.error);
+
+  return success;
+}
+
+typedef struct
+{
+  GtuberAdaptiveStream *astream;
+  SoupMessage *msg;
+  guint64 offset;
+  guint *n_running;
+} GtuberClientIndexRequest;
+
+static void
+_index_send_and_read_cb (SoupSession *session, GAsyncResult *res,
+    GtuberClientIndexRequest *req)
+{
+  GBytes *bytes;
+  GError *my_error = NULL;
+  guint itag = gtuber_stream_get_itag (GTUBER_STREAM (req->astream));
+
+  bytes = soup_session_send_and_read_finish (session, res, &my_error);
+
+  if (my_error) {
+    g_debug ("Could not prefetch index of itag %u: %s", itag, my_error->message);
+    g_error_free (my_error);
+  } else if (soup_message_get_status (req->msg) != SOUP_STATUS_PARTIAL_CONTENT) {
+    g_debug ("Could not prefetch index of itag %u, HTTP status: %u",
+        itag, soup_message_get_status (req->msg));
+  } else if (!gtuber_adaptive_stream_parse_segment_index (req->astream,
+      g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes), req->offset)) {
+    g_debug ("No usable segment index in itag %u", itag);
+  } else {
+    g_debug ("Prefetched segment index of itag %u", itag);
+  }
+
+  if (bytes)
+    g_bytes_unref (bytes);
+
+  (*req->n_running)--;
+
+  g_object_unref (req->msg);
+  g_object_unref (req->astream);
+  g_free (req);
+}
+
+static gboolean
+gtuber_client_prefetch_segment_indexes_internal (GtuberClient *self, GtuberMediaInfo *info,
+    GtuberAdaptiveStreamFilter filter, gpointer user_data, SoupSession *user_session,
+    GCancellable *cancellable, GError **error)
+{
+  GMainContext *context;
+  SoupSession *session;
+  GPtrArray *adaptive_streams;
+  GHashTable *req_headers;
+  guint i, n_running = 0;
+
+  adaptive_streams = gtuber_media_info_get_adaptive_streams (info);
+  req_headers = gtuber_media_info_get_request_headers (info);
+
+  /* User session dispatches within the context it was made in */
+  if (user_session) {
+    context = g_main_context_ref_thread_default ();
+  } else {
+    context = g_main_context_new ();
+    g_main_context_push_thread_default (context);
+  }
+
+  session = (user_session)
+      ? g_object_ref (user_session)
+      : soup_session_new_with_options (
+          "timeout", 7,
+          NULL);
+
+  for (i = 0; adaptive_streams && i < adaptive_streams->len; i++) {
+    GtuberAdaptiveStream *astream = g_ptr_array_index (adaptive_streams, i);
+    GtuberStream *stream = GTUBER_STREAM (astream);
+    GtuberClientIndexRequest *req;
+    SoupMessage *msg;
+    SoupMessageHeaders *headers;
+    guint64 init_start, init_end, index_start, index_end;
+
+    switch (gtuber_stream_get_mime_type (stream)) {
+      case GTUBER_STREAM_MIME_TYPE_VIDEO_MP4:
+      case GTUBER_STREAM_MIME_TYPE_AUDIO_MP4:
+        break;
+      default:
+        continue;
+    }
+
+    if (gtuber_adaptive_stream_get_manifest_type (astream) != GTUBER_ADAPTIVE_STREAM_MANIFEST_DASH
+        || gtuber_adaptive_stream_get_segment_index (astream)
+        || !gtuber_adaptive_stream_get_init_range (astream, &init_start, &init_end)
+        || !gtuber_adaptive_stream_get_index_range (astream, &index_start, &index_end))
+      continue;
+
+    /* One request covering both, index usually directly follows init */
+    if (index_start < init_start || index_end - init_start >= MAX_INDEX_PREFETCH_SIZE)
+      continue;
+
+    if (filter && !filter (astream, user_data))
+      continue;
+
+    if (!(msg = soup_message_new ("GET", gtuber_stream_get_uri (stream))))
+      continue;
+
+    headers = soup_message_get_request_headers (msg);
+
+    if (req_headers) {
+      GHashTableIter iter;
+      gpointer key, value;
+
+      g_hash_table_iter_init (&iter, req_headers);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        soup_message_headers_replace (headers, key, value);
+    }
+    soup_message_headers_set_range (headers, init_start, index_end);
+    gtuber_client_configure_msg (self, msg);
+
+    req = g_new (GtuberClientIndexRequest, 1);
+    req->astream = g_object_ref (astream);
+    req->msg = msg;
+    req->offset = init_start;
+    req->n_running = &n_running;
+
+    n_running++;
+    soup_session_send_and_read_async (session, msg, G_PRIORITY_DEFAULT,
+        cancellable, (GAsyncReadyCallback) _index_send_and_read_cb, req);
+  }
+
+  while (n_running > 0)
+    g_main_context_iteration (context, TRUE);
+
+  g_object_unref (session);
+
+  if (!user_session)
+    g_main_context_pop_thread_default (context);
+  g_main_context_unref (context);
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return FALSE;
+
+  return TRUE;
+}
+
+/**
+ * gtuber_client_prefetch_segment_indexes:
+ * @client: a #GtuberClient
+ * @info: a #GtuberMediaInfo
+ * @filter: (nullable) (scope call): a #GtuberAdaptiveStreamFilter
+ * @user_data: (closure): the data to pass to @filter
+ * @cancellable: (nullable): optional #GCancellable object,
+ *     %NULL to ignore
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * Synchronously downloads initialization and index byte ranges of
+ * MP4 adaptive streams within @info (these that pass @filter) in parallel,
+ * one request per stream. Segments found in stream index are then listed
+ * directly within generated DASH manifest, so player does not have to
+ * download stream index before requesting the first media segment.
+ *
+ * Failing to prefetch index of some stream is not an error,
+ * such stream will be described by its index range as usual.
+ *
+ * Returns: %TRUE if finished, %FALSE when cancelled.
+ */
+gboolean
+gtuber_client_prefetch_segment_indexes (GtuberClient *self, GtuberMediaInfo *info,
+    GtuberAdaptiveStreamFilter filter, gpointer user_data,
+    GCancellable *cancellable, GError **error)
+{
+  g_return_val_if_fail (GTUBER_IS_CLIENT (self), FALSE);
+  g_return_val_if_fail (GTUBER_IS_MEDIA_INFO (info), FALSE);
+  g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+
+  return gtuber_client_prefetch_segment_indexes_internal (self, info,
+      filter, user_data, NULL, cancellable, error);
+}
+
+/**
+ * gtuber_client_prefetch_segment_indexes_with_session:
+ * @client: a #GtuberClient
+ * @info: a #GtuberMediaInfo
+ * @filter: (nullable) (scope call): a #GtuberAdaptiveStreamFilter
+ * @user_data: (closure): the data to pass to @filter
+ * @session: a #SoupSession to send requests with
+ * @cancellable: (nullable): optional #GCancellable object,
+ *     %NULL to ignore
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * Same as gtuber_client_prefetch_segment_indexes(), but sends all
+ *   requests with passed @session, so already established connections
+ *   (e.g. from gtuber_client_fetch_media_info_with_session()) are reused.
+ *
+ * Requests are dispatched within the thread-default #GMainContext
+ *   of calling thread, which should always be the same one when
+ *   using given @session.
+ *
+ * Returns: %TRUE if finished, %FALSE when cancelled.
+ */
+gboolean
+gtuber_client_prefetch_segment_indexes_with_session (GtuberClient *self,
+    GtuberMediaInfo *info, GtuberAdaptiveStreamFilter filter, gpointer user_data,
+    SoupSession *session, GCancellable *cancellable, GError **error)
+{
+  g_return_val_if_fail (GTUBER_IS_CLIENT (self), FALSE);
+  g_return_val_if_fail (GTUBER_IS_MEDIA_INFO (info), FALSE);
+  g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+  g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+
+  return gtuber_client_prefetch_segment_indexes_internal (self, info,
+      filter, user_data, session, cancellable, error);
+}
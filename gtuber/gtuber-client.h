@@ -25,8 +25,10 @@
 
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <libsoup/soup.h>
 
 #include <gtuber/gtuber-media-info.h>
+#include <gtuber/gtuber-manifest-generator.h>
 
 G_BEGIN_DECLS
 
@@ -51,17 +53,44 @@ typedef struct _GtuberClientClass GtuberClientClass;
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (GtuberClient, g_object_unref)
 #endif
 
+/**
+ * GtuberCollectionEntryFunc:
+ * @client: a #GtuberClient
+ * @uri: URI of the collection entry
+ * @info: (nullable): a #GtuberMediaInfo of the entry or %NULL on error
+ * @error: (nullable): a #GError if entry could not be resolved
+ * @user_data: user data passed to gtuber_client_expand_collection()
+ *
+ * Function called for each resolved collection entry.
+ */
+typedef void (* GtuberCollectionEntryFunc) (GtuberClient *client, const gchar *uri, GtuberMediaInfo *info, const GError *error, gpointer user_data);
+
 GType             gtuber_client_get_type                   (void);
 
 GtuberClient *    gtuber_client_new                        (void);
 
 GtuberMediaInfo * gtuber_client_fetch_media_info           (GtuberClient *client, const gchar *uri, GCancellable *cancellable, GError **error);
 
+GtuberMediaInfo * gtuber_client_fetch_media_info_with_session (GtuberClient *client, const gchar *uri, SoupSession *session,
+                                                               GCancellable *cancellable, GError **error);
+
 void              gtuber_client_fetch_media_info_async     (GtuberClient *client, const gchar *uri, GCancellable *cancellable,
                                                                GAsyncReadyCallback callback, gpointer user_data);
 
 GtuberMediaInfo * gtuber_client_fetch_media_info_finish    (GtuberClient *client, GAsyncResult *res, GError **error);
 
+gboolean          gtuber_client_expand_collection          (GtuberClient *client, const gchar *uri, guint max_parallel,
+                                                               GtuberCollectionEntryFunc func, gpointer user_data,
+                                                               GCancellable *cancellable, GError **error);
+
+gboolean          gtuber_client_prefetch_segment_indexes   (GtuberClient *client, GtuberMediaInfo *info,
+                                                               GtuberAdaptiveStreamFilter filter, gpointer user_data,
+                                                               GCancellable *cancellable, GError **error);
+
+gboolean          gtuber_client_prefetch_segment_indexes_with_session (GtuberClient *client, GtuberMediaInfo *info,
+                                                                          GtuberAdaptiveStreamFilter filter, gpointer user_data,
+                                                                          SoupSession *session, GCancellable *cancellable, GError **error);
+
 GQuark            gtuber_client_error_quark                (void);
 
 G_END_DECLS
@@ -86,15 +86,32 @@ typedef enum
   GTUBER_ADAPTIVE_STREAM_MANIFEST_HLS
 } GtuberAdaptiveStreamManifest;
 
+/**
+ * GtuberStreamContent:
+ * @GTUBER_STREAM_CONTENT_UNKNOWN: stream content could not be determined.
+ * @GTUBER_STREAM_CONTENT_VIDEO: stream has video only.
+ * @GTUBER_STREAM_CONTENT_AUDIO: stream has audio only.
+ * @GTUBER_STREAM_CONTENT_VIDEO_AUDIO: stream has both video and audio.
+ */
+typedef enum
+{
+  GTUBER_STREAM_CONTENT_UNKNOWN = 0,
+  GTUBER_STREAM_CONTENT_VIDEO,
+  GTUBER_STREAM_CONTENT_AUDIO,
+  GTUBER_STREAM_CONTENT_VIDEO_AUDIO
+} GtuberStreamContent;
+
 /**
  * GtuberClientError:
  * @GTUBER_CLIENT_ERROR_NO_PLUGIN: none of the installed plugins could handle URI.
  * @GTUBER_CLIENT_ERROR_MISSING_INFO: plugin did not fill the media info.
+ * @GTUBER_CLIENT_ERROR_NO_COLLECTION: plugin cannot expand URI into a collection.
  */
 typedef enum
 {
   GTUBER_CLIENT_ERROR_NO_PLUGIN,
   GTUBER_CLIENT_ERROR_MISSING_INFO,
+  GTUBER_CLIENT_ERROR_NO_COLLECTION,
 } GtuberClientError;
 
 /**
@@ -138,6 +155,9 @@ typedef enum
  * @GTUBER_FLOW_ERROR: give up.
  * @GTUBER_FLOW_RESTART: start from first step again.
  * @GTUBER_FLOW_RECONFIGURE: change URI and do a clean restart.
+ * @GTUBER_FLOW_FANOUT: send multiple independent requests concurrently.
+ *   Can only be returned from `create_request` vfunc, messages are then
+ *   obtained from `create_requests` vfunc.
  */
 typedef enum
 {
@@ -145,6 +165,7 @@ typedef enum
   GTUBER_FLOW_ERROR,
   GTUBER_FLOW_RESTART,
   GTUBER_FLOW_RECONFIGURE,
+  GTUBER_FLOW_FANOUT,
 } GtuberFlow;
 
 G_END_DECLS
@@ -27,6 +27,7 @@
 #include "gtuber-enums.h"
 #include "gtuber-manifest-generator.h"
 #include "gtuber-stream.h"
+#include "gtuber-adaptive-stream-private.h"
 
 enum
 {
@@ -50,6 +51,8 @@ struct _GtuberManifestGenerator
   GtuberAdaptiveStreamFilter filter_func;
   gpointer filter_data;
   GDestroyNotify filter_destroy;
+
+  GtuberStreamSelector *selector;
 };
 
 struct _GtuberManifestGeneratorClass
@@ -92,6 +95,8 @@ gtuber_manifest_generator_init (GtuberManifestGenerator *self)
 
   self->filter_func = NULL;
   self->filter_destroy = NULL;
+
+  self->selector = NULL;
 }
 
 static void
@@ -188,6 +193,8 @@ gtuber_manifest_generator_finalize (GObject *object)
 
   if (self->media_info)
     g_object_unref (self->media_info);
+  if (self->selector)
+    g_object_unref (self->selector);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -456,6 +463,10 @@ get_should_add_adaptive_stream (GtuberManifestGenerator *self,
   if (stream_manifest != req_manifest)
     return FALSE;
 
+  if (self->selector && !gtuber_stream_selector_is_stream_allowed (
+      self->selector, GTUBER_STREAM (astream)))
+    return FALSE;
+
   if (self->filter_func)
     return self->filter_func (astream, self->filter_data);
 
@@ -541,10 +552,77 @@ _sort_hls_streams_cb (gconstpointer a, gconstpointer b)
   return 1;
 }
 
+static void
+_add_segment_list (GtuberAdaptiveStream *astream,
+    const GtuberSegmentIndex *index, DumpStringData *data)
+{
+  guint64 start, end;
+  gboolean first = TRUE;
+  guint i;
+
+  /* <SegmentList> */
+  add_line_no_newline (data->gen, data->string, 4, "<SegmentList");
+  add_option_int (data->string, "timescale", index->timescale);
+  if (index->earliest_pts > 0)
+    add_option_int (data->string, "presentationTimeOffset", index->earliest_pts);
+  finish_line (data->gen, data->string, ">");
+
+  /* <Initialization> */
+  add_line_no_newline (data->gen, data->string, 5, "<Initialization");
+  if (gtuber_adaptive_stream_get_init_range (astream, &start, &end))
+    add_option_range (data->string, "range", start, end);
+  finish_line (data->gen, data->string, "/>");
+
+  /* <SegmentTimeline> */
+  add_line (data->gen, data->string, 5, "<SegmentTimeline>");
+  for (i = 0; i < index->segments->len; i++) {
+    const GtuberSegmentRef *seg, *next;
+    guint repeat = 0;
+
+    seg = &g_array_index (index->segments, GtuberSegmentRef, i);
+
+    /* Merge consecutive segments of the same duration */
+    while (i + 1 < index->segments->len) {
+      next = &g_array_index (index->segments, GtuberSegmentRef, i + 1);
+      if (next->duration != seg->duration)
+        break;
+
+      repeat++;
+      i++;
+    }
+
+    add_line_no_newline (data->gen, data->string, 6, "<S");
+    if (first)
+      add_option_int (data->string, "t", index->earliest_pts);
+    add_option_int (data->string, "d", seg->duration);
+    if (repeat > 0)
+      add_option_int (data->string, "r", repeat);
+    finish_line (data->gen, data->string, "/>");
+
+    first = FALSE;
+  }
+  add_line (data->gen, data->string, 5, "</SegmentTimeline>");
+
+  /* <SegmentURL> */
+  for (i = 0; i < index->segments->len; i++) {
+    const GtuberSegmentRef *seg;
+
+    seg = &g_array_index (index->segments, GtuberSegmentRef, i);
+
+    add_line_no_newline (data->gen, data->string, 5, "<SegmentURL");
+    add_option_range (data->string, "mediaRange", seg->start, seg->end);
+    finish_line (data->gen, data->string, "/>");
+  }
+
+  add_line (data->gen, data->string, 4, "</SegmentList>");
+}
+
 static void
 _add_representation_cb (GtuberAdaptiveStream *astream, DumpStringData *data)
 {
   GtuberStream *stream;
+  const GtuberSegmentIndex *index;
+  const gchar *const *fallback_uris;
   gchar *codecs_str;
   guint width, height, fps;
   guint64 start, end;
@@ -586,6 +664,26 @@ _add_representation_cb (GtuberAdaptiveStream *astream, DumpStringData *data)
   add_escaped_xml_uri (data->string, gtuber_stream_get_uri (stream));
   finish_line (data->gen, data->string, "</BaseURL>");
 
+  /* Alternative <BaseURL> elements, in order of preference */
+  if ((fallback_uris = gtuber_stream_get_fallback_uris (stream))) {
+    guint i;
+
+    for (i = 0; fallback_uris[i]; i++) {
+      add_line_no_newline (data->gen, data->string, 4, "<BaseURL>");
+      add_escaped_xml_uri (data->string, fallback_uris[i]);
+      finish_line (data->gen, data->string, "</BaseURL>");
+    }
+  }
+
+  /* Index already known, list segments directly, so
+   * demuxer does not have to download it before playback */
+  if ((index = gtuber_adaptive_stream_get_segment_index (astream))) {
+    _add_segment_list (astream, index, data);
+    add_line (data->gen, data->string, 3, "</Representation>");
+
+    return;
+  }
+
   /* <SegmentBase> */
   add_line_no_newline (data->gen, data->string, 4, "<SegmentBase");
   if (gtuber_adaptive_stream_get_index_range (astream, &start, &end))
@@ -686,7 +784,7 @@ _append_hls_stream (GtuberStream *video_stream, GtuberStream *audio_stream, GStr
     height = gtuber_stream_get_height (video_stream);
     fps = gtuber_stream_get_fps (video_stream);
 
-    if (width || height)
+    if (width && height)
       g_string_append_printf (string, ",RESOLUTION=%ux%u", width, height);
     if (fps)
       g_string_append_printf (string, ",FRAME-RATE=%u", fps);
@@ -1197,6 +1295,32 @@ gtuber_manifest_generator_set_filter_func (GtuberManifestGenerator *self,
   self->filter_destroy = destroy;
 }
 
+/**
+ * gtuber_manifest_generator_set_stream_selector:
+ * @gen: a #GtuberManifestGenerator
+ * @selector: (nullable): a #GtuberStreamSelector
+ *
+ * Sets the #GtuberStreamSelector which constraints every
+ * #GtuberAdaptiveStream has to match in order to be added
+ * during manifest generation.
+ *
+ * When filter function is also set, stream has to pass both.
+ */
+void
+gtuber_manifest_generator_set_stream_selector (GtuberManifestGenerator *self,
+    GtuberStreamSelector *selector)
+{
+  g_return_if_fail (GTUBER_IS_MANIFEST_GENERATOR (self));
+  g_return_if_fail (selector == NULL || GTUBER_IS_STREAM_SELECTOR (selector));
+
+  if (selector)
+    g_object_ref (selector);
+  if (self->selector)
+    g_object_unref (self->selector);
+
+  self->selector = selector;
+}
+
 /**
  * gtuber_manifest_generator_to_data:
  * @gen: a #GtuberManifestGenerator
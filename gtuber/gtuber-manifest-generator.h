@@ -27,6 +27,7 @@
 
 #include <gtuber/gtuber-media-info.h>
 #include <gtuber/gtuber-adaptive-stream.h>
+#include <gtuber/gtuber-stream-selector.h>
 
 G_BEGIN_DECLS
 
@@ -83,6 +84,8 @@ void                         gtuber_manifest_generator_set_media_info      (Gtub
 
 void                         gtuber_manifest_generator_set_filter_func     (GtuberManifestGenerator *gen, GtuberAdaptiveStreamFilter filter, gpointer user_data, GDestroyNotify destroy);
 
+void                         gtuber_manifest_generator_set_stream_selector (GtuberManifestGenerator *gen, GtuberStreamSelector *selector);
+
 gchar *                      gtuber_manifest_generator_to_data             (GtuberManifestGenerator *gen);
 
 gboolean                     gtuber_manifest_generator_to_file             (GtuberManifestGenerator *gen, const gchar *filename, GError **error);
@@ -27,4 +27,7 @@ G_BEGIN_DECLS
 G_GNUC_INTERNAL
 void gtuber_media_info_init_heartbeat (GtuberMediaInfo *info);
 
+G_GNUC_INTERNAL
+void gtuber_media_info_set_fetch_stats (GtuberMediaInfo *info, const gchar *plugin_name, guint n_requests);
+
 G_END_DECLS
@@ -63,6 +63,9 @@ struct _GtuberMediaInfo
   GHashTable *req_headers;
 
   GtuberHeartbeat *heartbeat;
+
+  gchar *plugin_name;
+  guint n_requests;
 };
 
 struct _GtuberMediaInfoClass
@@ -191,6 +194,7 @@ gtuber_media_info_finalize (GObject *object)
   g_free (self->id);
   g_free (self->title);
   g_free (self->description);
+  g_free (self->plugin_name);
 
   g_ptr_array_unref (self->streams);
   g_ptr_array_unref (self->adaptive_streams);
@@ -487,6 +491,39 @@ gtuber_media_info_get_request_headers (GtuberMediaInfo *self)
   return self->req_headers;
 }
 
+/**
+ * gtuber_media_info_get_plugin_name:
+ * @info: a #GtuberMediaInfo
+ *
+ * Get name of the plugin website type that fetched this media info.
+ *
+ * Returns: (transfer none): plugin name or %NULL when undetermined.
+ */
+const gchar *
+gtuber_media_info_get_plugin_name (GtuberMediaInfo *self)
+{
+  g_return_val_if_fail (GTUBER_IS_MEDIA_INFO (self), NULL);
+
+  return self->plugin_name;
+}
+
+/**
+ * gtuber_media_info_get_n_requests:
+ * @info: a #GtuberMediaInfo
+ *
+ * Get the number of HTTP requests that were sent in order
+ * to fetch this media info, including restarts and fanout requests.
+ *
+ * Returns: number of HTTP requests.
+ */
+guint
+gtuber_media_info_get_n_requests (GtuberMediaInfo *self)
+{
+  g_return_val_if_fail (GTUBER_IS_MEDIA_INFO (self), 0);
+
+  return self->n_requests;
+}
+
 /**
  * gtuber_media_info_take_heartbeat:
  * @info: a #GtuberMediaInfo
@@ -515,3 +552,13 @@ gtuber_media_info_init_heartbeat (GtuberMediaInfo *self)
   gtuber_heartbeat_set_request_headers (self->heartbeat, self->req_headers);
   gtuber_heartbeat_start (self->heartbeat);
 }
+
+void
+gtuber_media_info_set_fetch_stats (GtuberMediaInfo *self,
+    const gchar *plugin_name, guint n_requests)
+{
+  g_free (self->plugin_name);
+  self->plugin_name = g_strdup (plugin_name);
+
+  self->n_requests = n_requests;
+}
@@ -69,4 +69,8 @@ GPtrArray *        gtuber_media_info_get_adaptive_streams       (GtuberMediaInfo
 
 GHashTable *       gtuber_media_info_get_request_headers        (GtuberMediaInfo *info);
 
+const gchar *      gtuber_media_info_get_plugin_name            (GtuberMediaInfo *info);
+
+guint              gtuber_media_info_get_n_requests             (GtuberMediaInfo *info);
+
 G_END_DECLS
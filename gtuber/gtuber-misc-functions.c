@@ -37,6 +37,8 @@
  *   for plugin filename that handles given URI, or %NULL
  *
  * Checks if any among installed plugins advertises support for given URI.
+ * URIs that only point to a collection of media (e.g. a playlist) are not
+ * reported as supported here, use gtuber_client_expand_collection() for them.
  *
  * You can use this to check plugin support without actually trying to download
  * any data, otherwise just use %GtuberClient to fetch media info directly.
@@ -63,13 +65,13 @@ gtuber_has_plugin_for_uri (const gchar *uri, gchar **filename)
 
   website = gtuber_loader_get_website_for_uri (guri, &module);
   if (website) {
+    res = !gtuber_website_get_collection_only (website);
     g_object_unref (website);
 
-    if (filename)
+    if (res && filename)
       *filename = g_strdup (g_module_name (module));
 
     gtuber_loader_close_module (module);
-    res = TRUE;
   }
   g_debug ("URI supported: %s", res ? "yes" : "no");
 
@@ -31,6 +31,8 @@ GtuberStream *       gtuber_stream_new              (void);
 
 void                 gtuber_stream_set_uri          (GtuberStream *stream, const gchar *uri);
 
+void                 gtuber_stream_set_fallback_uris (GtuberStream *stream, const gchar *const *uris);
+
 void                 gtuber_stream_set_itag         (GtuberStream *stream, guint itag);
 
 void                 gtuber_stream_set_mime_type    (GtuberStream *stream, GtuberStreamMimeType mime_type);
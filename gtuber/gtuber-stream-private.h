@@ -29,6 +29,7 @@ struct _GtuberStream
   GObject parent;
 
   gchar *uri;
+  gchar **fallback_uris;
   guint itag;
   GtuberStreamMimeType mime_type;
   guint width;
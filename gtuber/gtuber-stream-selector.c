@@ -0,0 +1,654 @@
+/*
+ * Copyright (C) 2021 Rafał Dzięgiel <rafostar.github@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gtuber-stream-selector
+ * @title: GtuberStreamSelector
+ * @short_description: selects streams from media info
+ *   matching given constraints
+ *
+ * Streams of the #GtuberMediaInfo are classified once when selector
+ * is created, so checking them against constraints or searching for
+ * the best one does not need to parse their codecs each time again.
+ */
+
+#include "gtuber-stream-selector.h"
+#include "gtuber-adaptive-stream.h"
+
+enum
+{
+  PROP_0,
+  PROP_MEDIA_INFO,
+  PROP_CODECS,
+  PROP_MAX_HEIGHT,
+  PROP_MAX_FPS,
+  PROP_LAST
+};
+
+typedef struct
+{
+  GtuberStream *stream;
+  GtuberStreamContent content;
+  GtuberCodecFlags codec_flags;
+  gboolean has_vcodec;
+  gboolean adaptive;
+  guint itag;
+  guint width;
+  guint height;
+  guint fps;
+  guint bitrate;
+} GtuberStreamTraits;
+
+struct _GtuberStreamSelector
+{
+  GObject parent;
+
+  GtuberMediaInfo *media_info;
+
+  GtuberCodecFlags codecs;
+  guint max_height;
+  guint max_fps;
+  GHashTable *itags;
+
+  GArray *traits;
+  GHashTable *traits_map;
+  GHashTable *itags_map;
+};
+
+struct _GtuberStreamSelectorClass
+{
+  GObjectClass parent_class;
+};
+
+#define parent_class gtuber_stream_selector_parent_class
+G_DEFINE_TYPE (GtuberStreamSelector, gtuber_stream_selector, G_TYPE_OBJECT)
+
+static GParamSpec *param_specs[PROP_LAST] = { NULL, };
+
+static void gtuber_stream_selector_constructed (GObject *object);
+static void gtuber_stream_selector_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gtuber_stream_selector_get_property (GObject *object, guint prop_id,
+    GValue *value, GParamSpec *pspec);
+static void gtuber_stream_selector_finalize (GObject *object);
+
+static void
+gtuber_stream_selector_init (GtuberStreamSelector *self)
+{
+  self->media_info = NULL;
+
+  self->codecs = 0;
+  self->max_height = 0;
+  self->max_fps = 0;
+  self->itags = NULL;
+
+  self->traits = g_array_new (FALSE, FALSE, sizeof (GtuberStreamTraits));
+  self->traits_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+  self->itags_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+}
+
+static void
+gtuber_stream_selector_class_init (GtuberStreamSelectorClass *klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->constructed = gtuber_stream_selector_constructed;
+  gobject_class->set_property = gtuber_stream_selector_set_property;
+  gobject_class->get_property = gtuber_stream_selector_get_property;
+  gobject_class->finalize = gtuber_stream_selector_finalize;
+
+  param_specs[PROP_MEDIA_INFO] =
+      g_param_spec_object ("media-info", "Media Info",
+      "The media info with streams to select from",
+      GTUBER_TYPE_MEDIA_INFO,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_CODECS] = g_param_spec_flags ("codecs",
+      "Codecs", "Allowed media codecs (0 = all)",
+      GTUBER_TYPE_CODEC_FLAGS, 0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_MAX_HEIGHT] = g_param_spec_uint ("max-height",
+      "Max Height", "Max video height (0 = unlimited)", 0, G_MAXUINT, 0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_MAX_FPS] = g_param_spec_uint ("max-fps",
+      "Max FPS", "Max video framerate (0 = unlimited)", 0, G_MAXUINT, 0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
+}
+
+static void
+_fill_stream_traits (GtuberStreamTraits *traits, GtuberStream *stream,
+    gboolean adaptive)
+{
+  gboolean has_video, has_audio;
+
+  traits->stream = stream;
+  traits->adaptive = adaptive;
+  traits->codec_flags = gtuber_stream_get_codec_flags (stream);
+  traits->has_vcodec = (gtuber_stream_get_video_codec (stream) != NULL);
+  traits->itag = gtuber_stream_get_itag (stream);
+  traits->width = gtuber_stream_get_width (stream);
+  traits->height = gtuber_stream_get_height (stream);
+  traits->fps = gtuber_stream_get_fps (stream);
+  traits->bitrate = gtuber_stream_get_bitrate (stream);
+
+  has_video = (traits->has_vcodec
+      || traits->width > 0 || traits->height > 0 || traits->fps > 0);
+  has_audio = (gtuber_stream_get_audio_codec (stream) != NULL);
+
+  traits->content = (has_video && has_audio)
+      ? GTUBER_STREAM_CONTENT_VIDEO_AUDIO
+      : (has_video)
+      ? GTUBER_STREAM_CONTENT_VIDEO
+      : (has_audio)
+      ? GTUBER_STREAM_CONTENT_AUDIO
+      : GTUBER_STREAM_CONTENT_UNKNOWN;
+}
+
+static void
+_classify_streams (GtuberStreamSelector *self, GPtrArray *streams,
+    gboolean adaptive)
+{
+  guint i;
+
+  for (i = 0; i < streams->len; i++) {
+    GtuberStreamTraits traits;
+
+    _fill_stream_traits (&traits, g_ptr_array_index (streams, i), adaptive);
+    g_array_append_val (self->traits, traits);
+  }
+}
+
+static void
+gtuber_stream_selector_constructed (GObject *object)
+{
+  GtuberStreamSelector *self = GTUBER_STREAM_SELECTOR (object);
+  guint i;
+
+  if (self->media_info) {
+    /* Adaptive ones first, so they win on itag collision */
+    _classify_streams (self,
+        gtuber_media_info_get_adaptive_streams (self->media_info), TRUE);
+    _classify_streams (self,
+        gtuber_media_info_get_streams (self->media_info), FALSE);
+
+    /* Array will not grow anymore, so its elements can be mapped */
+    for (i = 0; i < self->traits->len; i++) {
+      GtuberStreamTraits *traits = &g_array_index (self->traits, GtuberStreamTraits, i);
+      gpointer itag = GUINT_TO_POINTER (traits->itag);
+
+      g_hash_table_insert (self->traits_map, traits->stream, traits);
+
+      if (!g_hash_table_contains (self->itags_map, itag))
+        g_hash_table_insert (self->itags_map, itag, traits->stream);
+    }
+  }
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+}
+
+static void
+gtuber_stream_selector_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GtuberStreamSelector *self = GTUBER_STREAM_SELECTOR (object);
+
+  switch (prop_id) {
+    case PROP_MEDIA_INFO:
+      self->media_info = g_value_dup_object (value);
+      break;
+    case PROP_CODECS:
+      gtuber_stream_selector_set_codecs (self, g_value_get_flags (value));
+      break;
+    case PROP_MAX_HEIGHT:
+      gtuber_stream_selector_set_max_height (self, g_value_get_uint (value));
+      break;
+    case PROP_MAX_FPS:
+      gtuber_stream_selector_set_max_fps (self, g_value_get_uint (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gtuber_stream_selector_get_property (GObject *object, guint prop_id,
+    GValue *value, GParamSpec *pspec)
+{
+  GtuberStreamSelector *self = GTUBER_STREAM_SELECTOR (object);
+
+  switch (prop_id) {
+    case PROP_MEDIA_INFO:
+      g_value_set_object (value, self->media_info);
+      break;
+    case PROP_CODECS:
+      g_value_set_flags (value, gtuber_stream_selector_get_codecs (self));
+      break;
+    case PROP_MAX_HEIGHT:
+      g_value_set_uint (value, gtuber_stream_selector_get_max_height (self));
+      break;
+    case PROP_MAX_FPS:
+      g_value_set_uint (value, gtuber_stream_selector_get_max_fps (self));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gtuber_stream_selector_finalize (GObject *object)
+{
+  GtuberStreamSelector *self = GTUBER_STREAM_SELECTOR (object);
+
+  g_debug ("StreamSelector finalize");
+
+  if (self->itags)
+    g_hash_table_unref (self->itags);
+
+  g_hash_table_unref (self->traits_map);
+  g_hash_table_unref (self->itags_map);
+  g_array_unref (self->traits);
+
+  if (self->media_info)
+    g_object_unref (self->media_info);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/*
+ * Returns traits of stream. Streams that do not belong to
+ * selector media info are classified into @tmp_traits.
+ */
+static const GtuberStreamTraits *
+_get_stream_traits (GtuberStreamSelector *self, GtuberStream *stream,
+    GtuberStreamTraits *tmp_traits)
+{
+  const GtuberStreamTraits *traits;
+
+  if ((traits = g_hash_table_lookup (self->traits_map, stream)))
+    return traits;
+
+  _fill_stream_traits (tmp_traits, stream, GTUBER_IS_ADAPTIVE_STREAM (stream));
+
+  return tmp_traits;
+}
+
+static gboolean
+_get_traits_allowed (GtuberStreamSelector *self, const GtuberStreamTraits *traits)
+{
+  if (self->codecs > 0
+      && (self->codecs & traits->codec_flags) != traits->codec_flags)
+    return FALSE;
+
+  if (traits->has_vcodec) {
+    if (self->max_height > 0
+        && (traits->height == 0 || traits->height > self->max_height))
+      return FALSE;
+    if (self->max_fps > 0
+        && (traits->fps == 0 || traits->fps > self->max_fps))
+      return FALSE;
+  }
+
+  if (self->itags
+      && !g_hash_table_contains (self->itags, GUINT_TO_POINTER (traits->itag)))
+    return FALSE;
+
+  return TRUE;
+}
+
+/*
+ * Compares quality of two streams. Height is the most
+ * important one, followed by width, bitrate and then fps.
+ */
+static gint
+_compare_traits_quality (const GtuberStreamTraits *a, const GtuberStreamTraits *b)
+{
+  if (a->height != b->height)
+    return (a->height > b->height) ? 1 : -1;
+  if (a->width != b->width)
+    return (a->width > b->width) ? 1 : -1;
+  if (a->bitrate != b->bitrate)
+    return (a->bitrate > b->bitrate) ? 1 : -1;
+  if (a->fps != b->fps)
+    return (a->fps > b->fps) ? 1 : -1;
+
+  return 0;
+}
+
+/**
+ * gtuber_stream_selector_new:
+ * @info: a #GtuberMediaInfo
+ *
+ * Creates a new #GtuberStreamSelector instance for streams
+ * of given @info. Streams are classified only once here.
+ *
+ * Returns: (transfer full): a new #GtuberStreamSelector instance.
+ */
+GtuberStreamSelector *
+gtuber_stream_selector_new (GtuberMediaInfo *info)
+{
+  g_return_val_if_fail (GTUBER_IS_MEDIA_INFO (info), NULL);
+
+  return g_object_new (GTUBER_TYPE_STREAM_SELECTOR,
+      "media-info", info, NULL);
+}
+
+/**
+ * gtuber_stream_selector_get_media_info:
+ * @selector: a #GtuberStreamSelector
+ *
+ * Get the #GtuberMediaInfo which streams are selected from.
+ *
+ * Returns: (transfer none): a #GtuberMediaInfo.
+ */
+GtuberMediaInfo *
+gtuber_stream_selector_get_media_info (GtuberStreamSelector *self)
+{
+  g_return_val_if_fail (GTUBER_IS_STREAM_SELECTOR (self), NULL);
+
+  return self->media_info;
+}
+
+/**
+ * gtuber_stream_selector_get_codecs:
+ * @selector: a #GtuberStreamSelector
+ *
+ * Get codecs that streams are allowed to use.
+ *
+ * Returns: #GtuberCodecFlags flags or 0 when all are allowed.
+ */
+GtuberCodecFlags
+gtuber_stream_selector_get_codecs (GtuberStreamSelector *self)
+{
+  g_return_val_if_fail (GTUBER_IS_STREAM_SELECTOR (self), 0);
+
+  return self->codecs;
+}
+
+/**
+ * gtuber_stream_selector_set_codecs:
+ * @selector: a #GtuberStreamSelector
+ * @codecs: #GtuberCodecFlags flags
+ *
+ * Set codecs that streams are allowed to use. Streams using
+ * any codec that is not in @codecs will be rejected.
+ *
+ * Set to 0 in order to allow all codecs (default).
+ */
+void
+gtuber_stream_selector_set_codecs (GtuberStreamSelector *self,
+    GtuberCodecFlags codecs)
+{
+  g_return_if_fail (GTUBER_IS_STREAM_SELECTOR (self));
+
+  self->codecs = codecs;
+}
+
+/**
+ * gtuber_stream_selector_get_max_height:
+ * @selector: a #GtuberStreamSelector
+ *
+ * Get max allowed video height.
+ *
+ * Returns: max height or 0 when unlimited.
+ */
+guint
+gtuber_stream_selector_get_max_height (GtuberStreamSelector *self)
+{
+  g_return_val_if_fail (GTUBER_IS_STREAM_SELECTOR (self), 0);
+
+  return self->max_height;
+}
+
+/**
+ * gtuber_stream_selector_set_max_height:
+ * @selector: a #GtuberStreamSelector
+ * @max_height: max video height
+ *
+ * Set max allowed video height. Set to 0 for unlimited (default).
+ */
+void
+gtuber_stream_selector_set_max_height (GtuberStreamSelector *self,
+    guint max_height)
+{
+  g_return_if_fail (GTUBER_IS_STREAM_SELECTOR (self));
+
+  self->max_height = max_height;
+}
+
+/**
+ * gtuber_stream_selector_get_max_fps:
+ * @selector: a #GtuberStreamSelector
+ *
+ * Get max allowed video framerate.
+ *
+ * Returns: max fps or 0 when unlimited.
+ */
+guint
+gtuber_stream_selector_get_max_fps (GtuberStreamSelector *self)
+{
+  g_return_val_if_fail (GTUBER_IS_STREAM_SELECTOR (self), 0);
+
+  return self->max_fps;
+}
+
+/**
+ * gtuber_stream_selector_set_max_fps:
+ * @selector: a #GtuberStreamSelector
+ * @max_fps: max video framerate
+ *
+ * Set max allowed video framerate. Set to 0 for unlimited (default).
+ */
+void
+gtuber_stream_selector_set_max_fps (GtuberStreamSelector *self,
+    guint max_fps)
+{
+  g_return_if_fail (GTUBER_IS_STREAM_SELECTOR (self));
+
+  self->max_fps = max_fps;
+}
+
+/**
+ * gtuber_stream_selector_set_itags:
+ * @selector: a #GtuberStreamSelector
+ * @itags: (nullable): a comma separated list of allowed itags
+ *
+ * Set itags of streams that are allowed. Streams with any
+ * other itag will be rejected.
+ *
+ * Set to %NULL in order to allow all itags (default).
+ */
+void
+gtuber_stream_selector_set_itags (GtuberStreamSelector *self,
+    const gchar *itags_str)
+{
+  g_return_if_fail (GTUBER_IS_STREAM_SELECTOR (self));
+
+  g_clear_pointer (&self->itags, g_hash_table_unref);
+
+  if (itags_str) {
+    gchar **itags = g_strsplit (itags_str, ",", 0);
+    guint i;
+
+    for (i = 0; itags[i]; i++) {
+      guint itag;
+
+      g_strstrip (itags[i]);
+      itag = g_ascii_strtoull (itags[i], NULL, 10);
+
+      if (itag > 0) {
+        if (!self->itags)
+          self->itags = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+        g_hash_table_add (self->itags, GUINT_TO_POINTER (itag));
+        g_debug ("Added allowed itag: %u", itag);
+      }
+    }
+
+    g_strfreev (itags);
+  }
+}
+
+/**
+ * gtuber_stream_selector_get_stream_content:
+ * @selector: a #GtuberStreamSelector
+ * @stream: a #GtuberStream
+ *
+ * Get what kind of content given @stream has.
+ *
+ * Returns: a #GtuberStreamContent.
+ */
+GtuberStreamContent
+gtuber_stream_selector_get_stream_content (GtuberStreamSelector *self,
+    GtuberStream *stream)
+{
+  GtuberStreamTraits tmp_traits;
+
+  g_return_val_if_fail (GTUBER_IS_STREAM_SELECTOR (self), GTUBER_STREAM_CONTENT_UNKNOWN);
+  g_return_val_if_fail (GTUBER_IS_STREAM (stream), GTUBER_STREAM_CONTENT_UNKNOWN);
+
+  return _get_stream_traits (self, stream, &tmp_traits)->content;
+}
+
+/**
+ * gtuber_stream_selector_get_stream_by_itag:
+ * @selector: a #GtuberStreamSelector
+ * @itag: an itag to look for
+ *
+ * Finds a stream with given @itag. Adaptive streams
+ * are preferred when both kinds use the same itag.
+ *
+ * Constraints set on @selector are not taken into account.
+ *
+ * Returns: (transfer none) (nullable): a #GtuberStream or %NULL when not found.
+ */
+GtuberStream *
+gtuber_stream_selector_get_stream_by_itag (GtuberStreamSelector *self,
+    guint itag)
+{
+  g_return_val_if_fail (GTUBER_IS_STREAM_SELECTOR (self), NULL);
+
+  return g_hash_table_lookup (self->itags_map, GUINT_TO_POINTER (itag));
+}
+
+/**
+ * gtuber_stream_selector_is_stream_allowed:
+ * @selector: a #GtuberStreamSelector
+ * @stream: a #GtuberStream
+ *
+ * Checks if @stream matches constraints set on @selector.
+ *
+ * Returns: %TRUE if stream is allowed, %FALSE otherwise.
+ */
+gboolean
+gtuber_stream_selector_is_stream_allowed (GtuberStreamSelector *self,
+    GtuberStream *stream)
+{
+  GtuberStreamTraits tmp_traits;
+
+  g_return_val_if_fail (GTUBER_IS_STREAM_SELECTOR (self), FALSE);
+  g_return_val_if_fail (GTUBER_IS_STREAM (stream), FALSE);
+
+  return _get_traits_allowed (self, _get_stream_traits (self, stream, &tmp_traits));
+}
+
+/**
+ * gtuber_stream_selector_get_allowed_adaptive_streams:
+ * @selector: a #GtuberStreamSelector
+ *
+ * Get adaptive streams that match constraints set on @selector.
+ *
+ * Returns: (transfer container) (element-type GtuberAdaptiveStream): an array of
+ *   allowed #GtuberAdaptiveStream.
+ */
+GPtrArray *
+gtuber_stream_selector_get_allowed_adaptive_streams (GtuberStreamSelector *self)
+{
+  GPtrArray *astreams;
+  guint i;
+
+  g_return_val_if_fail (GTUBER_IS_STREAM_SELECTOR (self), NULL);
+
+  astreams = g_ptr_array_new ();
+
+  for (i = 0; i < self->traits->len; i++) {
+    const GtuberStreamTraits *traits = &g_array_index (self->traits, GtuberStreamTraits, i);
+
+    /* Adaptive ones are at the beginning */
+    if (!traits->adaptive)
+      break;
+
+    if (_get_traits_allowed (self, traits))
+      g_ptr_array_add (astreams, traits->stream);
+  }
+
+  return astreams;
+}
+
+/**
+ * gtuber_stream_selector_get_best_stream:
+ * @selector: a #GtuberStreamSelector
+ * @content: a #GtuberStreamContent of stream to find
+ * @include_adaptive: whether to also consider adaptive streams
+ *
+ * Finds the best quality stream with given @content
+ * that matches constraints set on @selector. Use
+ * %GTUBER_STREAM_CONTENT_UNKNOWN to consider streams
+ * regardless of their content.
+ *
+ * Streams are compared by their height, then width,
+ * bitrate and fps in that order.
+ *
+ * Returns: (transfer none) (nullable): a #GtuberStream or %NULL when none matches.
+ */
+GtuberStream *
+gtuber_stream_selector_get_best_stream (GtuberStreamSelector *self,
+    GtuberStreamContent content, gboolean include_adaptive)
+{
+  const GtuberStreamTraits *best = NULL;
+  guint i;
+
+  g_return_val_if_fail (GTUBER_IS_STREAM_SELECTOR (self), NULL);
+
+  for (i = 0; i < self->traits->len; i++) {
+    const GtuberStreamTraits *traits = &g_array_index (self->traits, GtuberStreamTraits, i);
+
+    if (traits->adaptive && !include_adaptive)
+      continue;
+    if (content != GTUBER_STREAM_CONTENT_UNKNOWN && traits->content != content)
+      continue;
+    if (!_get_traits_allowed (self, traits))
+      continue;
+
+    if (!best || _compare_traits_quality (traits, best) > 0)
+      best = traits;
+  }
+
+  if (!best)
+    return NULL;
+
+  g_debug ("Best stream itag: %u", best->itag);
+
+  return best->stream;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2021 Rafał Dzięgiel <rafostar.github@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#if !defined(__GTUBER_INSIDE__) && !defined(GTUBER_COMPILATION)
+#error "Only <gtuber/gtuber.h> and <gtuber/gtuber-plugin-devel.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+
+#include <gtuber/gtuber-enums.h>
+#include <gtuber/gtuber-stream.h>
+#include <gtuber/gtuber-media-info.h>
+
+G_BEGIN_DECLS
+
+#define GTUBER_TYPE_STREAM_SELECTOR            (gtuber_stream_selector_get_type ())
+#define GTUBER_IS_STREAM_SELECTOR(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTUBER_TYPE_STREAM_SELECTOR))
+#define GTUBER_IS_STREAM_SELECTOR_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GTUBER_TYPE_STREAM_SELECTOR))
+#define GTUBER_STREAM_SELECTOR_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GTUBER_TYPE_STREAM_SELECTOR, GtuberStreamSelectorClass))
+#define GTUBER_STREAM_SELECTOR(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTUBER_TYPE_STREAM_SELECTOR, GtuberStreamSelector))
+#define GTUBER_STREAM_SELECTOR_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GTUBER_TYPE_STREAM_SELECTOR, GtuberStreamSelectorClass))
+
+/**
+ * GtuberStreamSelector:
+ *
+ * Gtuber stream selector
+ */
+typedef struct _GtuberStreamSelector GtuberStreamSelector;
+typedef struct _GtuberStreamSelectorClass GtuberStreamSelectorClass;
+
+#ifdef G_DEFINE_AUTOPTR_CLEANUP_FUNC
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GtuberStreamSelector, g_object_unref)
+#endif
+
+GType                  gtuber_stream_selector_get_type                  (void);
+
+GtuberStreamSelector * gtuber_stream_selector_new                       (GtuberMediaInfo *info);
+
+GtuberMediaInfo *      gtuber_stream_selector_get_media_info            (GtuberStreamSelector *selector);
+
+GtuberCodecFlags       gtuber_stream_selector_get_codecs                (GtuberStreamSelector *selector);
+
+void                   gtuber_stream_selector_set_codecs                (GtuberStreamSelector *selector, GtuberCodecFlags codecs);
+
+guint                  gtuber_stream_selector_get_max_height            (GtuberStreamSelector *selector);
+
+void                   gtuber_stream_selector_set_max_height            (GtuberStreamSelector *selector, guint max_height);
+
+guint                  gtuber_stream_selector_get_max_fps               (GtuberStreamSelector *selector);
+
+void                   gtuber_stream_selector_set_max_fps               (GtuberStreamSelector *selector, guint max_fps);
+
+void                   gtuber_stream_selector_set_itags                 (GtuberStreamSelector *selector, const gchar *itags);
+
+GtuberStreamContent    gtuber_stream_selector_get_stream_content        (GtuberStreamSelector *selector, GtuberStream *stream);
+
+GtuberStream *         gtuber_stream_selector_get_stream_by_itag        (GtuberStreamSelector *selector, guint itag);
+
+gboolean               gtuber_stream_selector_is_stream_allowed         (GtuberStreamSelector *selector, GtuberStream *stream);
+
+GPtrArray *            gtuber_stream_selector_get_allowed_adaptive_streams (GtuberStreamSelector *selector);
+
+GtuberStream *         gtuber_stream_selector_get_best_stream           (GtuberStreamSelector *selector, GtuberStreamContent content, gboolean include_adaptive);
+
+G_END_DECLS
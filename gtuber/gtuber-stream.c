@@ -36,6 +36,7 @@ enum
 {
   PROP_0,
   PROP_URI,
+  PROP_FALLBACK_URIS,
   PROP_ITAG,
   PROP_MIME_TYPE,
   PROP_CODEC_FLAGS,
@@ -63,6 +64,7 @@ gtuber_stream_init (GtuberStream *self)
   self = gtuber_stream_get_instance_private (self);
 
   self->uri = NULL;
+  self->fallback_uris = NULL;
   self->itag = 0;
   self->mime_type = GTUBER_STREAM_MIME_TYPE_UNKNOWN;
   self->width = 0;
@@ -86,6 +88,10 @@ gtuber_stream_class_init (GtuberStreamClass *klass)
       "Stream URI", "The URI leading to stream", NULL,
       G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
 
+  param_specs[PROP_FALLBACK_URIS] = g_param_spec_boxed ("fallback-uris",
+      "Fallback URIs", "Alternative URIs leading to the same stream", G_TYPE_STRV,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
   param_specs[PROP_ITAG] = g_param_spec_uint ("itag",
      "Itag", "Stream identifier", 0, G_MAXUINT, 0,
      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
@@ -135,6 +141,9 @@ gtuber_stream_get_property (GObject *object, guint prop_id,
     case PROP_URI:
       g_value_set_string (value, gtuber_stream_get_uri (self));
       break;
+    case PROP_FALLBACK_URIS:
+      g_value_set_boxed (value, gtuber_stream_get_fallback_uris (self));
+      break;
     case PROP_ITAG:
       g_value_set_uint (value, gtuber_stream_get_itag (self));
       break;
@@ -176,6 +185,7 @@ gtuber_stream_finalize (GObject *object)
   g_debug ("Stream finalize, itag: %u", self->itag);
 
   g_free (self->uri);
+  g_strfreev (self->fallback_uris);
 
   g_free (self->vcodec);
   g_free (self->acodec);
@@ -230,6 +240,45 @@ gtuber_stream_set_uri (GtuberStream *self, const gchar *uri)
   self->uri = g_strdup (uri);
 }
 
+/**
+ * gtuber_stream_get_fallback_uris:
+ * @stream: a #GtuberStream
+ *
+ * Gets alternative URIs (e.g. other CDN mirrors) leading to the
+ * same stream, ordered from the most to the least preferred one.
+ *
+ * Returns: (transfer none) (nullable) (array zero-terminated=1): fallback
+ *   URIs of the stream or %NULL when there are none.
+ */
+const gchar *const *
+gtuber_stream_get_fallback_uris (GtuberStream *self)
+{
+  g_return_val_if_fail (GTUBER_IS_STREAM (self), NULL);
+
+  return (const gchar *const *) self->fallback_uris;
+}
+
+/**
+ * gtuber_stream_set_fallback_uris:
+ * @stream: a #GtuberStream
+ * @uris: (nullable) (array zero-terminated=1): a %NULL terminated array of URIs
+ *
+ * Sets alternative URIs leading to the same stream, ordered
+ * from the most to the least preferred one.
+ *
+ * This is mainly useful for plugin development.
+ */
+void
+gtuber_stream_set_fallback_uris (GtuberStream *self, const gchar *const *uris)
+{
+  g_return_if_fail (GTUBER_IS_STREAM (self));
+
+  g_strfreev (self->fallback_uris);
+  self->fallback_uris = (uris && uris[0])
+      ? g_strdupv ((gchar **) uris)
+      : NULL;
+}
+
 /**
  * gtuber_stream_get_itag:
  * @stream: a #GtuberStream
@@ -53,6 +53,8 @@ GType gtuber_stream_get_type                            (void);
 
 const gchar *        gtuber_stream_get_uri              (GtuberStream *stream);
 
+const gchar *const * gtuber_stream_get_fallback_uris    (GtuberStream *stream);
+
 guint                gtuber_stream_get_itag             (GtuberStream *stream);
 
 GtuberStreamMimeType gtuber_stream_get_mime_type        (GtuberStream *stream);
@@ -34,6 +34,10 @@ struct _GtuberWebsitePrivate
   gchar *tmp_dir_path;
 
   SoupCookieJar *jar;
+
+  gboolean chunked_parse;
+  gboolean fanout_race;
+  gboolean collection_only;
 };
 
 #define parent_class gtuber_website_parent_class
@@ -51,6 +55,19 @@ static GtuberFlow gtuber_website_read_response (GtuberWebsite *self,
     SoupMessage *msg, GError **error);
 static GtuberFlow gtuber_website_parse_input_stream (GtuberWebsite *self,
     GInputStream *stream, GtuberMediaInfo *info, GError **error);
+static GtuberFlow gtuber_website_parse_data_chunk (GtuberWebsite *self,
+    const gchar *chunk, gsize size, GtuberMediaInfo *info,
+    gboolean *finished, GError **error);
+static GtuberFlow gtuber_website_create_requests (GtuberWebsite *self,
+    GtuberMediaInfo *info, GPtrArray *msgs, GError **error);
+static GtuberFlow gtuber_website_parse_responses (GtuberWebsite *self,
+    GPtrArray *msgs, GPtrArray *bodies, GtuberMediaInfo *info, GError **error);
+static GtuberFlow gtuber_website_send_failed (GtuberWebsite *self,
+    SoupMessage *msg, GError **error);
+static GtuberFlow gtuber_website_create_collection_request (GtuberWebsite *self,
+    const gchar *continuation, SoupMessage **msg, GError **error);
+static GtuberFlow gtuber_website_parse_collection_page (GtuberWebsite *self,
+    GInputStream *stream, GPtrArray *entries, gchar **continuation, GError **error);
 static GtuberFlow gtuber_website_set_user_req_headers (GtuberWebsite *self,
     SoupMessageHeaders *req_headers, GHashTable *user_headers, GError **error);
 
@@ -72,6 +89,12 @@ gtuber_website_class_init (GtuberWebsiteClass *klass)
   website_class->create_request = gtuber_website_create_request;
   website_class->read_response = gtuber_website_read_response;
   website_class->parse_input_stream = gtuber_website_parse_input_stream;
+  website_class->parse_data_chunk = gtuber_website_parse_data_chunk;
+  website_class->create_requests = gtuber_website_create_requests;
+  website_class->parse_responses = gtuber_website_parse_responses;
+  website_class->send_failed = gtuber_website_send_failed;
+  website_class->create_collection_request = gtuber_website_create_collection_request;
+  website_class->parse_collection_page = gtuber_website_parse_collection_page;
   website_class->set_user_req_headers = gtuber_website_set_user_req_headers;
 }
 
@@ -169,6 +192,66 @@ gtuber_website_parse_input_stream (GtuberWebsite *self,
   return (*error == NULL) ? GTUBER_FLOW_OK : GTUBER_FLOW_ERROR;
 }
 
+static GtuberFlow
+gtuber_website_parse_data_chunk (GtuberWebsite *self,
+    const gchar *chunk, gsize size, GtuberMediaInfo *info,
+    gboolean *finished, GError **error)
+{
+  return (*error == NULL) ? GTUBER_FLOW_OK : GTUBER_FLOW_ERROR;
+}
+
+static GtuberFlow
+gtuber_website_create_requests (GtuberWebsite *self,
+    GtuberMediaInfo *info, GPtrArray *msgs, GError **error)
+{
+  return (*error == NULL) ? GTUBER_FLOW_OK : GTUBER_FLOW_ERROR;
+}
+
+static GtuberFlow
+gtuber_website_parse_responses (GtuberWebsite *self,
+    GPtrArray *msgs, GPtrArray *bodies, GtuberMediaInfo *info, GError **error)
+{
+  GtuberWebsiteClass *website_class = GTUBER_WEBSITE_GET_CLASS (self);
+  GtuberFlow flow = GTUBER_FLOW_OK;
+  guint i;
+
+  for (i = 0; i < bodies->len; i++) {
+    GInputStream *stream;
+
+    stream = g_memory_input_stream_new_from_bytes (g_ptr_array_index (bodies, i));
+    flow = website_class->parse_input_stream (self, stream, info, error);
+    g_object_unref (stream);
+
+    if (*error)
+      flow = GTUBER_FLOW_ERROR;
+    if (flow != GTUBER_FLOW_OK)
+      break;
+  }
+
+  return flow;
+}
+
+static GtuberFlow
+gtuber_website_send_failed (GtuberWebsite *self,
+    SoupMessage *msg, GError **error)
+{
+  return GTUBER_FLOW_ERROR;
+}
+
+static GtuberFlow
+gtuber_website_create_collection_request (GtuberWebsite *self,
+    const gchar *continuation, SoupMessage **msg, GError **error)
+{
+  return GTUBER_FLOW_ERROR;
+}
+
+static GtuberFlow
+gtuber_website_parse_collection_page (GtuberWebsite *self,
+    GInputStream *stream, GPtrArray *entries, gchar **continuation, GError **error)
+{
+  return (*error == NULL) ? GTUBER_FLOW_OK : GTUBER_FLOW_ERROR;
+}
+
 static void
 insert_user_header (const gchar *name, const gchar *value, GHashTable *user_headers)
 {
@@ -180,6 +263,7 @@ insert_user_header (const gchar *name, const gchar *value, GHashTable *user_head
       || !strcmp (name, "Content-Length")
       || !strcmp (name, "Content-Type")
       || !strcmp (name, "Host")
+      || !strcmp (name, "Range")
       || !strcmp (name, "Authorization")
       || !strcmp (name, "Cookie"))
     return;
@@ -362,3 +446,131 @@ gtuber_website_get_cookies_jar (GtuberWebsite *self)
 
   return priv->jar;
 }
+
+/**
+ * gtuber_website_get_chunked_parse:
+ * @website: a #GtuberWebsite
+ *
+ * Returns: %TRUE if response data is passed to plugin in chunks, %FALSE otherwise.
+ */
+gboolean
+gtuber_website_get_chunked_parse (GtuberWebsite *self)
+{
+  GtuberWebsitePrivate *priv;
+
+  g_return_val_if_fail (GTUBER_IS_WEBSITE (self), FALSE);
+
+  priv = gtuber_website_get_instance_private (self);
+
+  return priv->chunked_parse;
+}
+
+/**
+ * gtuber_website_set_chunked_parse:
+ * @website: a #GtuberWebsite
+ * @chunked: whether to parse response data in chunks
+ *
+ * When enabled, response body will be passed to `parse_data_chunk` vfunc
+ * as it arrives instead of calling `parse_input_stream` with the whole stream.
+ * This allows plugin to start processing data early and to stop the download
+ * once it has everything it needs.
+ *
+ * Can be changed before each request.
+ */
+void
+gtuber_website_set_chunked_parse (GtuberWebsite *self, gboolean chunked)
+{
+  GtuberWebsitePrivate *priv;
+
+  g_return_if_fail (GTUBER_IS_WEBSITE (self));
+
+  priv = gtuber_website_get_instance_private (self);
+
+  priv->chunked_parse = chunked;
+}
+
+/**
+ * gtuber_website_get_fanout_race:
+ * @website: a #GtuberWebsite
+ *
+ * Returns: %TRUE if fanout requests race for the first accepted
+ *   response, %FALSE otherwise.
+ */
+gboolean
+gtuber_website_get_fanout_race (GtuberWebsite *self)
+{
+  GtuberWebsitePrivate *priv;
+
+  g_return_val_if_fail (GTUBER_IS_WEBSITE (self), FALSE);
+
+  priv = gtuber_website_get_instance_private (self);
+
+  return priv->fanout_race;
+}
+
+/**
+ * gtuber_website_set_fanout_race:
+ * @website: a #GtuberWebsite
+ * @race: whether fanout requests should race each other
+ *
+ * When enabled, messages created with `create_requests` vfunc are
+ * alternative ways of obtaining the same data. Each response is passed
+ * to `parse_responses` alone, as soon as it arrives. Plugin rejects it by
+ * setting an error, otherwise it wins and remaining requests are cancelled.
+ * When all responses are rejected, the last error is returned.
+ *
+ * Plugin must not modify #GtuberMediaInfo before rejecting a response.
+ *
+ * Can be changed before each request.
+ */
+void
+gtuber_website_set_fanout_race (GtuberWebsite *self, gboolean race)
+{
+  GtuberWebsitePrivate *priv;
+
+  g_return_if_fail (GTUBER_IS_WEBSITE (self));
+
+  priv = gtuber_website_get_instance_private (self);
+
+  priv->fanout_race = race;
+}
+
+/**
+ * gtuber_website_get_collection_only:
+ * @website: a #GtuberWebsite
+ *
+ * Returns: %TRUE if URI points only to a collection of media, %FALSE otherwise.
+ */
+gboolean
+gtuber_website_get_collection_only (GtuberWebsite *self)
+{
+  GtuberWebsitePrivate *priv;
+
+  g_return_val_if_fail (GTUBER_IS_WEBSITE (self), FALSE);
+
+  priv = gtuber_website_get_instance_private (self);
+
+  return priv->collection_only;
+}
+
+/**
+ * gtuber_website_set_collection_only:
+ * @website: a #GtuberWebsite
+ * @collection_only: whether URI points only to a collection of media
+ *
+ * Plugin should enable this from `plugin_query` when given URI can only
+ * be expanded with gtuber_client_expand_collection(), as it does not point
+ * to any single media. Such URI is not reported as supported by
+ * gtuber_has_plugin_for_uri().
+ */
+void
+gtuber_website_set_collection_only (GtuberWebsite *self, gboolean collection_only)
+{
+  GtuberWebsitePrivate *priv;
+
+  g_return_if_fail (GTUBER_IS_WEBSITE (self));
+
+  priv = gtuber_website_get_instance_private (self);
+
+  priv->collection_only = collection_only;
+}
@@ -189,6 +189,32 @@ struct _GtuberWebsite
  * @parse_input_stream: Read #GInputStream and fill #GtuberMediaInfo.
  * @set_user_req_headers: Set request headers for user. Default implementation
  *   will set them from last #SoupMessage, skipping some common and invalid ones.
+ * @parse_data_chunk: Parse next chunk of response body as it arrives and fill
+ *   #GtuberMediaInfo. Used instead of @parse_input_stream when chunked parse was
+ *   enabled with gtuber_website_set_chunked_parse(). Called with %NULL chunk after
+ *   all data was read. Set @finished to %TRUE to stop downloading remaining data.
+ * @create_requests: Add multiple #SoupMessage to send concurrently into passed
+ *   #GPtrArray. Called after @create_request returned %GTUBER_FLOW_FANOUT.
+ * @parse_responses: Parse response bodies of all messages created with
+ *   @create_requests and fill #GtuberMediaInfo. Bodies are passed as #GBytes
+ *   in the same order as messages. Default implementation calls
+ *   @parse_input_stream for each of them. With fanout race enabled
+ *   (see gtuber_website_set_fanout_race()), called with each single
+ *   response until one of them is accepted.
+ * @send_failed: Called when #SoupMessage could not be sent (e.g. connection
+ *   timed out). Plugin may clear the error and return %GTUBER_FLOW_RESTART
+ *   to retry, possibly with a different host. For messages created with
+ *   @create_requests, plugin may also clear the error and return
+ *   %GTUBER_FLOW_OK to continue with an empty body for that message.
+ *   Default implementation returns %GTUBER_FLOW_ERROR.
+ * @create_collection_request: Create #SoupMessage for a page of entries of
+ *   a collection (e.g. playlist or channel). Called with %NULL @continuation
+ *   for the first page, then with continuation obtained from the previous
+ *   page. Default implementation returns %GTUBER_FLOW_ERROR as collections
+ *   are not supported.
+ * @parse_collection_page: Parse a page of collection entries. Add URIs of
+ *   entries into passed #GPtrArray and set @continuation to a newly allocated
+ *   string if there are more pages to request.
  */
 struct _GtuberWebsiteClass
 {
@@ -214,6 +240,42 @@ struct _GtuberWebsiteClass
                                        SoupMessageHeaders *req_headers,
                                        GHashTable         *user_headers,
                                        GError            **error);
+
+  GtuberFlow (* parse_data_chunk) (GtuberWebsite   *website,
+                                   const gchar     *chunk,
+                                   gsize            size,
+                                   GtuberMediaInfo *info,
+                                   gboolean        *finished,
+                                   GError         **error);
+
+  GtuberFlow (* create_requests) (GtuberWebsite   *website,
+                                  GtuberMediaInfo *info,
+                                  GPtrArray       *msgs,
+                                  GError         **error);
+
+  GtuberFlow (* parse_responses) (GtuberWebsite   *website,
+                                  GPtrArray       *msgs,
+                                  GPtrArray       *bodies,
+                                  GtuberMediaInfo *info,
+                                  GError         **error);
+
+  GtuberFlow (* send_failed) (GtuberWebsite *website,
+                              SoupMessage   *msg,
+                              GError       **error);
+
+  GtuberFlow (* create_collection_request) (GtuberWebsite *website,
+                                            const gchar   *continuation,
+                                            SoupMessage  **msg,
+                                            GError       **error);
+
+  GtuberFlow (* parse_collection_page) (GtuberWebsite *website,
+                                        GInputStream  *stream,
+                                        GPtrArray     *entries,
+                                        gchar        **continuation,
+                                        GError       **error);
+
+  /* < private > */
+  gpointer _gtuber_reserved[16];
 };
 
 GType           gtuber_website_get_type              (void);
@@ -228,6 +290,18 @@ gboolean        gtuber_website_set_uri_from_string   (GtuberWebsite *website, co
 
 SoupCookieJar * gtuber_website_get_cookies_jar       (GtuberWebsite *website);
 
+gboolean        gtuber_website_get_chunked_parse     (GtuberWebsite *website);
+
+void            gtuber_website_set_chunked_parse     (GtuberWebsite *website, gboolean chunked);
+
+gboolean        gtuber_website_get_fanout_race       (GtuberWebsite *website);
+
+void            gtuber_website_set_fanout_race       (GtuberWebsite *website, gboolean race);
+
+gboolean        gtuber_website_get_collection_only   (GtuberWebsite *website);
+
+void            gtuber_website_set_collection_only   (GtuberWebsite *website, gboolean collection_only);
+
 GQuark          gtuber_website_error_quark           (void);
 
 G_END_DECLS
@@ -28,6 +28,7 @@
 #include <gtuber/gtuber-stream.h>
 #include <gtuber/gtuber-adaptive-stream.h>
 #include <gtuber/gtuber-media-info.h>
+#include <gtuber/gtuber-stream-selector.h>
 #include <gtuber/gtuber-manifest-generator.h>
 #include <gtuber/gtuber-misc-functions.h>
 #include <gtuber/gtuber-version.h>
@@ -30,9 +30,24 @@ GTUBER_WEBSITE_PLUGIN_EXPORT_HOSTS (
 #define parent_class gtuber_bilibili_parent_class
 GTUBER_WEBSITE_PLUGIN_DEFINE (Bilibili, bilibili)
 
+/* Amount of data downloaded from each mirror to measure its speed */
+#define MIRROR_PROBE_BYTES (256 * 1024)
+
+/* How long measured mirror speed is remembered (6 hours) */
+#define MIRROR_KBPS_EXP (6 * 60 * 60)
+
+/* Failed probe might be a transient error, so retry it soon (5 minutes) */
+#define MIRROR_FAIL_EXP (5 * 60)
+
+/* Set to skip mirror speed measurement and keep API order */
+#define GTUBER_BILIBILI_NO_MIRROR_PROBE_ENV "GTUBER_BILIBILI_NO_MIRROR_PROBE"
+
 static void
 gtuber_bilibili_init (GtuberBilibili *self)
 {
+  self->mirrors_kbps = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->probe_uris = g_ptr_array_new_with_free_func (g_free);
+  self->probe_mirrors = (g_getenv (GTUBER_BILIBILI_NO_MIRROR_PROBE_ENV) == NULL);
 }
 
 static void
@@ -44,6 +59,9 @@ gtuber_bilibili_finalize (GObject *object)
   g_free (self->video_id);
   g_free (self->bvid);
 
+  g_hash_table_unref (self->mirrors_kbps);
+  g_ptr_array_unref (self->probe_uris);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -77,6 +95,169 @@ _get_id_name (GtuberBilibili *self)
   return NULL;
 }
 
+static gchar *
+_obtain_uri_host (const gchar *uri_str)
+{
+  GUri *guri;
+  gchar *host = NULL;
+
+  if ((guri = g_uri_parse (uri_str, G_URI_FLAGS_ENCODED, NULL))) {
+    host = g_strdup (g_uri_get_host (guri));
+    g_uri_unref (guri);
+  }
+
+  return host;
+}
+
+static gchar *
+_mirror_kbps_cache_key (const gchar *host)
+{
+  return g_strjoin (".", "mirror_kbps", host, NULL);
+}
+
+static void
+_add_mirror (GtuberBilibili *self, const gchar *uri, GPtrArray *uris)
+{
+  gchar *host, *key, *value;
+  guint i;
+
+  if (!uri || !(host = _obtain_uri_host (uri)))
+    return;
+
+  for (i = 0; i < uris->len; i++) {
+    if (g_str_equal (g_ptr_array_index (uris, i), uri))
+      goto finish;
+  }
+  g_ptr_array_add (uris, g_strdup (uri));
+
+  if (g_hash_table_contains (self->mirrors_kbps, host))
+    goto finish;
+
+  /* Speed measured earlier */
+  key = _mirror_kbps_cache_key (host);
+  value = gtuber_bilibili_cache_read (key);
+  g_free (key);
+
+  if (value) {
+    g_debug ("Mirror %s cached speed: %s kbps", host, value);
+    g_hash_table_insert (self->mirrors_kbps, host,
+        GUINT_TO_POINTER (g_ascii_strtoull (value, NULL, 10)));
+    g_free (value);
+
+    return;
+  }
+
+  if (!self->probe_mirrors)
+    goto finish;
+
+  /* Probe each unknown host only once */
+  for (i = 0; i < self->probe_uris->len; i++) {
+    gchar *probe_host = _obtain_uri_host (g_ptr_array_index (self->probe_uris, i));
+    gboolean found = !g_strcmp0 (probe_host, host);
+
+    g_free (probe_host);
+
+    if (found)
+      goto finish;
+  }
+  g_ptr_array_add (self->probe_uris, g_strdup (uri));
+
+finish:
+  g_free (host);
+}
+
+static void
+_read_dash_stream_mirrors (GtuberBilibili *self, JsonReader *reader, GtuberStream *stream)
+{
+  GPtrArray *uris;
+  const gchar *base_url;
+
+  uris = g_ptr_array_new_with_free_func (g_free);
+
+  base_url = gtuber_utils_json_get_string (reader, "base_url", NULL);
+  if (!base_url)
+    base_url = gtuber_utils_json_get_string (reader, "baseUrl", NULL);
+
+  _add_mirror (self, base_url, uris);
+
+  if (gtuber_utils_json_go_to (reader, "backup_url", NULL)
+      || gtuber_utils_json_go_to (reader, "backupUrl", NULL)) {
+    gint i, count = json_reader_count_elements (reader);
+
+    for (i = 0; i < count; i++) {
+      if (json_reader_read_element (reader, i))
+        _add_mirror (self, json_reader_get_string_value (reader), uris);
+      json_reader_end_element (reader);
+    }
+    gtuber_utils_json_go_back (reader, 1);
+  }
+
+  if (uris->len > 0) {
+    gtuber_stream_set_uri (stream, g_ptr_array_index (uris, 0));
+
+    /* Remaining mirrors become fallbacks */
+    g_ptr_array_add (uris, NULL);
+    gtuber_stream_set_fallback_uris (stream,
+        (const gchar *const *) uris->pdata + 1);
+  }
+  g_ptr_array_unref (uris);
+}
+
+static gint
+_sort_mirrors_cb (const gchar **a, const gchar **b, GtuberBilibili *self)
+{
+  gchar *host_a, *host_b;
+  guint kbps_a, kbps_b;
+
+  host_a = _obtain_uri_host (*a);
+  host_b = _obtain_uri_host (*b);
+
+  kbps_a = GPOINTER_TO_UINT (g_hash_table_lookup (self->mirrors_kbps, host_a));
+  kbps_b = GPOINTER_TO_UINT (g_hash_table_lookup (self->mirrors_kbps, host_b));
+
+  g_free (host_a);
+  g_free (host_b);
+
+  /* Faster mirrors first */
+  return (kbps_a < kbps_b) - (kbps_a > kbps_b);
+}
+
+static void
+_sort_stream_mirrors_cb (GtuberStream *stream, GtuberBilibili *self)
+{
+  const gchar *const *fallback_uris;
+  GPtrArray *uris;
+  guint i;
+
+  if (!(fallback_uris = gtuber_stream_get_fallback_uris (stream)))
+    return;
+
+  uris = g_ptr_array_new_with_free_func (g_free);
+  g_ptr_array_add (uris, g_strdup (gtuber_stream_get_uri (stream)));
+
+  for (i = 0; fallback_uris[i]; i++)
+    g_ptr_array_add (uris, g_strdup (fallback_uris[i]));
+
+  g_ptr_array_sort_with_data (uris, (GCompareDataFunc) _sort_mirrors_cb, self);
+
+  gtuber_stream_set_uri (stream, g_ptr_array_index (uris, 0));
+  g_debug ("Picked mirror for itag %u: %s",
+      gtuber_stream_get_itag (stream), gtuber_stream_get_uri (stream));
+
+  g_ptr_array_add (uris, NULL);
+  gtuber_stream_set_fallback_uris (stream,
+      (const gchar *const *) uris->pdata + 1);
+
+  g_ptr_array_unref (uris);
+}
+
+static void
+_sort_media_mirrors (GtuberBilibili *self, GtuberMediaInfo *info)
+{
+  g_ptr_array_foreach (gtuber_media_info_get_adaptive_streams (info),
+      (GFunc) _sort_stream_mirrors_cb, self);
+}
+
 static void
 _read_dash_stream_cb (JsonReader *reader, GtuberMediaInfo *info, GtuberBilibili *self)
 {
@@ -143,7 +324,7 @@ _read_dash_stream_cb (JsonReader *reader, GtuberMediaInfo *info, GtuberBilibili
   gtuber_stream_set_bitrate (stream, gtuber_utils_json_get_int (reader, "bandwidth", NULL));
   gtuber_stream_set_width (stream, gtuber_utils_json_get_int (reader, "width", NULL));
   gtuber_stream_set_height (stream, gtuber_utils_json_get_int (reader, "height", NULL));
-  gtuber_stream_set_uri (stream, gtuber_utils_json_get_string (reader, "base_url", NULL));
+  _read_dash_stream_mirrors (self, reader, stream);
 
   gtuber_media_info_add_adaptive_stream (info, astream);
 }
@@ -230,16 +411,46 @@ parse_media_streams (GtuberBilibili *self, JsonReader *reader,
   if (*error)
     return GTUBER_FLOW_ERROR;
 
+  /* Measure speed of mirrors we know nothing about
+   * yet, otherwise pick from the cached history */
+  if (self->probe_uris->len > 0
+      && g_hash_table_size (self->mirrors_kbps) + self->probe_uris->len > 1) {
+    g_debug ("Probing %u mirrors", self->probe_uris->len);
+    self->probing = TRUE;
+
+    return GTUBER_FLOW_RESTART;
+  }
+
+  _sort_media_mirrors (self, info);
+
   return GTUBER_FLOW_OK;
 }
 
+static void
+_set_page_req_headers (GtuberWebsite *website, SoupMessageHeaders *headers)
+{
+  gchar *origin;
+
+  origin = g_strdup_printf ("%s://%s",
+      g_uri_get_scheme (gtuber_website_get_uri (website)),
+      g_uri_get_host (gtuber_website_get_uri (website)));
+
+  soup_message_headers_replace (headers, "Origin", origin);
+  soup_message_headers_replace (headers,
+      "Referer", gtuber_website_get_uri_string (website));
+
+  g_free (origin);
+}
+
 static GtuberFlow
 gtuber_bilibili_create_request (GtuberWebsite *website,
     GtuberMediaInfo *info, SoupMessage **msg, GError **error)
 {
   GtuberBilibili *self = GTUBER_BILIBILI (website);
-  SoupMessageHeaders *headers;
-  gchar *origin, *uri_str = NULL;
+  gchar *uri_str = NULL;
+
+  if (self->probing)
+    return GTUBER_FLOW_FANOUT;
 
   switch (self->bili_type) {
     case BILIBILI_BV:
@@ -262,17 +473,114 @@ gtuber_bilibili_create_request (GtuberWebsite *website,
   g_debug ("URI: %s", uri_str);
   g_free (uri_str);
 
-  headers = soup_message_get_request_headers (*msg);
+  _set_page_req_headers (website, soup_message_get_request_headers (*msg));
 
-  origin = g_strdup_printf ("%s://%s",
-      g_uri_get_scheme (gtuber_website_get_uri (website)),
-      g_uri_get_host (gtuber_website_get_uri (website)));
+  return GTUBER_FLOW_OK;
+}
 
-  soup_message_headers_replace (headers, "Origin", origin);
-  soup_message_headers_replace (headers,
-      "Referer", gtuber_website_get_uri_string (website));
+static GtuberFlow
+gtuber_bilibili_create_requests (GtuberWebsite *website,
+    GtuberMediaInfo *info, GPtrArray *msgs, GError **error)
+{
+  GtuberBilibili *self = GTUBER_BILIBILI (website);
+  guint i;
 
-  g_free (origin);
+  for (i = 0; i < self->probe_uris->len; i++) {
+    SoupMessage *msg;
+    SoupMessageHeaders *headers;
+
+    msg = soup_message_new ("GET", g_ptr_array_index (self->probe_uris, i));
+    if (!msg)
+      continue;
+
+    soup_message_add_flags (msg, SOUP_MESSAGE_COLLECT_METRICS);
+
+    headers = soup_message_get_request_headers (msg);
+    soup_message_headers_set_range (headers, 0, MIRROR_PROBE_BYTES - 1);
+    _set_page_req_headers (website, headers);
+
+    g_ptr_array_add (msgs, msg);
+  }
+
+  return GTUBER_FLOW_OK;
+}
+
+static GtuberFlow
+gtuber_bilibili_read_response (GtuberWebsite *website,
+    SoupMessage *msg, GError **error)
+{
+  GtuberBilibili *self = GTUBER_BILIBILI (website);
+
+  /* Unreachable mirror is not an error, it just will not be picked */
+  if (self->probing)
+    return GTUBER_FLOW_OK;
+
+  return GTUBER_WEBSITE_CLASS (parent_class)->read_response (website, msg, error);
+}
+
+static GtuberFlow
+gtuber_bilibili_send_failed (GtuberWebsite *website,
+    SoupMessage *msg, GError **error)
+{
+  GtuberBilibili *self = GTUBER_BILIBILI (website);
+
+  if (self->probing) {
+    g_debug ("Mirror probe failed: %s", (*error)->message);
+    g_clear_error (error);
+
+    return GTUBER_FLOW_OK;
+  }
+
+  return GTUBER_WEBSITE_CLASS (parent_class)->send_failed (website, msg, error);
+}
+
+static GtuberFlow
+gtuber_bilibili_parse_responses (GtuberWebsite *website,
+    GPtrArray *msgs, GPtrArray *bodies, GtuberMediaInfo *info, GError **error)
+{
+  GtuberBilibili *self = GTUBER_BILIBILI (website);
+  guint i;
+
+  for (i = 0; i < msgs->len; i++) {
+    SoupMessage *msg = g_ptr_array_index (msgs, i);
+    SoupMessageMetrics *metrics;
+    guint status, kbps = 0;
+    gsize size;
+    gchar *host, *key, *value;
+
+    status = soup_message_get_status (msg);
+    size = g_bytes_get_size (g_ptr_array_index (bodies, i));
+    metrics = soup_message_get_metrics (msg);
+
+    if (SOUP_STATUS_IS_SUCCESSFUL (status) && size > 0 && metrics) {
+      guint64 elapsed;
+
+      /* Time in microseconds, includes connecting to the mirror */
+      elapsed = soup_message_metrics_get_response_end (metrics)
+          - soup_message_metrics_get_fetch_start (metrics);
+
+      if (elapsed > 0)
+        kbps = MAX ((size * 8 * 1000) / elapsed, 1);
+    }
+
+    host = g_strdup (g_uri_get_host (soup_message_get_uri (msg)));
+    g_debug ("Mirror %s speed: %u kbps", host, kbps);
+
+    key = _mirror_kbps_cache_key (host);
+    value = g_strdup_printf ("%u", kbps);
+    gtuber_bilibili_cache_write (key, value,
+        (kbps > 0) ? MIRROR_KBPS_EXP : MIRROR_FAIL_EXP);
+    g_free (key);
+    g_free (value);
+
+    /* Hash table takes host ownership */
+    g_hash_table_insert (self->mirrors_kbps, host, GUINT_TO_POINTER (kbps));
+  }
+
+  self->probing = FALSE;
+  g_ptr_array_set_size (self->probe_uris, 0);
+
+  _sort_media_mirrors (self, info);
 
   return GTUBER_FLOW_OK;
 }
@@ -336,7 +644,11 @@ gtuber_bilibili_class_init (GtuberBilibiliClass *klass)
   gobject_class->finalize = gtuber_bilibili_finalize;
 
   website_class->create_request = gtuber_bilibili_create_request;
+  website_class->read_response = gtuber_bilibili_read_response;
   website_class->parse_input_stream = gtuber_bilibili_parse_input_stream;
+  website_class->create_requests = gtuber_bilibili_create_requests;
+  website_class->parse_responses = gtuber_bilibili_parse_responses;
+  website_class->send_failed = gtuber_bilibili_send_failed;
 }
 
 GtuberWebsite *
@@ -50,6 +50,12 @@ struct _GtuberBilibili
   BilibiliType bili_type;
 
   gboolean had_info;
+
+  /* CDN mirror host -> measured throughput (kbps) */
+  GHashTable *mirrors_kbps;
+  GPtrArray *probe_uris;
+  gboolean probe_mirrors;
+  gboolean probing;
 };
 
 GtuberFlow bilibili_get_flow_from_plugin_props (GtuberBilibili *self, GError **error);
@@ -30,6 +30,9 @@
 #define CRUNCHYROLL_DEFAULT_LANG  "en-US"
 #define CRUNCHYROLL_DEFAULT_AUDIO "ja-JP"
 
+/* Media ID of video version does not change, so keep it for a week */
+#define CRUNCHYROLL_MEDIA_GUID_EXP (7 * 24 * 60 * 60)
+
 GTUBER_WEBSITE_PLUGIN_EXPORT_HOSTS (
   CRUNCHYROLL_DEFAULT_HOST,
   NULL
@@ -79,6 +82,8 @@ struct _GtuberCrunchyroll
   gchar *policy_response;
   gchar *media_guid;
   gchar *hls_uri;
+
+  gboolean reauthenticated;
 };
 
 #define parent_class gtuber_crunchyroll_parent_class
@@ -149,6 +154,28 @@ _make_cms_request (GtuberCrunchyroll *self, const gchar *subpath, GError **error
   return msg;
 }
 
+static gchar *
+_access_token_cache_key (GtuberCrunchyroll *self)
+{
+  gchar *etp_rt_sum, *key;
+
+  if (!self->etp_rt)
+    return g_strdup ("access_token");
+
+  /* Token belongs to the account it was created for */
+  etp_rt_sum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, self->etp_rt, -1);
+  key = g_strjoin (".", "access_token", etp_rt_sum, NULL);
+  g_free (etp_rt_sum);
+
+  return key;
+}
+
+static gchar *
+_media_guid_cache_key (GtuberCrunchyroll *self)
+{
+  return g_strjoin (".", "media_guid", self->video_id, NULL);
+}
+
 static gboolean
 _enter_lang_fuzzy (JsonReader *reader, const gchar *req_lang)
 {
@@ -268,21 +295,13 @@ static void
 read_auth_token (GtuberCrunchyroll *self, GInputStream *stream, GError **error)
 {
   JsonReader *reader;
-  xmlDoc *doc;
-  gchar *data, *json_str;
-
-  if (!(data = gtuber_utils_common_input_stream_to_data (stream, error)))
-    return;
+  gchar *json_str;
 
-  doc = gtuber_utils_xml_load_html_from_data (data, error);
-  g_free (data);
+  json_str = gtuber_utils_xml_obtain_json_in_stream (stream, "__APP_CONFIG__", error);
 
-  if (!doc)
+  if (*error)
     return;
 
-  json_str = gtuber_utils_xml_obtain_json_in_node (doc, "__APP_CONFIG__");
-  xmlFreeDoc (doc);
-
   if (!json_str) {
     g_set_error (error, GTUBER_WEBSITE_ERROR,
         GTUBER_WEBSITE_ERROR_PARSE_FAILED,
@@ -323,6 +342,7 @@ static void
 read_access_token (GtuberCrunchyroll *self, GInputStream *stream, GError **error)
 {
   JsonReader *reader;
+  gint64 expires_in;
 
   g_debug ("Reading access token");
 
@@ -331,6 +351,7 @@ read_access_token (GtuberCrunchyroll *self, GInputStream *stream, GError **error
 
   self->access_token = g_strdup (gtuber_utils_json_get_string (reader, "access_token", NULL));
   self->token_type = g_strdup (gtuber_utils_json_get_string (reader, "token_type", NULL));
+  expires_in = gtuber_utils_json_get_int (reader, "expires_in", NULL);
 
   g_object_unref (reader);
 
@@ -338,6 +359,20 @@ read_access_token (GtuberCrunchyroll *self, GInputStream *stream, GError **error
     g_set_error (error, GTUBER_WEBSITE_ERROR,
         GTUBER_WEBSITE_ERROR_PARSE_FAILED,
         "Could not obtain access token data");
+    return;
+  }
+
+  /* Leave some margin, so token does not expire while we use it */
+  if (expires_in > 60) {
+    gchar *key, *value;
+
+    key = _access_token_cache_key (self);
+    value = g_strjoin (" ", self->token_type, self->access_token, NULL);
+
+    gtuber_crunchyroll_cache_write (key, value, expires_in - 30);
+
+    g_free (key);
+    g_free (value);
   }
 }
 
@@ -400,6 +435,7 @@ read_media_info (GtuberCrunchyroll *self, GInputStream *stream,
 {
   JsonReader *reader;
   const gchar *audio_locale, *series_title, *ep_title;
+  gchar *media_guid = NULL;
   gint i, versions_count;
 
   g_debug ("Reading media info");
@@ -442,23 +478,36 @@ read_media_info (GtuberCrunchyroll *self, GInputStream *stream,
 
         audio_ver = gtuber_utils_json_get_string (reader, "audio_locale", NULL);
         if (!g_strcmp0 (audio_locale, audio_ver))
-          self->media_guid = g_strdup (gtuber_utils_json_get_string (reader, "media_guid", NULL));
+          media_guid = g_strdup (gtuber_utils_json_get_string (reader, "media_guid", NULL));
 
         gtuber_utils_json_go_back (reader, 1);
       }
-      if (self->media_guid)
+      if (media_guid)
         break;
     }
     gtuber_utils_json_go_back (reader, 2);
   }
 
-  if (!self->media_guid) {
+  if (!media_guid) {
     g_set_error (error, GTUBER_WEBSITE_ERROR,
         GTUBER_WEBSITE_ERROR_PARSE_FAILED,
         "Could not extract stream media ID");
     goto finish;
   }
-  g_debug ("Found stream media ID: %s", self->media_guid);
+  g_debug ("Found stream media ID: %s", media_guid);
+
+  if (g_strcmp0 (self->media_guid, media_guid)) {
+    gchar *key;
+
+    g_free (self->media_guid);
+    self->media_guid = media_guid;
+
+    key = _media_guid_cache_key (self);
+    gtuber_crunchyroll_cache_write (key, self->media_guid, CRUNCHYROLL_MEDIA_GUID_EXP);
+    g_free (key);
+  } else {
+    g_free (media_guid);
+  }
 
   gtuber_media_info_set_id (info, gtuber_utils_json_get_string (reader, "id", NULL));
 
@@ -608,6 +657,39 @@ gtuber_crunchyroll_prepare (GtuberWebsite *website)
       self->step = CRUNCHYROLL_GET_POLICY_RESPONSE + 1;
   }
 
+  /* Otherwise try to skip at least authorization steps */
+  if (!self->policy_response) {
+    gchar *key, *cached_token;
+
+    key = _access_token_cache_key (self);
+
+    if ((cached_token = gtuber_crunchyroll_cache_read (key))) {
+      gchar **parts = g_strsplit (cached_token, " ", 2);
+
+      if (parts[0] && parts[1]) {
+        self->token_type = g_strdup (parts[0]);
+        self->access_token = g_strdup (parts[1]);
+        self->step = CRUNCHYROLL_GET_POLICY_RESPONSE;
+
+        g_debug ("Restored cached access token");
+      }
+
+      g_strfreev (parts);
+      g_free (cached_token);
+    }
+    g_free (key);
+  }
+
+  /* With known media ID, media info and streams are requested together */
+  if (self->video_id) {
+    gchar *key = _media_guid_cache_key (self);
+
+    self->media_guid = gtuber_crunchyroll_cache_read (key);
+    g_debug ("Cached stream media ID: %s", self->media_guid);
+
+    g_free (key);
+  }
+
   ext_lang = gtuber_utils_common_obtain_uri_id_from_paths (
       gtuber_website_get_uri (website), NULL, "/", NULL);
 
@@ -633,6 +715,23 @@ gtuber_crunchyroll_prepare (GtuberWebsite *website)
   g_debug ("Using language: %s", self->language);
 }
 
+static void
+_set_req_headers (GtuberCrunchyroll *self, SoupMessage *msg)
+{
+  SoupMessageHeaders *headers;
+  gchar *referer;
+
+  headers = soup_message_get_request_headers (msg);
+  referer = g_uri_to_string_partial (gtuber_website_get_uri (GTUBER_WEBSITE (self)),
+      G_URI_HIDE_QUERY | G_URI_HIDE_FRAGMENT);
+
+  soup_message_headers_replace (headers, "Origin", CRUNCHYROLL_DEFAULT_URI);
+  soup_message_headers_replace (headers, "Referer", referer);
+  soup_message_headers_replace (headers, "Accept-Language", "*");
+
+  g_free (referer);
+}
+
 static GtuberFlow
 gtuber_crunchyroll_create_request (GtuberWebsite *website,
     GtuberMediaInfo *info, SoupMessage **msg, GError **error)
@@ -641,6 +740,9 @@ gtuber_crunchyroll_create_request (GtuberWebsite *website,
 
   g_debug ("Create request step: %u", self->step);
 
+  if (self->step == CRUNCHYROLL_GET_MEDIA_INFO && self->media_guid)
+    return GTUBER_FLOW_FANOUT;
+
   switch (self->step) {
     case CRUNCHYROLL_GET_AUTH_TOKEN:
       *msg = soup_message_new_from_uri ("GET", gtuber_website_get_uri (website));
@@ -665,19 +767,29 @@ gtuber_crunchyroll_create_request (GtuberWebsite *website,
       break;
   }
 
-  if (*msg) {
-    SoupMessageHeaders *headers;
-    gchar *referer;
+  if (*msg)
+    _set_req_headers (self, *msg);
 
-    headers = soup_message_get_request_headers (*msg);
-    referer = g_uri_to_string_partial (gtuber_website_get_uri (website),
-        G_URI_HIDE_QUERY | G_URI_HIDE_FRAGMENT);
+  return (*error)
+      ? GTUBER_FLOW_ERROR
+      : GTUBER_FLOW_OK;
+}
 
-    soup_message_headers_replace (headers, "Origin", CRUNCHYROLL_DEFAULT_URI);
-    soup_message_headers_replace (headers, "Referer", referer);
-    soup_message_headers_replace (headers, "Accept-Language", "*");
+static GtuberFlow
+gtuber_crunchyroll_create_requests (GtuberWebsite *website,
+    GtuberMediaInfo *info, GPtrArray *msgs, GError **error)
+{
+  GtuberCrunchyroll *self = GTUBER_CRUNCHYROLL (website);
+  SoupMessage *msg;
 
-    g_free (referer);
+  /* Media info first, then streams data */
+  if ((msg = obtain_media_info_msg (self, error))) {
+    _set_req_headers (self, msg);
+    g_ptr_array_add (msgs, msg);
+  }
+  if (!*error && (msg = obtain_streams_data_msg (self, error))) {
+    _set_req_headers (self, msg);
+    g_ptr_array_add (msgs, msg);
   }
 
   return (*error)
@@ -685,6 +797,99 @@ gtuber_crunchyroll_create_request (GtuberWebsite *website,
       : GTUBER_FLOW_OK;
 }
 
+static GtuberFlow
+gtuber_crunchyroll_parse_responses (GtuberWebsite *website,
+    GPtrArray *msgs, GPtrArray *bodies, GtuberMediaInfo *info, GError **error)
+{
+  GtuberCrunchyroll *self = GTUBER_CRUNCHYROLL (website);
+  GInputStream *stream;
+  gchar *cached_guid;
+  gboolean outdated;
+
+  if (bodies->len != 2) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_OTHER,
+        "Could not request media info and streams data");
+    return GTUBER_FLOW_ERROR;
+  }
+
+  cached_guid = g_strdup (self->media_guid);
+
+  stream = g_memory_input_stream_new_from_bytes (g_ptr_array_index (bodies, 0));
+  read_media_info (self, stream, info, error);
+  g_object_unref (stream);
+
+  outdated = (g_strcmp0 (cached_guid, self->media_guid) != 0);
+  g_free (cached_guid);
+
+  if (*error)
+    return GTUBER_FLOW_ERROR;
+
+  /* Streams data were requested for a different
+   * media ID than the current one, so ask again */
+  if (outdated) {
+    g_debug ("Cached stream media ID was outdated");
+    self->step = CRUNCHYROLL_GET_STREAMS_DATA;
+
+    return GTUBER_FLOW_RESTART;
+  }
+
+  stream = g_memory_input_stream_new_from_bytes (g_ptr_array_index (bodies, 1));
+  read_streaming_uris (self, stream, info, error);
+  g_object_unref (stream);
+
+  if (*error)
+    return GTUBER_FLOW_ERROR;
+
+  self->step = CRUNCHYROLL_GET_HLS_URI;
+
+  return GTUBER_FLOW_RESTART;
+}
+
+/* Token (or policy obtained with it) might have been
+ * revoked before it expired, so forget it and get new one */
+static void
+drop_cached_authorization (GtuberCrunchyroll *self)
+{
+  gchar *key;
+
+  g_clear_pointer (&self->token_type, g_free);
+  g_clear_pointer (&self->access_token, g_free);
+  g_clear_pointer (&self->policy_response, g_free);
+
+  key = _access_token_cache_key (self);
+  gtuber_crunchyroll_cache_write (key, NULL, 1);
+  g_free (key);
+
+  gtuber_crunchyroll_cache_write ("policy_response", NULL, 1);
+}
+
+static GtuberFlow
+gtuber_crunchyroll_read_response (GtuberWebsite *website,
+    SoupMessage *msg, GError **error)
+{
+  GtuberCrunchyroll *self = GTUBER_CRUNCHYROLL (website);
+  SoupStatus status;
+
+  status = soup_message_get_status (msg);
+
+  /* Authenticate again, but only once */
+  if (status == SOUP_STATUS_UNAUTHORIZED && !self->reauthenticated
+      && self->step > CRUNCHYROLL_GET_ACCESS_TOKEN) {
+    g_debug ("Authorization rejected, authenticating again");
+
+    drop_cached_authorization (self);
+    self->reauthenticated = TRUE;
+    self->step = (self->auth_token)
+        ? CRUNCHYROLL_GET_ACCESS_TOKEN
+        : CRUNCHYROLL_GET_AUTH_TOKEN;
+
+    return GTUBER_FLOW_RESTART;
+  }
+
+  return GTUBER_FLOW_OK;
+}
+
 static GtuberFlow
 gtuber_crunchyroll_parse_input_stream (GtuberWebsite *website,
     GInputStream *stream, GtuberMediaInfo *info, GError **error)
@@ -739,7 +944,10 @@ gtuber_crunchyroll_class_init (GtuberCrunchyrollClass *klass)
 
   website_class->prepare = gtuber_crunchyroll_prepare;
   website_class->create_request = gtuber_crunchyroll_create_request;
+  website_class->read_response = gtuber_crunchyroll_read_response;
   website_class->parse_input_stream = gtuber_crunchyroll_parse_input_stream;
+  website_class->create_requests = gtuber_crunchyroll_create_requests;
+  website_class->parse_responses = gtuber_crunchyroll_parse_responses;
 }
 
 GtuberWebsite *
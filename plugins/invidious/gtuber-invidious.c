@@ -42,6 +42,8 @@ struct _GtuberInvidious
   gchar *video_id;
   gchar *source;
   gchar *hls_uri;
+
+  GtuberUtilsCommonInstancePool *pool;
 };
 
 #define parent_class gtuber_invidious_parent_class
@@ -63,6 +65,9 @@ gtuber_invidious_finalize (GObject *object)
   g_free (self->source);
   g_free (self->hls_uri);
 
+  if (self->pool)
+    gtuber_utils_common_instance_pool_free (self->pool);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -235,6 +240,30 @@ parse_response_data (GtuberInvidious *self, JsonParser *parser,
   g_object_unref (reader);
 }
 
+/* All instances serve the same videos, so requested one
+ * is preferred, but others are used when it does not work */
+static void
+gtuber_invidious_prepare (GtuberWebsite *website)
+{
+  GtuberInvidious *self = GTUBER_INVIDIOUS (website);
+  const gchar *const *hosts;
+  GPtrArray *sources;
+  guint i;
+
+  sources = g_ptr_array_new_with_free_func (g_free);
+  g_ptr_array_add (sources, g_strdup (self->source));
+
+  hosts = plugin_get_hosts ();
+  for (i = 0; hosts && hosts[i]; i++)
+    g_ptr_array_add (sources, g_strdup_printf ("https://%s/", hosts[i]));
+  g_ptr_array_add (sources, NULL);
+
+  self->pool = gtuber_utils_common_instance_pool_new ("invidious",
+      (const gchar *const *) sources->pdata);
+
+  g_ptr_array_unref (sources);
+}
+
 static GtuberFlow
 gtuber_invidious_create_request (GtuberWebsite *website,
     GtuberMediaInfo *info, SoupMessage **msg, GError **error)
@@ -242,10 +271,23 @@ gtuber_invidious_create_request (GtuberWebsite *website,
   GtuberInvidious *self = GTUBER_INVIDIOUS (website);
 
   if (!self->hls_uri) {
+    const gchar *instance;
     gchar *api_uri, *msg_uri;
 
-    api_uri = g_uri_resolve_relative (
-        gtuber_website_get_uri_string (website),
+    if (!(instance = gtuber_utils_common_instance_pool_start_request (self->pool))) {
+      g_set_error (error, GTUBER_WEBSITE_ERROR,
+          GTUBER_WEBSITE_ERROR_REQUEST_CREATE_FAILED,
+          "All known instances failed");
+      return GTUBER_FLOW_ERROR;
+    }
+
+    /* Streams are resolved against instance that gave them */
+    if (strcmp (self->source, instance)) {
+      g_free (self->source);
+      self->source = g_strdup (instance);
+    }
+
+    api_uri = g_uri_resolve_relative (instance,
         "/api/v1/videos",
         G_URI_FLAGS_ENCODED,
         error);
@@ -265,6 +307,53 @@ gtuber_invidious_create_request (GtuberWebsite *website,
   return GTUBER_FLOW_OK;
 }
 
+static GtuberFlow
+gtuber_invidious_read_response (GtuberWebsite *website,
+    SoupMessage *msg, GError **error)
+{
+  GtuberInvidious *self = GTUBER_INVIDIOUS (website);
+  SoupStatus status;
+
+  /* Only API requests can be sent to other instance */
+  if (self->hls_uri)
+    return GTUBER_FLOW_OK;
+
+  status = soup_message_get_status (msg);
+
+  /* Server errors and "Too Many Requests" */
+  if (status >= 500 || status == 429) {
+    g_debug ("Instance %s responded with code: %i", self->source, status);
+
+    if (gtuber_utils_common_instance_pool_report_failure (self->pool))
+      return GTUBER_FLOW_RESTART;
+
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_OTHER,
+        "HTTP response code: %i", status);
+    return GTUBER_FLOW_ERROR;
+  }
+
+  gtuber_utils_common_instance_pool_report_success (self->pool);
+
+  return GTUBER_FLOW_OK;
+}
+
+static GtuberFlow
+gtuber_invidious_send_failed (GtuberWebsite *website,
+    SoupMessage *msg, GError **error)
+{
+  GtuberInvidious *self = GTUBER_INVIDIOUS (website);
+
+  if (self->hls_uri
+      || !gtuber_utils_common_instance_pool_report_failure (self->pool))
+    return GTUBER_FLOW_ERROR;
+
+  g_debug ("Trying next instance after error: %s", (*error)->message);
+  g_clear_error (error);
+
+  return GTUBER_FLOW_RESTART;
+}
+
 static GtuberFlow
 gtuber_invidious_parse_input_stream (GtuberWebsite *website,
     GInputStream *stream, GtuberMediaInfo *info, GError **error)
@@ -307,7 +396,10 @@ gtuber_invidious_class_init (GtuberInvidiousClass *klass)
 
   gobject_class->finalize = gtuber_invidious_finalize;
 
+  website_class->prepare = gtuber_invidious_prepare;
   website_class->create_request = gtuber_invidious_create_request;
+  website_class->read_response = gtuber_invidious_read_response;
+  website_class->send_failed = gtuber_invidious_send_failed;
   website_class->parse_input_stream = gtuber_invidious_parse_input_stream;
 }
 
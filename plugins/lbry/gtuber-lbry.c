@@ -30,6 +30,13 @@ typedef enum
   LBRY_STREAM_DIRECT,
 } LbryStreamType;
 
+/* JSON-RPC batch request IDs */
+enum
+{
+  LBRY_RPC_GET = 1,
+  LBRY_RPC_RESOLVE,
+};
+
 GTUBER_WEBSITE_PLUGIN_EXPORT_HOSTS (
   "odysee.com",
   NULL
@@ -50,7 +57,8 @@ struct _GtuberLbry
   gchar *streaming_url;
 
   LbryStreamType stream_type;
-  gboolean resolve;
+  GtuberStreamMimeType mime_type;
+  gboolean probed;
 };
 
 #define parent_class gtuber_lbry_parent_class
@@ -60,6 +68,7 @@ static void
 gtuber_lbry_init (GtuberLbry *self)
 {
   self->stream_type = LBRY_STREAM_UNKNOWN;
+  self->mime_type = GTUBER_STREAM_MIME_TYPE_UNKNOWN;
 }
 
 static void
@@ -75,7 +84,7 @@ gtuber_lbry_finalize (GObject *object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
-static GtuberFlow
+static gboolean
 acquire_streaming_url (GtuberLbry *self, JsonReader *reader, GError **error)
 {
   const gchar *url;
@@ -87,26 +96,20 @@ acquire_streaming_url (GtuberLbry *self, JsonReader *reader, GError **error)
     g_set_error (error, GTUBER_WEBSITE_ERROR,
         GTUBER_WEBSITE_ERROR_PARSE_FAILED,
         "Streaming URL is missing");
-    return GTUBER_FLOW_ERROR;
+    return FALSE;
   }
 
   self->streaming_url = g_strdup (url);
   g_debug ("Got stream URI: %s", self->streaming_url);
 
-  return GTUBER_FLOW_RESTART;
+  return TRUE;
 }
 
-static GtuberFlow
-parse_hls (GtuberLbry *self, GInputStream *stream,
-    GtuberMediaInfo *info, GError **error)
+static gboolean
+_is_hls_content_type (const gchar *content_type)
 {
-  g_debug ("Parsing LBRY HLS...");
-  self->resolve = gtuber_utils_common_parse_hls_input_stream (stream, info, error);
-  g_debug ("HLS parsed, success: %s", self->resolve ? "YES" : "NO");
-
-  return (self->resolve)
-      ? GTUBER_FLOW_RESTART
-      : GTUBER_FLOW_ERROR;
+  return (!g_ascii_strcasecmp (content_type, "application/x-mpegurl")
+      || !g_ascii_strcasecmp (content_type, "application/vnd.apple.mpegurl"));
 }
 
 static gboolean
@@ -119,7 +122,9 @@ fill_streams_info (GtuberLbry *self, GPtrArray *array, GtuberStreamMimeType mime
     GtuberStream *stream;
 
     stream = (GtuberStream *) g_ptr_array_index (array, i);
-    gtuber_stream_set_mime_type (stream, mime_type);
+
+    if (mime_type != GTUBER_STREAM_MIME_TYPE_UNKNOWN)
+      gtuber_stream_set_mime_type (stream, mime_type);
 
     if (!gtuber_stream_get_video_codec (stream)
         && !gtuber_stream_get_audio_codec (stream)) {
@@ -155,12 +160,36 @@ fill_streams_info (GtuberLbry *self, GPtrArray *array, GtuberStreamMimeType mime
   return success;
 }
 
+static GtuberFlow
+parse_hls (GtuberLbry *self, GInputStream *stream,
+    GtuberMediaInfo *info, GError **error)
+{
+  gboolean success;
+
+  g_debug ("Parsing LBRY HLS...");
+  success = gtuber_utils_common_parse_hls_input_stream (stream, info, error);
+  g_debug ("HLS parsed, success: %s", success ? "YES" : "NO");
+
+  if (!success)
+    return GTUBER_FLOW_ERROR;
+
+  if (!fill_streams_info (self, gtuber_media_info_get_streams (info), self->mime_type)
+      || !fill_streams_info (self, gtuber_media_info_get_adaptive_streams (info), self->mime_type)) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_PARSE_FAILED,
+        "Could not fill all streams info");
+    return GTUBER_FLOW_ERROR;
+  }
+
+  return GTUBER_FLOW_OK;
+}
+
 static GtuberFlow
 fill_media_info (GtuberLbry *self, JsonReader *reader,
     GtuberMediaInfo *info, GError **error)
 {
   const gchar *mime_str;
-  gboolean success = FALSE;
+  gboolean success = TRUE;
 
   g_debug ("Filling media info...");
 
@@ -177,11 +206,24 @@ fill_media_info (GtuberLbry *self, JsonReader *reader,
   gtuber_media_info_set_description (info,
       gtuber_utils_json_get_string (reader, "description", NULL));
 
+  /* HLS claim source can be trusted, but Odysee also serves transcoded
+   * HLS for many claims with other media type, these need to be probed */
+  if ((mime_str = gtuber_utils_json_get_string (reader,
+      "source", "media_type", NULL))) {
+    if (_is_hls_content_type (mime_str))
+      self->stream_type = LBRY_STREAM_HLS;
+
+    self->mime_type = gtuber_utils_common_get_mime_type_from_string (mime_str);
+  }
+
+  g_debug ("Claim source is HLS: %s",
+      self->stream_type == LBRY_STREAM_HLS ? "YES" : "NO");
+
   if (gtuber_utils_json_go_to (reader, "video", NULL)) {
     gtuber_media_info_set_duration (info,
         gtuber_utils_json_get_int (reader, "duration", NULL));
 
-    if (self->stream_type == LBRY_STREAM_DIRECT) {
+    if (self->stream_type != LBRY_STREAM_HLS) {
       GtuberStream *stream;
 
       stream = gtuber_stream_new ();
@@ -198,21 +240,12 @@ fill_media_info (GtuberLbry *self, JsonReader *reader,
     gtuber_utils_json_go_back (reader, 1);
   }
 
-  if ((mime_str = gtuber_utils_json_get_string (reader,
-      "source", "media_type", NULL))) {
-    GPtrArray *streams, *astreams;
-    GtuberStreamMimeType mime_type;
-
-    streams = gtuber_media_info_get_streams (info);
-    astreams = gtuber_media_info_get_adaptive_streams (info);
-    mime_type = gtuber_utils_common_get_mime_type_from_string (mime_str);
-
-    if (!(success = (fill_streams_info (self, streams, mime_type)
-        && fill_streams_info (self, astreams, mime_type)))) {
-      g_set_error (error, GTUBER_WEBSITE_ERROR,
-          GTUBER_WEBSITE_ERROR_PARSE_FAILED,
-          "Could not fill all streams info");
-    }
+  if (self->stream_type != LBRY_STREAM_HLS
+      && !(success = fill_streams_info (self,
+      gtuber_media_info_get_streams (info), self->mime_type))) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_PARSE_FAILED,
+        "Could not fill all streams info");
   }
 
   /* Return from "result.video_id.value" */
@@ -222,7 +255,9 @@ fill_media_info (GtuberLbry *self, JsonReader *reader,
     return GTUBER_FLOW_ERROR;
 
   g_debug ("Media info filled");
-  return GTUBER_FLOW_OK;
+
+  /* HLS manifest still needs to be downloaded or stream URI probed */
+  return GTUBER_FLOW_RESTART;
 }
 
 static void
@@ -242,15 +277,110 @@ lbry_update_streaming_url (GtuberLbry *self, SoupMessage *msg)
   }
 }
 
+static GtuberFlow
+finish_probe (GtuberLbry *self, GtuberMediaInfo *info)
+{
+  GPtrArray *streams = gtuber_media_info_get_streams (info);
+
+  /* Direct stream was assumed, drop it in favour of HLS ones */
+  if (self->stream_type == LBRY_STREAM_HLS) {
+    g_ptr_array_set_size (streams, 0);
+    return GTUBER_FLOW_RESTART;
+  }
+
+  /* Use URI from redirect */
+  if (streams->len > 0) {
+    gtuber_stream_set_uri (g_ptr_array_index (streams, 0),
+        self->streaming_url);
+  }
+
+  return GTUBER_FLOW_OK;
+}
+
+static JsonReader *
+_get_rpc_result_reader (JsonNode *root, gint64 rpc_id)
+{
+  JsonArray *results;
+  guint i, len;
+
+  if (!JSON_NODE_HOLDS_ARRAY (root))
+    return NULL;
+
+  results = json_node_get_array (root);
+  len = json_array_get_length (results);
+
+  /* Batch responses do not have to be in requests order */
+  for (i = 0; i < len; i++) {
+    JsonNode *node = json_array_get_element (results, i);
+    JsonObject *obj;
+
+    if (!JSON_NODE_HOLDS_OBJECT (node))
+      continue;
+
+    obj = json_node_get_object (node);
+    if (json_object_has_member (obj, "id")
+        && json_object_get_int_member (obj, "id") == rpc_id)
+      return json_reader_new (node);
+  }
+
+  return NULL;
+}
+
+static GtuberFlow
+parse_rpc_batch (GtuberLbry *self, JsonNode *root,
+    GtuberMediaInfo *info, GError **error)
+{
+  JsonReader *get_reader, *resolve_reader;
+  GtuberFlow flow = GTUBER_FLOW_ERROR;
+
+  get_reader = _get_rpc_result_reader (root, LBRY_RPC_GET);
+  resolve_reader = _get_rpc_result_reader (root, LBRY_RPC_RESOLVE);
+
+  if (!get_reader || !resolve_reader) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_PARSE_FAILED,
+        "Invalid website API response");
+    goto finish;
+  }
+
+  if (acquire_streaming_url (self, get_reader, error))
+    flow = fill_media_info (self, resolve_reader, info, error);
+
+finish:
+  g_clear_object (&get_reader);
+  g_clear_object (&resolve_reader);
+
+  return flow;
+}
+
+/* Claim ID comes from user URI, so it must be escaped */
+static gchar *
+obtain_rpc_body (gint rpc_id, const gchar *method,
+    const gchar *param_name, const gchar *param_value)
+{
+  gchar *body;
+
+  GTUBER_UTILS_JSON_BUILD_OBJECT (&body, {
+    GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("jsonrpc", "2.0");
+    GTUBER_UTILS_JSON_ADD_KEY_VAL_INT ("id", rpc_id);
+    GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("method", method);
+    GTUBER_UTILS_JSON_ADD_NAMED_OBJECT ("params", {
+      GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING (param_name, param_value);
+    });
+  });
+
+  return body;
+}
+
 static GtuberFlow
 gtuber_lbry_create_request (GtuberWebsite *website,
     GtuberMediaInfo *info, SoupMessage **msg, GError **error)
 {
   GtuberLbry *self = GTUBER_LBRY (website);
   SoupMessageHeaders *headers;
-  gchar *req_body;
+  gchar *req_body, *get_body, *resolve_body;
 
-  if (self->streaming_url && !self->resolve) {
+  if (self->streaming_url) {
     *msg = (self->stream_type == LBRY_STREAM_UNKNOWN)
         ? soup_message_new ("HEAD", self->streaming_url)
         : soup_message_new ("GET", self->streaming_url);
@@ -258,16 +388,14 @@ gtuber_lbry_create_request (GtuberWebsite *website,
     goto set_headers;
   }
 
-  req_body = g_strdup_printf (
-      "{"
-      "  \"method\": \"%s\","
-      "  \"params\": {"
-      "    \"%s\": \"%s\""
-      "  }"
-      "}",
-      self->resolve ? "resolve" : "get",
-      self->resolve ? "urls" : "uri",
-      self->video_id);
+  /* Get streaming URL and resolve claim within single request */
+  get_body = obtain_rpc_body (LBRY_RPC_GET, "get", "uri", self->video_id);
+  resolve_body = obtain_rpc_body (LBRY_RPC_RESOLVE, "resolve", "urls", self->video_id);
+
+  req_body = g_strdup_printf ("[%s,%s]", get_body, resolve_body);
+
+  g_free (get_body);
+  g_free (resolve_body);
 
   *msg = soup_message_new ("POST", "https://api.na-backend.odysee.com/api/v1/proxy");
   gtuber_utils_common_msg_take_request (*msg, "application/json-rpc", req_body);
@@ -302,21 +430,18 @@ gtuber_lbry_read_response (GtuberWebsite *website,
     const gchar *content_type;
 
     resp_headers = soup_message_get_response_headers (msg);
-
     content_type = soup_message_headers_get_content_type (resp_headers, NULL);
-    self->stream_type = (!strcmp (content_type, "application/x-mpegurl"))
+
+    self->stream_type = (content_type && _is_hls_content_type (content_type))
         ? LBRY_STREAM_HLS
         : LBRY_STREAM_DIRECT;
-    self->resolve = (self->stream_type == LBRY_STREAM_DIRECT);
+    self->probed = TRUE;
 
     g_debug ("URI leads to HLS: %s",
         self->stream_type == LBRY_STREAM_HLS ? "YES" : "NO");
 
     /* Update URI from redirect */
     lbry_update_streaming_url (self, msg);
-
-    /* Only HEAD here, nothing more to parse */
-    return GTUBER_FLOW_RESTART;
   }
 
   return GTUBER_FLOW_OK;
@@ -328,12 +453,16 @@ gtuber_lbry_parse_input_stream (GtuberWebsite *website,
 {
   GtuberLbry *self = GTUBER_LBRY (website);
   JsonParser *parser;
-  JsonReader *reader;
   GtuberFlow flow = GTUBER_FLOW_ERROR;
 
+  /* Last request was HEAD, nothing to parse */
+  if (self->probed) {
+    self->probed = FALSE;
+    return finish_probe (self, info);
+  }
+
   /* Last request was HLS manifest download */
-  if (self->streaming_url && !self->resolve
-      && self->stream_type == LBRY_STREAM_HLS)
+  if (self->streaming_url)
     return parse_hls (self, stream, info, error);
 
   parser = json_parser_new ();
@@ -342,13 +471,7 @@ gtuber_lbry_parse_input_stream (GtuberWebsite *website,
     goto finish;
 
   gtuber_utils_json_parser_debug (parser);
-  reader = json_reader_new (json_parser_get_root (parser));
-
-  flow = (!self->streaming_url)
-      ? acquire_streaming_url (self, reader, error)
-      : fill_media_info (self, reader, info, error);
-
-  g_object_unref (reader);
+  flow = parse_rpc_batch (self, json_parser_get_root (parser), info, error);
 
 finish:
   g_object_unref (parser);
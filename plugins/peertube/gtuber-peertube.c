@@ -39,6 +39,12 @@ struct _GtuberPeertube
 
   gchar *video_id;
   gchar *hls_uri;
+
+  GPtrArray *hls_streams;
+  gboolean hls_incomplete;
+
+  gdouble aspect_ratio;
+  guint n_audio_streams;
 };
 
 #define parent_class gtuber_peertube_parent_class
@@ -59,14 +65,114 @@ gtuber_peertube_finalize (GObject *object)
   g_free (self->video_id);
   g_free (self->hls_uri);
 
+  if (self->hls_streams)
+    g_ptr_array_unref (self->hls_streams);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+/* Peertube resolution ID is the shorter side of video */
+static void
+_set_stream_resolution (GtuberPeertube *self, JsonReader *reader,
+    GtuberStream *stream, gint64 id)
+{
+  gint64 width, height;
+
+  width = gtuber_utils_json_get_int (reader, "width", NULL);
+  height = gtuber_utils_json_get_int (reader, "height", NULL);
+
+  /* Older versions do not have exact file dimensions */
+  if (width <= 0 || height <= 0) {
+    width = height = id;
+
+    if (self->aspect_ratio >= 1.0)
+      width = (gint64) (id * self->aspect_ratio + 0.5);
+    else if (self->aspect_ratio > 0.0)
+      height = (gint64) (id / self->aspect_ratio + 0.5);
+    else
+      width = 0;
+  }
+
+  gtuber_stream_set_width (stream, width);
+  gtuber_stream_set_height (stream, height);
+}
+
+/* Audio only streams have resolution ID of zero */
+static guint
+_get_stream_itag (GtuberPeertube *self, gint64 id)
+{
+  return (id > 0) ? id : ++self->n_audio_streams;
+}
+
+static void
+_read_hls_file_cb (JsonReader *reader, GtuberMediaInfo *info, GtuberPeertube *self)
+{
+  GtuberAdaptiveStream *astream;
+  GtuberStream *stream;
+  const gchar *uri;
+  gint64 id, size;
+  guint duration;
+  gboolean has_video = TRUE, has_audio = TRUE;
+
+  /* Each resolution has its own media playlist */
+  if (!(uri = gtuber_utils_json_get_string (reader, "playlistUrl", NULL))) {
+    self->hls_incomplete = TRUE;
+    return;
+  }
+
+  astream = gtuber_adaptive_stream_new ();
+  stream = GTUBER_STREAM (astream);
+
+  gtuber_adaptive_stream_set_manifest_type (astream, GTUBER_ADAPTIVE_STREAM_MANIFEST_HLS);
+  gtuber_stream_set_uri (stream, uri);
+
+  id = gtuber_utils_json_get_int (reader, "resolution", "id", NULL);
+  gtuber_stream_set_itag (stream, _get_stream_itag (self, id));
+  gtuber_stream_set_fps (stream, gtuber_utils_json_get_int (reader, "fps", NULL));
+
+  size = gtuber_utils_json_get_int (reader, "size", NULL);
+  duration = gtuber_media_info_get_duration (info);
+  if (size > 0 && duration > 0)
+    gtuber_stream_set_bitrate (stream, (size * 8) / duration);
+
+  /* Newer versions may split audio into separate playlist */
+  if (gtuber_utils_json_go_to (reader, "hasVideo", NULL)) {
+    has_video = json_reader_get_boolean_value (reader);
+    gtuber_utils_json_go_back (reader, 1);
+  }
+  if (gtuber_utils_json_go_to (reader, "hasAudio", NULL)) {
+    has_audio = json_reader_get_boolean_value (reader);
+    gtuber_utils_json_go_back (reader, 1);
+  }
+  if (id == 0)
+    has_video = FALSE;
+
+  if (has_video)
+    _set_stream_resolution (self, reader, stream, id);
+
+  /* API does not provide codecs, Peertube transcodes into these */
+  gtuber_stream_set_codecs (stream,
+      has_video ? "avc1" : NULL,
+      has_audio ? "mp4a" : NULL);
+  gtuber_stream_set_mime_type (stream, has_video
+      ? GTUBER_STREAM_MIME_TYPE_VIDEO_MP4
+      : GTUBER_STREAM_MIME_TYPE_AUDIO_MP4);
+
+  g_ptr_array_add (self->hls_streams, astream);
+}
+
 static void
 _read_streaming_playlist_cb (JsonReader *reader, GtuberMediaInfo *info, GtuberPeertube *self)
 {
+  /* Master playlist is only needed when files info is incomplete */
   if (!self->hls_uri)
     self->hls_uri = g_strdup (gtuber_utils_json_get_string (reader, "playlistUrl", NULL));
+
+  if (gtuber_utils_json_go_to (reader, "files", NULL)) {
+    gtuber_utils_json_array_foreach (reader, info,
+        (GtuberFunc) _read_hls_file_cb, self);
+    gtuber_utils_json_go_back (reader, 1);
+  }
 }
 
 static void
@@ -84,10 +190,12 @@ _read_stream_cb (JsonReader *reader, GtuberMediaInfo *info, GtuberPeertube *self
   stream = gtuber_stream_new ();
   gtuber_stream_set_uri (stream, uri);
 
-  /* Peertube uses video height as stream itag */
+  /* Peertube uses video resolution as stream itag */
   id = gtuber_utils_json_get_int (reader, "resolution", "id", NULL);
-  gtuber_stream_set_itag (stream, id);
-  gtuber_stream_set_height (stream, id);
+  gtuber_stream_set_itag (stream, _get_stream_itag (self, id));
+
+  if (id > 0)
+    _set_stream_resolution (self, reader, stream, id);
 
   gtuber_stream_set_fps (stream, gtuber_utils_json_get_int (reader, "fps", NULL));
   gtuber_stream_set_bitrate (stream, gtuber_utils_json_get_int (reader, "bitrate", NULL));
@@ -98,9 +206,11 @@ _read_stream_cb (JsonReader *reader, GtuberMediaInfo *info, GtuberPeertube *self
   if (size > 0 && duration > 0)
     gtuber_stream_set_bitrate (stream, (size * 8) / duration);
 
-  /* XXX: Peertube does only "avc1" + "mp4a" AFAIK */
-  gtuber_stream_set_codecs (stream, "avc1", "mp4a");
-  gtuber_stream_set_mime_type (stream, GTUBER_STREAM_MIME_TYPE_VIDEO_MP4);
+  /* API does not provide codecs, Peertube transcodes into these */
+  gtuber_stream_set_codecs (stream, (id > 0) ? "avc1" : NULL, "mp4a");
+  gtuber_stream_set_mime_type (stream, (id > 0)
+      ? GTUBER_STREAM_MIME_TYPE_VIDEO_MP4
+      : GTUBER_STREAM_MIME_TYPE_AUDIO_MP4);
 
   gtuber_media_info_add_stream (info, stream);
 }
@@ -120,10 +230,34 @@ parse_response_data (GtuberPeertube *self, JsonParser *parser,
   gtuber_media_info_set_description (info, gtuber_utils_json_get_string (reader, "description", NULL));
   gtuber_media_info_set_duration (info, gtuber_utils_json_get_int (reader, "duration", NULL));
 
+  /* Available since Peertube 6.0 */
+  if (gtuber_utils_json_go_to (reader, "aspectRatio", NULL)) {
+    if (!json_reader_get_null_value (reader))
+      self->aspect_ratio = json_reader_get_double_value (reader);
+    gtuber_utils_json_go_back (reader, 1);
+  }
+
   if (gtuber_utils_json_go_to (reader, "streamingPlaylists", NULL)) {
+    self->hls_streams = g_ptr_array_new_with_free_func (g_object_unref);
+
     gtuber_utils_json_array_foreach (reader, info,
         (GtuberFunc) _read_streaming_playlist_cb, self);
     gtuber_utils_json_go_back (reader, 1);
+
+    if (self->hls_streams->len > 0 && !self->hls_incomplete) {
+      guint i;
+
+      g_debug ("Using HLS streams from API, skipping master playlist");
+
+      for (i = 0; i < self->hls_streams->len; i++) {
+        gtuber_media_info_add_adaptive_stream (info,
+            g_object_ref (g_ptr_array_index (self->hls_streams, i)));
+      }
+
+      g_clear_pointer (&self->hls_uri, g_free);
+    }
+
+    g_clear_pointer (&self->hls_streams, g_ptr_array_unref);
   }
   if (gtuber_utils_json_go_to (reader, "files", NULL)) {
     gtuber_utils_json_array_foreach (reader, info,
@@ -49,6 +49,8 @@ struct _GtuberPiped
   gchar *hls_uri;
   gchar *proxy;
   gchar *api;
+
+  GtuberUtilsCommonInstancePool *api_pool;
 };
 
 #define parent_class gtuber_piped_parent_class
@@ -71,6 +73,9 @@ gtuber_piped_finalize (GObject *object)
   g_free (self->proxy);
   g_free (self->api);
 
+  if (self->api_pool)
+    gtuber_utils_common_instance_pool_free (self->api_pool);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -238,33 +243,32 @@ parse_response_data (GtuberPiped *self, JsonParser *parser,
 
 /* Piped does not have a standardized API endpoint path. To support more hosts,
  * user must put both site host and api host in config files. Hosts are matched
- * together based on same domain. */
+ * together based on same domain. Since all API instances are interchangeable,
+ * others are kept as a fallback in case the matched one is slow or down. */
 static void
 gtuber_piped_prepare (GtuberWebsite *website)
 {
   GtuberPiped *self = GTUBER_PIPED (website);
+  GPtrArray *apis;
   gchar **piped_apis;
   const gchar *host;
 
   host = g_uri_get_host (gtuber_website_get_uri (website));
-
-  if (!strcmp (host, PIPED_DEFAULT_HOST)) {
-    self->api = g_strdup (PIPED_DEFAULT_API_HOST);
-    g_debug ("Using default API endpoint");
-
-    return;
-  }
+  apis = g_ptr_array_new ();
 
   piped_apis = gtuber_config_read_plugin_hosts_file ("piped_api_hosts");
 
-  if (piped_apis) {
+  if (!strcmp (host, PIPED_DEFAULT_HOST)) {
+    g_ptr_array_add (apis, PIPED_DEFAULT_API_HOST);
+    g_debug ("Using default API endpoint");
+  } else if (piped_apis) {
     gchar *host_domain = gtuber_utils_common_obtain_domain (host);
     guint i;
 
     for (i = 0; piped_apis[i]; i++) {
       if (g_str_has_suffix (piped_apis[i], host_domain)) {
-        self->api = g_strdup (piped_apis[i]);
-        g_debug ("Using API endpoint: %s", self->api);
+        g_ptr_array_add (apis, piped_apis[i]);
+        g_debug ("Using API endpoint: %s", piped_apis[i]);
         break;
       }
     }
@@ -272,6 +276,20 @@ gtuber_piped_prepare (GtuberWebsite *website)
     g_free (host_domain);
   }
 
+  /* Other instances are only a fallback for the matched one */
+  if (apis->len > 0) {
+    guint i;
+
+    g_ptr_array_add (apis, PIPED_DEFAULT_API_HOST);
+    for (i = 0; piped_apis && piped_apis[i]; i++)
+      g_ptr_array_add (apis, piped_apis[i]);
+    g_ptr_array_add (apis, NULL);
+
+    self->api_pool = gtuber_utils_common_instance_pool_new ("piped",
+        (const gchar *const *) apis->pdata);
+  }
+
+  g_ptr_array_unref (apis);
   g_strfreev (piped_apis);
 }
 
@@ -284,7 +302,7 @@ gtuber_piped_create_request (GtuberWebsite *website,
   if (!self->hls_uri) {
     gchar *uri;
 
-    if (G_UNLIKELY (!self->api)) {
+    if (G_UNLIKELY (!self->api_pool)) {
       const gchar *host = g_uri_get_host (gtuber_website_get_uri (website));
 
       g_set_error (error, GTUBER_WEBSITE_ERROR,
@@ -293,6 +311,16 @@ gtuber_piped_create_request (GtuberWebsite *website,
       return GTUBER_FLOW_ERROR;
     }
 
+    g_free (self->api);
+    self->api = g_strdup (gtuber_utils_common_instance_pool_start_request (self->api_pool));
+
+    if (G_UNLIKELY (!self->api)) {
+      g_set_error (error, GTUBER_WEBSITE_ERROR,
+          GTUBER_WEBSITE_ERROR_REQUEST_CREATE_FAILED,
+          "All known API endpoints failed");
+      return GTUBER_FLOW_ERROR;
+    }
+
     uri = g_strdup_printf ("https://%s/streams/%s",
         self->api, self->video_id);
     *msg = soup_message_new ("GET", uri);
@@ -305,6 +333,53 @@ gtuber_piped_create_request (GtuberWebsite *website,
   return GTUBER_FLOW_OK;
 }
 
+static GtuberFlow
+gtuber_piped_read_response (GtuberWebsite *website,
+    SoupMessage *msg, GError **error)
+{
+  GtuberPiped *self = GTUBER_PIPED (website);
+  SoupStatus status;
+
+  /* Only API requests can be sent to other instance */
+  if (self->hls_uri)
+    return GTUBER_FLOW_OK;
+
+  status = soup_message_get_status (msg);
+
+  /* Server errors and "Too Many Requests" */
+  if (status >= 500 || status == 429) {
+    g_debug ("API endpoint %s responded with code: %i", self->api, status);
+
+    if (gtuber_utils_common_instance_pool_report_failure (self->api_pool))
+      return GTUBER_FLOW_RESTART;
+
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_OTHER,
+        "HTTP response code: %i", status);
+    return GTUBER_FLOW_ERROR;
+  }
+
+  gtuber_utils_common_instance_pool_report_success (self->api_pool);
+
+  return GTUBER_FLOW_OK;
+}
+
+static GtuberFlow
+gtuber_piped_send_failed (GtuberWebsite *website,
+    SoupMessage *msg, GError **error)
+{
+  GtuberPiped *self = GTUBER_PIPED (website);
+
+  if (self->hls_uri
+      || !gtuber_utils_common_instance_pool_report_failure (self->api_pool))
+    return GTUBER_FLOW_ERROR;
+
+  g_debug ("Trying next API endpoint after error: %s", (*error)->message);
+  g_clear_error (error);
+
+  return GTUBER_FLOW_RESTART;
+}
+
 static GtuberFlow
 gtuber_piped_parse_input_stream (GtuberWebsite *website,
     GInputStream *stream, GtuberMediaInfo *info, GError **error)
@@ -349,6 +424,8 @@ gtuber_piped_class_init (GtuberPipedClass *klass)
 
   website_class->prepare = gtuber_piped_prepare;
   website_class->create_request = gtuber_piped_create_request;
+  website_class->read_response = gtuber_piped_read_response;
+  website_class->send_failed = gtuber_piped_send_failed;
   website_class->parse_input_stream = gtuber_piped_parse_input_stream;
 }
 
@@ -119,8 +119,7 @@ parse_response_data (GtuberReddit *self, JsonParser *parser,
 
   gtuber_media_info_set_duration (info, gtuber_utils_json_get_int (reader, "duration", NULL));
 
-  /* FIXME: Support parsing DASH files */
-  //self->dash_uri = g_strdup (gtuber_utils_json_get_string (reader, "dash_url", NULL));
+  self->dash_uri = g_strdup (gtuber_utils_json_get_string (reader, "dash_url", NULL));
   self->hls_uri = g_strdup (gtuber_utils_json_get_string (reader, "hls_url", NULL));
 
   if (!self->dash_uri && !self->hls_uri) {
@@ -271,7 +270,35 @@ gtuber_reddit_parse_input_stream (GtuberWebsite *website,
   GtuberFlow flow = GTUBER_FLOW_OK;
 
   if (self->dash_uri) {
-    /* FIXME: Support parsing DASH files */
+    GPtrArray *streams, *astreams;
+    guint n_streams, n_astreams;
+    GError *dash_error = NULL;
+
+    streams = gtuber_media_info_get_streams (info);
+    astreams = gtuber_media_info_get_adaptive_streams (info);
+
+    n_streams = streams->len;
+    n_astreams = astreams->len;
+
+    /* DASH manifest has all streams with exact bitrates,
+     * so HLS is only needed as a fallback */
+    if (gtuber_utils_common_parse_dash_input_stream_with_base_uri (stream,
+        info, self->dash_uri, &dash_error)) {
+      g_clear_pointer (&self->hls_uri, g_free);
+    } else {
+      g_debug ("Could not parse DASH: %s", dash_error->message);
+      g_clear_error (&dash_error);
+
+      /* Do not mix partially parsed DASH streams with HLS ones */
+      g_ptr_array_set_size (streams, n_streams);
+      g_ptr_array_set_size (astreams, n_astreams);
+
+      if (!self->hls_uri) {
+        g_set_error (error, GTUBER_WEBSITE_ERROR,
+            GTUBER_WEBSITE_ERROR_PARSE_FAILED,
+            "Could not extract streams from DASH manifest");
+      }
+    }
 
     g_free (self->dash_uri);
     self->dash_uri = NULL;
@@ -25,7 +25,6 @@
 
 typedef enum
 {
-  GQL_REQ_NONE,
   GQL_REQ_ACCESS_TOKEN,
   GQL_REQ_ACCESS_TOKEN_CLIP,
   GQL_REQ_METADATA_CHANNEL,
@@ -58,9 +57,8 @@ struct _GtuberTwitch
   gchar *signature;
 
   TwitchMediaType media_type;
-  GqlReqType last_req;
 
-  gboolean download_hls;
+  GtuberUtilsCommonHlsParser *hls_parser;
 };
 
 #define parent_class gtuber_twitch_parent_class
@@ -70,7 +68,6 @@ static void
 gtuber_twitch_init (GtuberTwitch *self)
 {
   self->media_type = TWITCH_MEDIA_NONE;
-  self->last_req = GQL_REQ_NONE;
 }
 
 static void
@@ -85,6 +82,9 @@ gtuber_twitch_finalize (GObject *object)
   g_free (self->access_token);
   g_free (self->signature);
 
+  if (self->hls_parser)
+    gtuber_utils_common_hls_parser_free (self->hls_parser);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -163,10 +163,10 @@ _read_clip_streams (GtuberTwitch *self, JsonReader *reader,
 }
 
 static void
-_parse_access_token_data (GtuberTwitch *self, JsonParser *parser,
+_parse_access_token_data (GtuberTwitch *self, JsonNode *node,
     GtuberMediaInfo *info, GError **error)
 {
-  JsonReader *reader = json_reader_new (json_parser_get_root (parser));
+  JsonReader *reader = json_reader_new (node);
   const gchar *data_type = NULL;
 
   switch (self->media_type) {
@@ -272,10 +272,10 @@ _read_clip_metadata (JsonReader *reader, GtuberMediaInfo *info, GError **error)
 }
 
 static void
-_parse_metadata (GtuberTwitch *self, JsonParser *parser,
+_parse_metadata (GtuberTwitch *self, JsonNode *node,
     GtuberMediaInfo *info, GError **error)
 {
-  JsonReader *reader = json_reader_new (json_parser_get_root (parser));
+  JsonReader *reader = json_reader_new (node);
 
   if (gtuber_utils_json_go_to (reader, "errors", NULL)) {
     const gchar *err_msg = NULL;
@@ -316,6 +316,8 @@ parse_json_stream (GtuberTwitch *self, GInputStream *stream,
     GtuberMediaInfo *info, GError **error)
 {
   JsonParser *parser;
+  JsonNode *root;
+  JsonArray *results;
 
   parser = json_parser_new ();
   json_parser_load_from_stream (parser, stream, NULL, error);
@@ -324,20 +326,22 @@ parse_json_stream (GtuberTwitch *self, GInputStream *stream,
 
   gtuber_utils_json_parser_debug (parser);
 
-  switch (self->last_req) {
-    case GQL_REQ_ACCESS_TOKEN:
-    case GQL_REQ_ACCESS_TOKEN_CLIP:
-      _parse_access_token_data (self, parser, info, error);
-      break;
-    case GQL_REQ_METADATA_CHANNEL:
-    case GQL_REQ_METADATA_VIDEO:
-    case GQL_REQ_METADATA_CLIP:
-      _parse_metadata (self, parser, info, error);
-      break;
-    default:
-      g_assert_not_reached ();
+  /* Batched GQL responses come in the same order as operations */
+  root = json_parser_get_root (parser);
+  if (!JSON_NODE_HOLDS_ARRAY (root)
+      || json_array_get_length ((results = json_node_get_array (root))) < 2) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_PARSE_FAILED,
+        "Invalid GQL batch response");
+    goto finish;
   }
 
+  _parse_access_token_data (self, json_array_get_element (results, 0), info, error);
+  if (*error)
+    goto finish;
+
+  _parse_metadata (self, json_array_get_element (results, 1), info, error);
+
 finish:
   g_object_unref (parser);
 
@@ -345,7 +349,7 @@ finish:
     return GTUBER_FLOW_ERROR;
 
   /* Clips do not have HLS manifests, so we are done here */
-  if (self->last_req == GQL_REQ_METADATA_CLIP)
+  if (self->media_type == TWITCH_MEDIA_CLIP)
     return GTUBER_FLOW_OK;
 
   return GTUBER_FLOW_RESTART;
@@ -368,81 +372,111 @@ make_soup_msg (const char *method, const char *uri_string,
     gtuber_utils_common_msg_take_request (*msg, "application/json", req_body);
 }
 
-static GtuberFlow
-create_gql_msg (GtuberTwitch *self, GqlReqType req_type,
-    SoupMessage **msg, GError **error)
+static gchar *
+_build_gql_operation (GtuberTwitch *self, GqlReqType req_type)
 {
   const gchar *op_name, *sha256;
-  gchar *req_body, *variables;
+  gchar *operation;
 
   switch (req_type) {
     case GQL_REQ_ACCESS_TOKEN:
       op_name = "PlaybackAccessToken";
       sha256 = "0828119ded1c13477966434e15800ff57ddacf13ba1911c129dc2200705b0712";
-      variables = g_strdup_printf (
-      "    \"isLive\": %s,\n"
-      "    \"login\": \"%s\",\n"
-      "    \"isVod\": %s,\n"
-      "    \"vodID\": \"%s\",\n"
-      "    \"playerType\": \"embed\"\n",
-          self->media_type == TWITCH_MEDIA_CHANNEL ? "true" : "false",
-          self->media_type == TWITCH_MEDIA_CHANNEL ? self->video_id : "",
-          self->media_type == TWITCH_MEDIA_VIDEO ? "true" : "false",
-          self->media_type == TWITCH_MEDIA_VIDEO ? self->video_id : "");
       break;
     case GQL_REQ_ACCESS_TOKEN_CLIP:
       op_name = "VideoAccessToken_Clip";
       sha256 = "36b89d2507fce29e5ca551df756d27c1cfe079e2609642b4390aa4c35796eb11";
-      variables = g_strdup_printf (
-      "    \"slug\": \"%s\"\n",
-          self->video_id);
       break;
     case GQL_REQ_METADATA_CHANNEL:
       op_name = "StreamMetadata";
       sha256 = "059c4653b788f5bdb2f5a2d2a24b0ddc3831a15079001a3d927556a96fb0517f";
-      variables = g_strdup_printf (
-      "    \"channelLogin\": \"%s\"\n",
-          self->video_id);
       break;
     case GQL_REQ_METADATA_VIDEO:
       op_name = "VideoMetadata";
       sha256 = "cb3b1eb2f2d2b2f65b8389ba446ec521d76c3aa44f5424a1b1d235fe21eb4806";
-      variables = g_strdup_printf (
-      "    \"channelLogin\": \"\",\n"
-      "    \"videoID\": \"%s\"\n",
-          self->video_id);
       break;
     case GQL_REQ_METADATA_CLIP:
       op_name = "ClipsTitle";
       sha256 = "f6cca7f2fdfbfc2cecea0c88452500dae569191e58a265f97711f8f2a838f5b4";
-      variables = g_strdup_printf (
-      "    \"slug\": \"%s\"\n",
-          self->video_id);
+      break;
+    default:
+      return NULL;
+  }
+
+  GTUBER_UTILS_JSON_BUILD_OBJECT (&operation, {
+    GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("operationName", op_name);
+    GTUBER_UTILS_JSON_ADD_NAMED_OBJECT ("extensions", {
+      GTUBER_UTILS_JSON_ADD_NAMED_OBJECT ("persistedQuery", {
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_INT ("version", 1);
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("sha256Hash", sha256);
+      });
+    });
+    GTUBER_UTILS_JSON_ADD_NAMED_OBJECT ("variables", {
+      if (req_type == GQL_REQ_ACCESS_TOKEN) {
+        gboolean is_live = (self->media_type == TWITCH_MEDIA_CHANNEL);
+        gboolean is_vod = (self->media_type == TWITCH_MEDIA_VIDEO);
+
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_BOOLEAN ("isLive", is_live);
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("login", is_live ? self->video_id : "");
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_BOOLEAN ("isVod", is_vod);
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("vodID", is_vod ? self->video_id : "");
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("playerType", "embed");
+      } else if (req_type == GQL_REQ_METADATA_CHANNEL) {
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("channelLogin", self->video_id);
+      } else if (req_type == GQL_REQ_METADATA_VIDEO) {
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("channelLogin", "");
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("videoID", self->video_id);
+      } else {
+        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("slug", self->video_id);
+      }
+    });
+  });
+
+  return operation;
+}
+
+static GtuberFlow
+create_gql_batch_msg (GtuberTwitch *self, SoupMessage **msg, GError **error)
+{
+  GqlReqType token_req, metadata_req;
+  gchar *token_op, *metadata_op, *req_body;
+
+  switch (self->media_type) {
+    case TWITCH_MEDIA_CHANNEL:
+      token_req = GQL_REQ_ACCESS_TOKEN;
+      metadata_req = GQL_REQ_METADATA_CHANNEL;
+      break;
+    case TWITCH_MEDIA_VIDEO:
+      token_req = GQL_REQ_ACCESS_TOKEN;
+      metadata_req = GQL_REQ_METADATA_VIDEO;
+      break;
+    case TWITCH_MEDIA_CLIP:
+      token_req = GQL_REQ_ACCESS_TOKEN_CLIP;
+      metadata_req = GQL_REQ_METADATA_CLIP;
       break;
     default:
       goto fail;
   }
 
-  req_body = g_strdup_printf ("{\n"
-  "  \"operationName\": \"%s\",\n"
-  "  \"extensions\": {\n"
-  "    \"persistedQuery\": {\n"
-  "      \"version\": 1,\n"
-  "      \"sha256Hash\": \"%s\"\n"
-  "    }\n"
-  "  },\n"
-  "  \"variables\": {\n%s"
-  "  }\n"
-  "}",
-      op_name, sha256, variables);
-
-  g_free (variables);
+  token_op = _build_gql_operation (self, token_req);
+  metadata_op = _build_gql_operation (self, metadata_req);
+
+  if (!token_op || !metadata_op) {
+    g_free (token_op);
+    g_free (metadata_op);
+    goto fail;
+  }
+
+  /* GQL accepts an array of operations, so we can get both
+   * access token and metadata within a single request */
+  req_body = g_strdup_printf ("[%s,%s]", token_op, metadata_op);
+
+  g_free (token_op);
+  g_free (metadata_op);
 
   g_debug ("Request body: %s", req_body);
   make_soup_msg ("POST", "https://gql.twitch.tv/gql", req_body, msg);
 
-  self->last_req = req_type;
-
   return GTUBER_FLOW_OK;
 
 fail:
@@ -491,7 +525,8 @@ create_hls_msg (GtuberTwitch *self, SoupMessage **msg, GError **error)
   make_soup_msg ("GET", uri_str, NULL, msg);
   g_free (uri_str);
 
-  self->download_hls = TRUE;
+  /* Build streams while manifest is downloading */
+  gtuber_website_set_chunked_parse (GTUBER_WEBSITE (self), TRUE);
 
   return GTUBER_FLOW_OK;
 }
@@ -502,25 +537,13 @@ gtuber_twitch_create_request (GtuberWebsite *website,
 {
   GtuberTwitch *self = GTUBER_TWITCH (website);
 
-  if (!self->access_token || !self->signature) {
-    GqlReqType req_type = (self->media_type == TWITCH_MEDIA_CLIP)
-      ? GQL_REQ_ACCESS_TOKEN_CLIP
-      : GQL_REQ_ACCESS_TOKEN;
+  /* Leftover from HLS body read that failed partway */
+  g_clear_pointer (&self->hls_parser, gtuber_utils_common_hls_parser_free);
 
-    return create_gql_msg (self, req_type, msg, error);
-  }
+  if (!self->access_token || !self->signature)
+    return create_gql_batch_msg (self, msg, error);
 
-  switch (self->last_req) {
-    case GQL_REQ_NONE:
-    case GQL_REQ_ACCESS_TOKEN:
-      return (self->media_type == TWITCH_MEDIA_CHANNEL)
-        ? create_gql_msg (self, GQL_REQ_METADATA_CHANNEL, msg, error)
-        : create_gql_msg (self, GQL_REQ_METADATA_VIDEO, msg, error);
-    case GQL_REQ_ACCESS_TOKEN_CLIP:
-      return create_gql_msg (self, GQL_REQ_METADATA_CLIP, msg, error);
-    default:
-      return create_hls_msg (self, msg, error);
-  }
+  return create_hls_msg (self, msg, error);
 }
 
 static GtuberFlow
@@ -529,14 +552,29 @@ gtuber_twitch_parse_input_stream (GtuberWebsite *website,
 {
   GtuberTwitch *self = GTUBER_TWITCH (website);
 
-  if (self->download_hls) {
-    if (gtuber_utils_common_parse_hls_input_stream (stream, info, error))
-      return GTUBER_FLOW_OK;
+  return parse_json_stream (self, stream, info, error);
+}
 
-    return GTUBER_FLOW_ERROR;
+static GtuberFlow
+gtuber_twitch_parse_data_chunk (GtuberWebsite *website,
+    const gchar *chunk, gsize size, GtuberMediaInfo *info,
+    gboolean *finished, GError **error)
+{
+  GtuberTwitch *self = GTUBER_TWITCH (website);
+  gboolean success;
+
+  if (!self->hls_parser)
+    self->hls_parser = gtuber_utils_common_hls_parser_new (info, NULL);
+
+  if (size > 0) {
+    gtuber_utils_common_hls_parser_push_data (self->hls_parser, chunk, size);
+    return GTUBER_FLOW_OK;
   }
 
-  return parse_json_stream (self, stream, info, error);
+  success = gtuber_utils_common_hls_parser_finish (self->hls_parser, error);
+  g_clear_pointer (&self->hls_parser, gtuber_utils_common_hls_parser_free);
+
+  return (success) ? GTUBER_FLOW_OK : GTUBER_FLOW_ERROR;
 }
 
 static GtuberFlow
@@ -560,6 +598,7 @@ gtuber_twitch_class_init (GtuberTwitchClass *klass)
 
   website_class->create_request = gtuber_twitch_create_request;
   website_class->parse_input_stream = gtuber_twitch_parse_input_stream;
+  website_class->parse_data_chunk = gtuber_twitch_parse_data_chunk;
   website_class->set_user_req_headers = gtuber_twitch_set_user_req_headers;
 }
 
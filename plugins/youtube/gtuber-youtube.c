@@ -26,10 +26,15 @@
 #include "utils/youtube/gtuber-utils-youtube.h"
 
 #define GTUBER_YOUTUBE_CLI_VERSION "18.15.37"
+#define GTUBER_YOUTUBE_WEB_CLI_VERSION "2.20230728.00.00"
 #define GTUBER_YOUTUBE_ANDROID_MAJOR 11
 #define GTUBER_YOUTUBE_ANDROID_SDK_MAJOR 30
 #define GTUBER_YOUTUBE_X_ORIGIN "https://www.youtube.com"
 
+/* Set to request all client profiles at once instead of one by one,
+ * see "Plugin Options" in README */
+#define GTUBER_YOUTUBE_RACE_CLIENTS_ENV "GTUBER_YOUTUBE_RACE_CLIENTS"
+
 GTUBER_WEBSITE_PLUGIN_EXPORT_HOSTS (
   "youtube.com",
   "youtu.be",
@@ -50,19 +55,31 @@ struct _GtuberYoutube
   GtuberWebsite parent;
 
   gchar *video_id;
+  gchar *playlist_id;
   gchar *hls_uri;
 
   gchar *visitor_data;
   gchar *locale;
   gchar *ua;
 
+  GtuberUtilsXmlJsonScanner *page_scanner;
+
   YoutubeStep step;
   guint try_count;
+
+  gboolean race_clients;
 };
 
 #define parent_class gtuber_youtube_parent_class
 GTUBER_WEBSITE_PLUGIN_DEFINE (Youtube, youtube)
 
+/* Player API client screens, in order of preference.
+ * EMBED works for most videos, default one for the rest. */
+static const gchar *const client_screens[] = {
+  "EMBED",
+  NULL,
+};
+
 static void
 gtuber_youtube_init (GtuberYoutube *self)
 {
@@ -77,44 +94,102 @@ gtuber_youtube_finalize (GObject *object)
   g_debug ("Youtube finalize");
 
   g_free (self->video_id);
+  g_free (self->playlist_id);
   g_free (self->hls_uri);
 
   g_free (self->visitor_data);
   g_free (self->locale);
   g_free (self->ua);
 
+  if (self->page_scanner)
+    gtuber_utils_xml_json_scanner_free (self->page_scanner);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+typedef struct
+{
+  const gchar *url;
+  const gchar *mime_type;
+  const gchar *type;
+  gint64 itag;
+  gint64 bitrate;
+  gint64 width;
+  gint64 height;
+  gint64 fps;
+  JsonObject *init_range;
+  JsonObject *index_range;
+} YoutubeFormat;
+
+typedef struct
+{
+  gint64 start;
+  gint64 end;
+} YoutubeRange;
+
+static const GtuberUtilsJsonField format_fields[] = {
+  GTUBER_UTILS_JSON_FIELD ("url", STRING, YoutubeFormat, url),
+  GTUBER_UTILS_JSON_FIELD ("mimeType", STRING, YoutubeFormat, mime_type),
+  GTUBER_UTILS_JSON_FIELD ("type", STRING, YoutubeFormat, type),
+  GTUBER_UTILS_JSON_FIELD ("itag", INT, YoutubeFormat, itag),
+  GTUBER_UTILS_JSON_FIELD ("bitrate", INT, YoutubeFormat, bitrate),
+  GTUBER_UTILS_JSON_FIELD ("width", INT, YoutubeFormat, width),
+  GTUBER_UTILS_JSON_FIELD ("height", INT, YoutubeFormat, height),
+  GTUBER_UTILS_JSON_FIELD ("fps", INT, YoutubeFormat, fps),
+  GTUBER_UTILS_JSON_FIELD ("initRange", OBJECT, YoutubeFormat, init_range),
+  GTUBER_UTILS_JSON_FIELD ("indexRange", OBJECT, YoutubeFormat, index_range),
+};
+
+static const GtuberUtilsJsonField range_fields[] = {
+  GTUBER_UTILS_JSON_FIELD ("start", INT, YoutubeRange, start),
+  GTUBER_UTILS_JSON_FIELD ("end", INT, YoutubeRange, end),
+};
+
+static gboolean
+_read_format (JsonNode *node, YoutubeFormat *format)
+{
+  if (!JSON_NODE_HOLDS_OBJECT (node))
+    return FALSE;
+
+  gtuber_utils_json_project (json_node_get_object (node),
+      format_fields, G_N_ELEMENTS (format_fields), format);
+
+  return TRUE;
+}
+
+static gboolean
+_read_range (JsonObject *object, YoutubeRange *range)
+{
+  return (object && gtuber_utils_json_project (object, range_fields,
+      G_N_ELEMENTS (range_fields), range) == G_N_ELEMENTS (range_fields));
+}
+
 static void
-_read_stream_info (JsonReader *reader, GtuberStream *stream)
+_read_stream_info (YoutubeFormat *format, GtuberStream *stream)
 {
-  const gchar *uri_str, *yt_mime;
   gchar *mod_uri;
 
-  uri_str = gtuber_utils_json_get_string (reader, "url", NULL);
-
   /* No point continuing without URI */
-  if (!uri_str)
+  if (!format->url)
     return;
 
-  mod_uri = gtuber_utils_common_obtain_uri_with_query_as_path (uri_str);
+  mod_uri = gtuber_utils_common_obtain_uri_with_query_as_path (format->url);
   gtuber_stream_set_uri (stream, mod_uri);
   g_free (mod_uri);
 
-  gtuber_stream_set_itag (stream, gtuber_utils_json_get_int (reader, "itag", NULL));
-  gtuber_stream_set_bitrate (stream, gtuber_utils_json_get_int (reader, "bitrate", NULL));
-  gtuber_stream_set_width (stream, gtuber_utils_json_get_int (reader, "width", NULL));
-  gtuber_stream_set_height (stream, gtuber_utils_json_get_int (reader, "height", NULL));
-  gtuber_stream_set_fps (stream, gtuber_utils_json_get_int (reader, "fps", NULL));
+  gtuber_stream_set_itag (stream, format->itag);
+  gtuber_stream_set_bitrate (stream, format->bitrate);
+  gtuber_stream_set_width (stream, format->width);
+  gtuber_stream_set_height (stream, format->height);
+  gtuber_stream_set_fps (stream, format->fps);
 
   /* Parse mime type and codecs */
-  if ((yt_mime = gtuber_utils_json_get_string (reader, "mimeType", NULL))) {
+  if (format->mime_type) {
     GtuberStreamMimeType mime_type = GTUBER_STREAM_MIME_TYPE_UNKNOWN;
     gchar *vcodec = NULL;
     gchar *acodec = NULL;
 
-    gtuber_utils_youtube_parse_mime_type_string (yt_mime, &mime_type, &vcodec, &acodec);
+    gtuber_utils_youtube_parse_mime_type_string (format->mime_type, &mime_type, &vcodec, &acodec);
     gtuber_stream_set_mime_type (stream, mime_type);
     gtuber_stream_set_codecs (stream, vcodec, acodec);
 
@@ -124,14 +199,15 @@ _read_stream_info (JsonReader *reader, GtuberStream *stream)
 }
 
 static void
-_read_stream_cb (JsonReader *reader, GtuberMediaInfo *info, gpointer user_data)
+_read_stream_cb (JsonArray *array, guint index, JsonNode *node, GtuberMediaInfo *info)
 {
+  YoutubeFormat format = { NULL, };
   GtuberStream *stream;
-  guint itag;
 
-  itag = gtuber_utils_json_get_int (reader, "itag", NULL);
+  if (!_read_format (node, &format))
+    return;
 
-  switch (itag) {
+  switch (format.itag) {
     case 0:  // unknown
     case 17: // deprecated 3GP
       return;
@@ -140,135 +216,196 @@ _read_stream_cb (JsonReader *reader, GtuberMediaInfo *info, gpointer user_data)
   }
 
   stream = gtuber_stream_new ();
-  _read_stream_info (reader, stream);
+  _read_stream_info (&format, stream);
 
   gtuber_media_info_add_stream (info, stream);
 }
 
 static void
-_read_adaptive_stream_cb (JsonReader *reader, GtuberMediaInfo *info, gpointer user_data)
+_read_adaptive_stream_cb (JsonArray *array, guint index, JsonNode *node, GtuberMediaInfo *info)
 {
+  YoutubeFormat format = { NULL, };
+  YoutubeRange range;
   GtuberAdaptiveStream *astream;
-  const gchar *stream_type;
 
-  stream_type = gtuber_utils_json_get_string (reader, "type", NULL);
+  if (!_read_format (node, &format))
+    return;
 
-  if (!g_strcmp0 (stream_type, "FORMAT_STREAM_TYPE_OTF")) {
+  if (!g_strcmp0 (format.type, "FORMAT_STREAM_TYPE_OTF")) {
     /* FIXME: OTF requires fetching init at "/sq/0" first
      * then remaining fragments by number instead of range */
     return;
   }
 
   astream = gtuber_adaptive_stream_new ();
-  _read_stream_info (reader, GTUBER_STREAM (astream));
+  _read_stream_info (&format, GTUBER_STREAM (astream));
 
-  if (gtuber_utils_json_go_to (reader, "initRange", NULL)) {
-    const gchar *start, *end;
+  if (_read_range (format.init_range, &range))
+    gtuber_adaptive_stream_set_init_range (astream, range.start, range.end);
+  if (_read_range (format.index_range, &range))
+    gtuber_adaptive_stream_set_index_range (astream, range.start, range.end);
 
-    start = gtuber_utils_json_get_string (reader, "start", NULL);
-    end = gtuber_utils_json_get_string (reader, "end", NULL);
+  gtuber_adaptive_stream_set_manifest_type (astream, GTUBER_ADAPTIVE_STREAM_MANIFEST_DASH);
+  gtuber_media_info_add_adaptive_stream (info, astream);
+}
 
-    if (start && end) {
-      gtuber_adaptive_stream_set_init_range (astream,
-          g_ascii_strtoull (start, NULL, 10),
-          g_ascii_strtoull (end, NULL, 10));
-    }
+typedef struct
+{
+  JsonObject *playability_status;
+  JsonObject *video_details;
+  JsonObject *streaming_data;
+  JsonObject *response_context;
+} YoutubePlayerResponse;
 
-    gtuber_utils_json_go_back (reader, 1);
-  }
-  if (gtuber_utils_json_go_to (reader, "indexRange", NULL)) {
-    const gchar *start, *end;
+typedef struct
+{
+  const gchar *status;
+  const gchar *reason;
+} YoutubePlayability;
 
-    start = gtuber_utils_json_get_string (reader, "start", NULL);
-    end = gtuber_utils_json_get_string (reader, "end", NULL);
+typedef struct
+{
+  const gchar *id;
+  const gchar *title;
+  const gchar *desc;
+  gint64 duration;
+} YoutubeVideoDetails;
 
-    if (start && end) {
-      gtuber_adaptive_stream_set_index_range (astream,
-          g_ascii_strtoull (start, NULL, 10),
-          g_ascii_strtoull (end, NULL, 10));
-    }
+typedef struct
+{
+  const gchar *hls_uri;
+  JsonArray *formats;
+  JsonArray *adaptive_formats;
+} YoutubeStreamingData;
+
+static const GtuberUtilsJsonField response_fields[] = {
+  GTUBER_UTILS_JSON_FIELD ("playabilityStatus", OBJECT, YoutubePlayerResponse, playability_status),
+  GTUBER_UTILS_JSON_FIELD ("videoDetails", OBJECT, YoutubePlayerResponse, video_details),
+  GTUBER_UTILS_JSON_FIELD ("streamingData", OBJECT, YoutubePlayerResponse, streaming_data),
+  GTUBER_UTILS_JSON_FIELD ("responseContext", OBJECT, YoutubePlayerResponse, response_context),
+};
+
+static const GtuberUtilsJsonField playability_fields[] = {
+  GTUBER_UTILS_JSON_FIELD ("status", STRING, YoutubePlayability, status),
+  GTUBER_UTILS_JSON_FIELD ("reason", STRING, YoutubePlayability, reason),
+};
 
-    gtuber_utils_json_go_back (reader, 1);
+static const GtuberUtilsJsonField video_details_fields[] = {
+  GTUBER_UTILS_JSON_FIELD ("videoId", STRING, YoutubeVideoDetails, id),
+  GTUBER_UTILS_JSON_FIELD ("title", STRING, YoutubeVideoDetails, title),
+  GTUBER_UTILS_JSON_FIELD ("shortDescription", STRING, YoutubeVideoDetails, desc),
+  GTUBER_UTILS_JSON_FIELD ("lengthSeconds", INT, YoutubeVideoDetails, duration),
+};
+
+static const GtuberUtilsJsonField streaming_data_fields[] = {
+  GTUBER_UTILS_JSON_FIELD ("hlsManifestUrl", STRING, YoutubeStreamingData, hls_uri),
+  GTUBER_UTILS_JSON_FIELD ("formats", ARRAY, YoutubeStreamingData, formats),
+  GTUBER_UTILS_JSON_FIELD ("adaptiveFormats", ARRAY, YoutubeStreamingData, adaptive_formats),
+};
+
+static const GtuberUtilsJsonSchema *
+_get_player_response_schema (void)
+{
+  static gsize schema = 0;
+
+  /* Only values read below, everything else is skipped while parsing */
+  if (g_once_init_enter (&schema)) {
+    g_once_init_leave (&schema, (gsize) gtuber_utils_json_schema_new (
+        "playabilityStatus.{status,reason}",
+        "videoDetails.{videoId,title,shortDescription,lengthSeconds}",
+        "streamingData.hlsManifestUrl",
+        "streamingData.{formats,adaptiveFormats}[*]"
+            ".{url,mimeType,type,itag,bitrate,width,height,fps,initRange,indexRange}",
+        "responseContext.visitorData",
+        NULL));
   }
 
-  gtuber_adaptive_stream_set_manifest_type (astream, GTUBER_ADAPTIVE_STREAM_MANIFEST_DASH);
-  gtuber_media_info_add_adaptive_stream (info, astream);
+  return (const GtuberUtilsJsonSchema *) schema;
 }
 
 static GtuberFlow
 parse_api_data (GtuberYoutube *self, GInputStream *stream,
     GtuberMediaInfo *info, GError **error)
 {
-  JsonParser *parser;
-  JsonReader *reader = NULL;
-  const gchar *status, *visitor_data;
+  JsonNode *root;
+  YoutubePlayerResponse response = { NULL, };
+  YoutubePlayability playability = { NULL, };
+  const gchar *visitor_data = NULL;
   GtuberFlow flow = GTUBER_FLOW_OK;
 
-  parser = json_parser_new ();
-  json_parser_load_from_stream (parser, stream, NULL, error);
+  root = gtuber_utils_json_extract_stream (stream,
+      _get_player_response_schema (), error);
   if (*error)
     goto finish;
 
-  gtuber_utils_json_parser_debug (parser);
-  reader = json_reader_new (json_parser_get_root (parser));
+  if (!JSON_NODE_HOLDS_OBJECT (root)) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_PARSE_FAILED,
+        "Could not parse player response");
+    goto finish;
+  }
+
+  gtuber_utils_json_project (json_node_get_object (root),
+      response_fields, G_N_ELEMENTS (response_fields), &response);
 
   /* Check if video is playable */
-  status = gtuber_utils_json_get_string (reader, "playabilityStatus", "status", NULL);
-  if (g_strcmp0 (status, "OK")) {
-    if (self->try_count < 2) {
+  if (response.playability_status) {
+    gtuber_utils_json_project (response.playability_status,
+        playability_fields, G_N_ELEMENTS (playability_fields), &playability);
+  }
+  if (g_strcmp0 (playability.status, "OK")) {
+    /* When racing, all profiles were already requested */
+    if (self->try_count < G_N_ELEMENTS (client_screens)) {
       flow = GTUBER_FLOW_RESTART;
       g_debug ("Video is not playable, trying again...");
     } else {
-      const gchar *reason;
-
-      reason = gtuber_utils_json_get_string (reader, "playabilityStatus", "reason", NULL);
-
       g_set_error (error, GTUBER_WEBSITE_ERROR,
           GTUBER_WEBSITE_ERROR_OTHER, "%s",
-          (reason != NULL) ? reason : "Video is not playable");
+          (playability.reason != NULL) ? playability.reason : "Video is not playable");
     }
     goto finish;
   }
 
-  if (gtuber_utils_json_go_to (reader, "videoDetails", NULL)) {
-    const gchar *id, *title, *desc, *duration;
+  if (response.video_details) {
+    YoutubeVideoDetails details = { NULL, };
 
-    id = gtuber_utils_json_get_string (reader, "videoId", NULL);
-    gtuber_media_info_set_id (info, id);
+    gtuber_utils_json_project (response.video_details,
+        video_details_fields, G_N_ELEMENTS (video_details_fields), &details);
 
-    title = gtuber_utils_json_get_string (reader, "title", NULL);
-    gtuber_media_info_set_title (info, title);
+    gtuber_media_info_set_id (info, details.id);
+    gtuber_media_info_set_title (info, details.title);
 
-    desc = gtuber_utils_json_get_string (reader, "shortDescription", NULL);
-    gtuber_media_info_set_description (info, desc);
-    gtuber_utils_youtube_insert_chapters_from_description (info, desc);
+    gtuber_media_info_set_description (info, details.desc);
+    gtuber_utils_youtube_insert_chapters_from_description (info, details.desc);
 
-    duration = gtuber_utils_json_get_string (reader, "lengthSeconds", NULL);
-    if (duration)
-      gtuber_media_info_set_duration (info, g_ascii_strtoull (duration, NULL, 10));
-
-    gtuber_utils_json_go_back (reader, 1);
+    if (details.duration > 0)
+      gtuber_media_info_set_duration (info, details.duration);
   }
 
-  if (gtuber_utils_json_go_to (reader, "streamingData", NULL)) {
-    self->hls_uri = g_strdup (gtuber_utils_json_get_string (reader, "hlsManifestUrl", NULL));
+  if (response.streaming_data) {
+    YoutubeStreamingData data = { NULL, };
+
+    gtuber_utils_json_project (response.streaming_data,
+        streaming_data_fields, G_N_ELEMENTS (streaming_data_fields), &data);
+
+    self->hls_uri = g_strdup (data.hls_uri);
 
     if (!self->hls_uri) {
-      if (gtuber_utils_json_go_to (reader, "formats", NULL)) {
-        gtuber_utils_json_array_foreach (reader, info,
-            (GtuberFunc) _read_stream_cb, NULL);
-        gtuber_utils_json_go_back (reader, 1);
+      if (data.formats) {
+        json_array_foreach_element (data.formats,
+            (JsonArrayForeach) _read_stream_cb, info);
       }
-      if (gtuber_utils_json_go_to (reader, "adaptiveFormats", NULL)) {
-        gtuber_utils_json_array_foreach (reader, info,
-            (GtuberFunc) _read_adaptive_stream_cb, NULL);
-        gtuber_utils_json_go_back (reader, 1);
+      if (data.adaptive_formats) {
+        json_array_foreach_element (data.adaptive_formats,
+            (JsonArrayForeach) _read_adaptive_stream_cb, info);
       }
     }
-    gtuber_utils_json_go_back (reader, 1);
   }
 
-  visitor_data = gtuber_utils_json_get_string (reader, "responseContext", "visitorData", NULL);
+  if (response.response_context
+      && json_object_has_member (response.response_context, "visitorData"))
+    visitor_data = json_object_get_string_member (response.response_context, "visitorData");
+
   if (visitor_data && strcmp (self->visitor_data, visitor_data)) {
     g_free (self->visitor_data);
     self->visitor_data = g_strdup (visitor_data);
@@ -281,53 +418,45 @@ finish:
   if (*error)
     flow = GTUBER_FLOW_ERROR;
 
-  g_clear_object (&reader);
-  g_clear_object (&parser);
+  if (root)
+    json_node_unref (root);
 
   return flow;
 }
 
-static gchar *
-obtain_video_id (GInputStream *stream, GError **error)
+static const GtuberUtilsJsonPath *
+_get_live_video_id_path (void)
 {
-  JsonParser *parser;
-  xmlDoc *doc;
-  gchar *data, *json_str, *video_id = NULL;
-
-  if (!(data = gtuber_utils_common_input_stream_to_data (stream, error)))
-    goto finish;
-
-  doc = gtuber_utils_xml_load_html_from_data (data, error);
-  g_free (data);
+  static gsize path = 0;
 
-  if (!doc)
-    goto finish;
+  /* Plugin module is resident, so compile it only once */
+  if (g_once_init_enter (&path)) {
+    g_once_init_leave (&path, (gsize) gtuber_utils_json_path_new (
+        "playabilityStatus.liveStreamability.liveStreamabilityRenderer.videoId"));
+  }
 
-  g_debug ("Downloaded HTML");
+  return (const GtuberUtilsJsonPath *) path;
+}
 
-  json_str = gtuber_utils_xml_obtain_json_in_node (doc, "ytInitialPlayerResponse");
-  xmlFreeDoc (doc);
+static gchar *
+obtain_video_id (const gchar *json_str, GError **error)
+{
+  JsonParser *parser;
+  gchar *video_id = NULL;
 
   if (!json_str)
     goto finish;
 
   parser = json_parser_new ();
   if ((json_parser_load_from_data (parser, json_str, -1, error))) {
-    JsonReader *reader;
-
     g_debug ("Got initial response JSON");
     gtuber_utils_json_parser_debug (parser);
 
-    reader = json_reader_new (json_parser_get_root (parser));
-    video_id = g_strdup (gtuber_utils_json_get_string (reader, "playabilityStatus",
-        "liveStreamability", "liveStreamabilityRenderer", "videoId", NULL));
-
-    g_object_unref (reader);
+    video_id = g_strdup (gtuber_utils_json_path_get_string (
+        _get_live_video_id_path (), json_parser_get_root (parser)));
   }
   g_object_unref (parser);
 
-  g_free (json_str);
-
 finish:
   if (!video_id && *error == NULL) {
     g_set_error (error, GTUBER_WEBSITE_ERROR,
@@ -337,53 +466,111 @@ finish:
   return video_id;
 }
 
+static const GtuberUtilsJsonTemplate *
+_get_player_req_template (void)
+{
+  static gsize tmpl = 0;
+
+  if (g_once_init_enter (&tmpl)) {
+    g_once_init_leave (&tmpl, (gsize) gtuber_utils_json_template_new ("{"
+        "\"context\":{"
+          "\"client\":{"
+            "\"clientName\":\"ANDROID\","
+            "\"clientVersion\":\"" GTUBER_YOUTUBE_CLI_VERSION "\","
+            "\"androidSdkVersion\":" G_STRINGIFY (GTUBER_YOUTUBE_ANDROID_SDK_MAJOR) ","
+            "\"userAgent\":@user_agent@,"
+            "\"clientScreen\":@client_screen@,"
+            "\"hl\":@hl@,"
+            "\"gl\":@gl@,"
+            "\"visitorData\":@visitor_data@,"
+            "\"timeZone\":\"UTC\"," // the same time as in "SAPISID"
+            "\"utcOffsetMinutes\":0"
+          "},"
+          "\"thirdParty\":{"
+            "\"embedUrl\":@embed_url@"
+          "},"
+          "\"user\":{"
+            "\"lockedSafetyMode\":false"
+          "}"
+        "},"
+        "\"video_id\":@video_id@,"
+        "\"params\":\"8AEB\","
+        "\"contentCheckOk\":true,"
+        "\"racyCheckOk\":true"
+      "}"));
+  }
+
+  return (const GtuberUtilsJsonTemplate *) tmpl;
+}
+
 static gchar *
-obtain_player_req_body (GtuberYoutube *self)
+obtain_player_req_body (GtuberYoutube *self, const gchar *cli_screen)
 {
-  gchar *req_body, **parts;
-  const gchar *cliScreen;
+  gchar *req_body, *embed_url, **parts;
 
-  /* Get EMBED video info on first try.
-   * If it fails, try default one on next try */
-  cliScreen = (self->try_count == 1)
-      ? "EMBED"
-      : NULL;
+  parts = g_strsplit (self->locale, "_", 0);
+  embed_url = g_strdup_printf ("https://www.youtube.com/watch?v=%s", self->video_id);
+
+  req_body = gtuber_utils_json_template_fill (_get_player_req_template (),
+      "user_agent", self->ua,
+      "client_screen", cli_screen,
+      "hl", parts[0],
+      "gl", parts[1],
+      "visitor_data", self->visitor_data,
+      "embed_url", embed_url,
+      "video_id", self->video_id,
+      NULL);
+
+  g_free (embed_url);
+  g_strfreev (parts);
+
+  return req_body;
+}
+
+static const GtuberUtilsJsonTemplate *
+_get_browse_req_template (void)
+{
+  static gsize tmpl = 0;
+
+  /* Target is either "browseId" or "continuation" */
+  if (g_once_init_enter (&tmpl)) {
+    g_once_init_leave (&tmpl, (gsize) gtuber_utils_json_template_new ("{"
+        "\"context\":{"
+          "\"client\":{"
+            "\"clientName\":\"WEB\","
+            "\"clientVersion\":\"" GTUBER_YOUTUBE_WEB_CLI_VERSION "\","
+            "\"hl\":@hl@,"
+            "\"gl\":@gl@,"
+            "\"visitorData\":@visitor_data@"
+          "}"
+        "},"
+        "@target_name@:@target@"
+      "}"));
+  }
+
+  return (const GtuberUtilsJsonTemplate *) tmpl;
+}
+
+static gchar *
+obtain_browse_req_body (GtuberYoutube *self, const gchar *continuation)
+{
+  gchar *req_body, *browse_id = NULL, **parts;
+
+  if (!continuation)
+    browse_id = g_strdup_printf ("VL%s", self->playlist_id);
 
   parts = g_strsplit (self->locale, "_", 0);
 
-  GTUBER_UTILS_JSON_BUILD_OBJECT (&req_body, {
-    GTUBER_UTILS_JSON_ADD_NAMED_OBJECT ("context", {
-      GTUBER_UTILS_JSON_ADD_NAMED_OBJECT ("client", {
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("clientName", "ANDROID");
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("clientVersion", GTUBER_YOUTUBE_CLI_VERSION);
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_INT ("androidSdkVersion", GTUBER_YOUTUBE_ANDROID_SDK_MAJOR);
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("userAgent", self->ua);
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("clientScreen", cliScreen);
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("hl", parts[0]);
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("gl", parts[1]);
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("visitorData", self->visitor_data);
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("timeZone", "UTC"); // the same time as in "SAPISID"
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_INT ("utcOffsetMinutes", 0);
-      });
-      GTUBER_UTILS_JSON_ADD_NAMED_OBJECT ("thirdParty", {
-        gchar *embed_url;
-
-        embed_url = g_strdup_printf ("https://www.youtube.com/watch?v=%s", self->video_id);
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("embedUrl", embed_url);
-
-        g_free (embed_url);
-      });
-      GTUBER_UTILS_JSON_ADD_NAMED_OBJECT ("user", {
-        GTUBER_UTILS_JSON_ADD_KEY_VAL_BOOLEAN ("lockedSafetyMode", FALSE);
-      });
-    });
-    GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("video_id", self->video_id);
-    GTUBER_UTILS_JSON_ADD_KEY_VAL_STRING ("params", "8AEB");
-    GTUBER_UTILS_JSON_ADD_KEY_VAL_BOOLEAN ("contentCheckOk", TRUE);
-    GTUBER_UTILS_JSON_ADD_KEY_VAL_BOOLEAN ("racyCheckOk", TRUE);
-  });
+  req_body = gtuber_utils_json_template_fill (_get_browse_req_template (),
+      "hl", parts[0],
+      "gl", parts[1],
+      "visitor_data", self->visitor_data,
+      "target_name", (continuation) ? "continuation" : "browseId",
+      "target", (continuation) ? continuation : browse_id,
+      NULL);
 
   g_strfreev (parts);
+  g_free (browse_id);
 
   return req_body;
 }
@@ -451,9 +638,15 @@ obtain_api_msg (GtuberYoutube *self)
   SoupMessageHeaders *headers;
   SoupCookieJar *jar;
   gchar *req_body;
+  const gchar *cli_screen;
+
+  /* Get EMBED video info on first try.
+   * If it fails, try default one on next try */
+  cli_screen = client_screens[self->try_count];
 
   self->try_count++;
-  g_debug ("Try number: %i", self->try_count);
+  g_debug ("Try number: %i, client screen: %s", self->try_count,
+      (cli_screen != NULL) ? cli_screen : "default");
 
   msg = soup_message_new ("POST",
       "https://www.youtube.com/youtubei/v1/player?"
@@ -483,7 +676,7 @@ obtain_api_msg (GtuberYoutube *self)
     g_free (cookies_str);
   }
 
-  req_body = obtain_player_req_body (self);
+  req_body = obtain_player_req_body (self, cli_screen);
   g_debug ("Request body: %s", req_body);
 
   gtuber_utils_common_msg_take_request (msg, "application/json", req_body);
@@ -517,24 +710,51 @@ gtuber_youtube_prepare (GtuberWebsite *website)
 
   g_debug ("Using locale: %s", self->locale);
 
+  self->race_clients = (g_getenv (GTUBER_YOUTUBE_RACE_CLIENTS_ENV) != NULL);
+
   self->ua = g_strdup_printf ("com.google.android.youtube/%s(Linux; U; Android %i; %s) gzip",
       GTUBER_YOUTUBE_CLI_VERSION, GTUBER_YOUTUBE_ANDROID_MAJOR, self->locale);
 }
 
+static void
+_set_common_req_headers (GtuberYoutube *self, SoupMessage *msg)
+{
+  SoupMessageHeaders *headers;
+
+  headers = soup_message_get_request_headers (msg);
+
+  soup_message_headers_replace (headers, "User-Agent", self->ua);
+  soup_message_headers_replace (headers, "Origin", GTUBER_YOUTUBE_X_ORIGIN);
+
+  soup_message_headers_append (headers, "X-Goog-Api-Format-Version", "2");
+  soup_message_headers_append (headers, "X-Goog-Visitor-Id", self->visitor_data);
+}
+
 static GtuberFlow
 gtuber_youtube_create_request (GtuberWebsite *website,
     GtuberMediaInfo *info, SoupMessage **msg, GError **error)
 {
   GtuberYoutube *self = GTUBER_YOUTUBE (website);
-  SoupMessageHeaders *headers;
 
   g_debug ("Create request step: %u", self->step);
 
+  if (!self->video_id && self->playlist_id) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_OTHER,
+        "URI points to a collection of videos, not a single one");
+    return GTUBER_FLOW_ERROR;
+  }
+
   switch (self->step) {
     case YOUTUBE_GET_VIDEO_ID:
       *msg = soup_message_new_from_uri ("GET", gtuber_website_get_uri (website));
       break;
     case YOUTUBE_GET_API_DATA:
+      if (self->race_clients) {
+        /* First playable response wins */
+        gtuber_website_set_fanout_race (website, TRUE);
+        return GTUBER_FLOW_FANOUT;
+      }
       *msg = obtain_api_msg (self);
       break;
     case YOUTUBE_GET_HLS:
@@ -545,17 +765,46 @@ gtuber_youtube_create_request (GtuberWebsite *website,
       break;
   }
 
-  headers = soup_message_get_request_headers (*msg);
+  /* Web page is only scanned until player response is found */
+  gtuber_website_set_chunked_parse (website, self->step == YOUTUBE_GET_VIDEO_ID);
+  _set_common_req_headers (self, *msg);
 
-  soup_message_headers_replace (headers, "User-Agent", self->ua);
-  soup_message_headers_replace (headers, "Origin", GTUBER_YOUTUBE_X_ORIGIN);
+  return GTUBER_FLOW_OK;
+}
 
-  soup_message_headers_append (headers, "X-Goog-Api-Format-Version", "2");
-  soup_message_headers_append (headers, "X-Goog-Visitor-Id", self->visitor_data);
+static GtuberFlow
+gtuber_youtube_create_requests (GtuberWebsite *website,
+    GtuberMediaInfo *info, GPtrArray *msgs, GError **error)
+{
+  GtuberYoutube *self = GTUBER_YOUTUBE (website);
+
+  while (self->try_count < G_N_ELEMENTS (client_screens)) {
+    SoupMessage *msg = obtain_api_msg (self);
+
+    _set_common_req_headers (self, msg);
+    g_ptr_array_add (msgs, msg);
+  }
 
   return GTUBER_FLOW_OK;
 }
 
+static GtuberFlow
+advance_step (GtuberYoutube *self, GtuberFlow flow, GError **error)
+{
+  if (*error)
+    return GTUBER_FLOW_ERROR;
+  if (flow == GTUBER_FLOW_OK)
+    self->step++;
+
+  /* Check if next step should be skipped */
+  if (self->step == YOUTUBE_GET_HLS && !self->hls_uri)
+    self->step++;
+
+  return (self->step >= YOUTUBE_EXTRACTION_FINISH)
+      ? GTUBER_FLOW_OK
+      : GTUBER_FLOW_RESTART;
+}
+
 static GtuberFlow
 gtuber_youtube_parse_input_stream (GtuberWebsite *website,
     GInputStream *stream, GtuberMediaInfo *info, GError **error)
@@ -566,9 +815,6 @@ gtuber_youtube_parse_input_stream (GtuberWebsite *website,
   g_debug ("Parse step: %u", self->step);
 
   switch (self->step) {
-    case YOUTUBE_GET_VIDEO_ID:
-      self->video_id = obtain_video_id (stream, error);
-      break;
     case YOUTUBE_GET_API_DATA:
       flow = parse_api_data (self, stream, info, error);
       break;
@@ -580,18 +826,151 @@ gtuber_youtube_parse_input_stream (GtuberWebsite *website,
       break;
   }
 
-  if (*error)
+  return advance_step (self, flow, error);
+}
+
+static GtuberFlow
+gtuber_youtube_parse_data_chunk (GtuberWebsite *website,
+    const gchar *chunk, gsize size, GtuberMediaInfo *info,
+    gboolean *finished, GError **error)
+{
+  GtuberYoutube *self = GTUBER_YOUTUBE (website);
+  gchar *json_str;
+
+  if (!self->page_scanner) {
+    g_debug ("Scanning HTML...");
+    self->page_scanner = gtuber_utils_xml_json_scanner_new ("ytInitialPlayerResponse");
+  }
+
+  if (size > 0) {
+    if (!gtuber_utils_xml_json_scanner_push_data (self->page_scanner, chunk, size))
+      return GTUBER_FLOW_OK;
+
+    /* No need to download the rest of the page */
+    *finished = TRUE;
+  }
+
+  json_str = gtuber_utils_xml_json_scanner_finish (self->page_scanner);
+  g_clear_pointer (&self->page_scanner, gtuber_utils_xml_json_scanner_free);
+
+  self->video_id = obtain_video_id (json_str, error);
+  g_free (json_str);
+
+  return advance_step (self, GTUBER_FLOW_OK, error);
+}
+
+static GtuberFlow
+gtuber_youtube_create_collection_request (GtuberWebsite *website,
+    const gchar *continuation, SoupMessage **msg, GError **error)
+{
+  GtuberYoutube *self = GTUBER_YOUTUBE (website);
+  SoupMessageHeaders *headers;
+  gchar *req_body;
+
+  if (!self->playlist_id)
     return GTUBER_FLOW_ERROR;
-  if (flow == GTUBER_FLOW_OK)
-    self->step++;
 
-  /* Check if next step should be skipped */
-  if (self->step == YOUTUBE_GET_HLS && !self->hls_uri)
-    self->step++;
+  *msg = soup_message_new ("POST",
+      "https://www.youtube.com/youtubei/v1/browse?prettyPrint=false");
+  headers = soup_message_get_request_headers (*msg);
 
-  return (self->step >= YOUTUBE_EXTRACTION_FINISH)
-      ? GTUBER_FLOW_OK
-      : GTUBER_FLOW_RESTART;
+  soup_message_headers_replace (headers, "Origin", GTUBER_YOUTUBE_X_ORIGIN);
+  soup_message_headers_append (headers, "X-YouTube-Client-Name", "1"); // 1 = WEB
+  soup_message_headers_append (headers, "X-YouTube-Client-Version", GTUBER_YOUTUBE_WEB_CLI_VERSION);
+  soup_message_headers_append (headers, "X-Goog-Visitor-Id", self->visitor_data);
+
+  req_body = obtain_browse_req_body (self, continuation);
+  g_debug ("Request body: %s", req_body);
+
+  gtuber_utils_common_msg_take_request (*msg, "application/json", req_body);
+
+  return GTUBER_FLOW_OK;
+}
+
+typedef struct
+{
+  GtuberUtilsJsonPath *video_id;
+  GtuberUtilsJsonPath *playable;
+  GtuberUtilsJsonPath *continuation;
+} YoutubeEntryPaths;
+
+static const YoutubeEntryPaths *
+_get_entry_paths (void)
+{
+  static gsize paths = 0;
+
+  if (g_once_init_enter (&paths)) {
+    YoutubeEntryPaths *entry_paths = g_new (YoutubeEntryPaths, 1);
+
+    entry_paths->video_id = gtuber_utils_json_path_new ("playlistVideoRenderer.videoId");
+    entry_paths->playable = gtuber_utils_json_path_new ("playlistVideoRenderer.isPlayable");
+    entry_paths->continuation = gtuber_utils_json_path_new (
+        "continuationItemRenderer.continuationEndpoint.continuationCommand.token");
+
+    g_once_init_leave (&paths, (gsize) entry_paths);
+  }
+
+  return (const YoutubeEntryPaths *) paths;
+}
+
+static void
+_collect_playlist_entries (JsonNode *node, GPtrArray *entries, gchar **continuation)
+{
+  const YoutubeEntryPaths *paths = _get_entry_paths ();
+
+  if (JSON_NODE_HOLDS_OBJECT (node)) {
+    JsonObject *object = json_node_get_object (node);
+    GList *members, *member;
+    const gchar *str;
+
+    if ((str = gtuber_utils_json_path_get_string (paths->video_id, node))) {
+      /* Deleted and private videos are still listed */
+      if (!gtuber_utils_json_path_get_node (paths->playable, node)
+          || gtuber_utils_json_path_get_boolean (paths->playable, node))
+        g_ptr_array_add (entries, g_strdup_printf ("https://www.youtube.com/watch?v=%s", str));
+
+      return;
+    }
+    if ((str = gtuber_utils_json_path_get_string (paths->continuation, node))) {
+      g_free (*continuation);
+      *continuation = g_strdup (str);
+
+      return;
+    }
+
+    members = json_object_get_values (object);
+    for (member = members; member; member = g_list_next (member))
+      _collect_playlist_entries (member->data, entries, continuation);
+    g_list_free (members);
+  } else if (JSON_NODE_HOLDS_ARRAY (node)) {
+    GList *elements, *element;
+
+    elements = json_array_get_elements (json_node_get_array (node));
+    for (element = elements; element; element = g_list_next (element))
+      _collect_playlist_entries (element->data, entries, continuation);
+    g_list_free (elements);
+  }
+}
+
+static GtuberFlow
+gtuber_youtube_parse_collection_page (GtuberWebsite *website,
+    GInputStream *stream, GPtrArray *entries, gchar **continuation, GError **error)
+{
+  JsonParser *parser;
+
+  parser = json_parser_new ();
+
+  /* Entries are nested deep inside page layout renderers,
+   * which differ between first and continuation pages */
+  if (json_parser_load_from_stream (parser, stream, NULL, error))
+    _collect_playlist_entries (json_parser_get_root (parser), entries, continuation);
+
+  g_object_unref (parser);
+
+  if (*error)
+    return GTUBER_FLOW_ERROR;
+
+  return GTUBER_FLOW_OK;
 }
 
 static GtuberFlow
@@ -622,13 +1001,17 @@ gtuber_youtube_class_init (GtuberYoutubeClass *klass)
   website_class->prepare = gtuber_youtube_prepare;
   website_class->create_request = gtuber_youtube_create_request;
   website_class->parse_input_stream = gtuber_youtube_parse_input_stream;
+  website_class->parse_data_chunk = gtuber_youtube_parse_data_chunk;
+  website_class->create_requests = gtuber_youtube_create_requests;
+  website_class->create_collection_request = gtuber_youtube_create_collection_request;
+  website_class->parse_collection_page = gtuber_youtube_parse_collection_page;
   website_class->set_user_req_headers = gtuber_youtube_set_user_req_headers;
 }
 
 GtuberWebsite *
 plugin_query (GUri *uri)
 {
-  gchar *id;
+  gchar *id, *playlist_id;
   gboolean matched, is_video = FALSE;
 
   matched = gtuber_utils_common_uri_matches_hosts (uri, NULL,
@@ -643,7 +1026,19 @@ plugin_query (GUri *uri)
         "/v/", "/embed/", NULL);
   }
 
-  if (!id) {
+  /* Channel videos are in its "uploads" playlist */
+  if (!(playlist_id = gtuber_utils_common_obtain_uri_query_value (uri, "list"))) {
+    gchar *channel_id;
+
+    channel_id = gtuber_utils_common_obtain_uri_id_from_paths (uri, NULL, "/channel/", NULL);
+
+    if (channel_id && g_str_has_prefix (channel_id, "UC"))
+      playlist_id = g_strdup_printf ("UU%s", channel_id + 2);
+
+    g_free (channel_id);
+  }
+
+  if (!id && !playlist_id) {
     gchar *suffix;
 
     suffix = gtuber_utils_common_obtain_uri_id_from_paths (uri, NULL, "/*/", NULL);
@@ -652,13 +1047,19 @@ plugin_query (GUri *uri)
     g_free (suffix);
   }
 
-  if (id || is_video) {
+  if (id || playlist_id || is_video) {
     GtuberYoutube *youtube;
 
     youtube = gtuber_youtube_new ();
     youtube->video_id = id;
+    youtube->playlist_id = playlist_id;
+
+    /* Playlist without video cannot be played directly */
+    gtuber_website_set_collection_only (GTUBER_WEBSITE (youtube),
+        (!id && !is_video));
 
-    g_debug ("Requested video: %s", youtube->video_id);
+    g_debug ("Requested video: %s, playlist: %s",
+        youtube->video_id, youtube->playlist_id);
 
     return GTUBER_WEBSITE (youtube);
   }
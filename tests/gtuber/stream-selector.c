@@ -0,0 +1,175 @@
+#include "../tests.h"
+
+static void
+_add_stream (GtuberMediaInfo *info, gboolean adaptive, guint itag,
+    const gchar *vcodec, const gchar *acodec, guint height, guint fps, guint bitrate)
+{
+  GtuberStream *stream;
+
+  stream = (adaptive)
+      ? GTUBER_STREAM (gtuber_adaptive_stream_new ())
+      : gtuber_stream_new ();
+
+  gtuber_stream_set_itag (stream, itag);
+  gtuber_stream_set_video_codec (stream, vcodec);
+  gtuber_stream_set_audio_codec (stream, acodec);
+  gtuber_stream_set_width (stream, height * 16 / 9);
+  gtuber_stream_set_height (stream, height);
+  gtuber_stream_set_fps (stream, fps);
+  gtuber_stream_set_bitrate (stream, bitrate);
+
+  if (adaptive)
+    gtuber_media_info_add_adaptive_stream (info, GTUBER_ADAPTIVE_STREAM (stream));
+  else
+    gtuber_media_info_add_stream (info, stream);
+}
+
+static GtuberMediaInfo *
+_create_media_info (void)
+{
+  GtuberMediaInfo *info = g_object_new (GTUBER_TYPE_MEDIA_INFO, NULL);
+
+  _add_stream (info, TRUE, 137, "avc1.640028", NULL, 1080, 30, 4000000);
+  _add_stream (info, TRUE, 248, "vp9", NULL, 1080, 60, 3000000);
+  _add_stream (info, TRUE, 136, "avc1.4d401f", NULL, 720, 30, 2000000);
+  _add_stream (info, TRUE, 140, NULL, "mp4a.40.2", 0, 0, 128000);
+  _add_stream (info, TRUE, 251, NULL, "opus", 0, 0, 160000);
+  _add_stream (info, FALSE, 18, "avc1.42001E", "mp4a.40.2", 360, 30, 500000);
+
+  return info;
+}
+
+static void
+_assert_best_itag (GtuberStreamSelector *selector, GtuberStreamContent content,
+    gboolean include_adaptive, guint expected_itag)
+{
+  GtuberStream *stream;
+
+  stream = gtuber_stream_selector_get_best_stream (selector, content, include_adaptive);
+
+  if (expected_itag == 0) {
+    g_assert_null (stream);
+    return;
+  }
+
+  g_assert_nonnull (stream);
+  assert_equals_int (gtuber_stream_get_itag (stream), expected_itag);
+}
+
+static void
+_assert_allowed_itags (GtuberStreamSelector *selector, const guint *expected, guint n_expected)
+{
+  GPtrArray *astreams;
+  guint i;
+
+  astreams = gtuber_stream_selector_get_allowed_adaptive_streams (selector);
+  assert_equals_int (astreams->len, n_expected);
+
+  for (i = 0; i < astreams->len; i++)
+    assert_equals_int (gtuber_stream_get_itag (g_ptr_array_index (astreams, i)), expected[i]);
+
+  g_ptr_array_unref (astreams);
+}
+
+GTUBER_TEST_MAIN_START ()
+
+/* No constraints */
+GTUBER_TEST_CASE (1)
+{
+  GtuberMediaInfo *info = _create_media_info ();
+  GtuberStreamSelector *selector = gtuber_stream_selector_new (info);
+  const guint allowed[] = { 137, 248, 136, 140, 251 };
+
+  _assert_allowed_itags (selector, allowed, G_N_ELEMENTS (allowed));
+
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO, TRUE, 137);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_AUDIO, TRUE, 251);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO_AUDIO, TRUE, 18);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO, FALSE, 0);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_UNKNOWN, FALSE, 18);
+
+  assert_equals_int (gtuber_stream_selector_get_stream_content (selector,
+      gtuber_stream_selector_get_stream_by_itag (selector, 18)),
+      GTUBER_STREAM_CONTENT_VIDEO_AUDIO);
+  assert_equals_int (gtuber_stream_selector_get_stream_content (selector,
+      gtuber_stream_selector_get_stream_by_itag (selector, 140)),
+      GTUBER_STREAM_CONTENT_AUDIO);
+  g_assert_null (gtuber_stream_selector_get_stream_by_itag (selector, 22));
+
+  g_object_unref (selector);
+  g_object_unref (info);
+}
+
+/* Codecs, stream must use only allowed ones */
+GTUBER_TEST_CASE (2)
+{
+  GtuberMediaInfo *info = _create_media_info ();
+  GtuberStreamSelector *selector = gtuber_stream_selector_new (info);
+  const guint allowed[] = { 137, 136, 140 };
+
+  gtuber_stream_selector_set_codecs (selector, GTUBER_CODEC_AVC | GTUBER_CODEC_MP4A);
+
+  _assert_allowed_itags (selector, allowed, G_N_ELEMENTS (allowed));
+
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO, TRUE, 137);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_AUDIO, TRUE, 140);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO_AUDIO, FALSE, 18);
+
+  /* Muxed stream also has MP4A audio */
+  gtuber_stream_selector_set_codecs (selector, GTUBER_CODEC_AVC);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO_AUDIO, FALSE, 0);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_AUDIO, TRUE, 0);
+
+  gtuber_stream_selector_set_codecs (selector, GTUBER_CODEC_VP9 | GTUBER_CODEC_OPUS);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO, TRUE, 248);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_AUDIO, TRUE, 251);
+
+  g_object_unref (selector);
+  g_object_unref (info);
+}
+
+/* Max height and fps, audio streams are not affected */
+GTUBER_TEST_CASE (3)
+{
+  GtuberMediaInfo *info = _create_media_info ();
+  GtuberStreamSelector *selector = gtuber_stream_selector_new (info);
+  const guint allowed[] = { 136, 140, 251 };
+
+  gtuber_stream_selector_set_max_height (selector, 720);
+
+  _assert_allowed_itags (selector, allowed, G_N_ELEMENTS (allowed));
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO, TRUE, 136);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_AUDIO, TRUE, 251);
+
+  gtuber_stream_selector_set_max_height (selector, 0);
+  gtuber_stream_selector_set_max_fps (selector, 30);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO, TRUE, 137);
+
+  gtuber_stream_selector_set_codecs (selector, GTUBER_CODEC_VP9);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO, TRUE, 0);
+
+  g_object_unref (selector);
+  g_object_unref (info);
+}
+
+/* Itags */
+GTUBER_TEST_CASE (4)
+{
+  GtuberMediaInfo *info = _create_media_info ();
+  GtuberStreamSelector *selector = gtuber_stream_selector_new (info);
+  const guint allowed[] = { 136, 140 };
+
+  gtuber_stream_selector_set_itags (selector, "136, 140,invalid");
+
+  _assert_allowed_itags (selector, allowed, G_N_ELEMENTS (allowed));
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO, TRUE, 136);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO_AUDIO, FALSE, 0);
+
+  gtuber_stream_selector_set_itags (selector, NULL);
+  _assert_best_itag (selector, GTUBER_STREAM_CONTENT_VIDEO, TRUE, 137);
+
+  g_object_unref (selector);
+  g_object_unref (info);
+}
+
+GTUBER_TEST_MAIN_END ()
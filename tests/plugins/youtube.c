@@ -1,5 +1,28 @@
 #include "../tests.h"
 
+/* Resolving whole playlist takes too long */
+#define MAX_COLLECTION_ENTRIES 3
+
+typedef struct
+{
+  GCancellable *cancellable;
+  guint n_entries;
+} CollectionData;
+
+static void
+_collection_entry_cb (GtuberClient *client, const gchar *uri,
+    GtuberMediaInfo *info, const GError *error, CollectionData *data)
+{
+  if (g_cancellable_is_cancelled (data->cancellable))
+    return;
+
+  g_assert_no_error (error);
+  check_adaptive_streams (info);
+
+  if (++data->n_entries >= MAX_COLLECTION_ENTRIES)
+    g_cancellable_cancel (data->cancellable);
+}
+
 GTUBER_TEST_MAIN_START ()
 
 GTUBER_TEST_CASE (1)
@@ -55,4 +78,28 @@ GTUBER_TEST_CASE (4)
   g_object_unref (client);
 }
 
+GTUBER_TEST_CASE (5)
+{
+  GtuberClient *client = gtuber_client_new ();
+  CollectionData data = { NULL, };
+  GError *error = NULL;
+
+  data.cancellable = g_cancellable_new ();
+
+  gtuber_client_expand_collection (client,
+      "https://www.youtube.com/playlist?list=PL4lCao7KL_QFVb7Iudeipvc2BCavECqzc",
+      MAX_COLLECTION_ENTRIES, (GtuberCollectionEntryFunc) _collection_entry_cb, &data,
+      data.cancellable, &error);
+
+  /* Cancelled on purpose after enough entries */
+  if (error && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    g_clear_error (&error);
+
+  g_assert_no_error (error);
+  g_assert_cmpuint (data.n_entries, >, 0);
+
+  g_object_unref (data.cancellable);
+  g_object_unref (client);
+}
+
 GTUBER_TEST_MAIN_END ()
@@ -0,0 +1,117 @@
+#include "../tests.h"
+#include "utils/common/gtuber-utils-common.h"
+
+static const gchar *dash_segment_base_mpd =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+  "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" type=\"static\""
+  "    mediaPresentationDuration=\"PT1M5.5S\">"
+  "  <Period>"
+  "    <AdaptationSet mimeType=\"video/mp4\" frameRate=\"30000/1001\">"
+  "      <Representation id=\"1\" codecs=\"avc1.4d401f\" width=\"1280\" height=\"720\" bandwidth=\"2000000\">"
+  "        <BaseURL>video_720.mp4</BaseURL>"
+  "        <SegmentBase indexRange=\"700-999\">"
+  "          <Initialization range=\"0-699\"/>"
+  "        </SegmentBase>"
+  "      </Representation>"
+  "    </AdaptationSet>"
+  "    <AdaptationSet mimeType=\"audio/mp4\">"
+  "      <Representation id=\"2\" codecs=\"mp4a.40.2\" bandwidth=\"128000\">"
+  "        <BaseURL>https://cdn.example.com/audio.mp4</BaseURL>"
+  "      </Representation>"
+  "    </AdaptationSet>"
+  "  </Period>"
+  "</MPD>";
+
+static const gchar *dash_segment_template_mpd =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+  "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" type=\"static\">"
+  "  <Period>"
+  "    <AdaptationSet mimeType=\"video/mp4\">"
+  "      <Representation id=\"1\" codecs=\"avc1.4d401f\" bandwidth=\"2000000\">"
+  "        <BaseURL>video_720.mp4</BaseURL>"
+  "      </Representation>"
+  "      <Representation id=\"2\" codecs=\"avc1.4d401f\" bandwidth=\"1000000\">"
+  "        <SegmentTemplate media=\"video_480_$Number$.m4s\" initialization=\"video_480_init.mp4\"/>"
+  "      </Representation>"
+  "    </AdaptationSet>"
+  "  </Period>"
+  "</MPD>";
+
+static gboolean
+_parse_dash_string (const gchar *mpd, GtuberMediaInfo *info, GError **error)
+{
+  GInputStream *stream;
+  gboolean success;
+
+  stream = g_memory_input_stream_new_from_data (mpd, -1, NULL);
+  success = gtuber_utils_common_parse_dash_input_stream_with_base_uri (stream,
+      info, "https://www.example.com/media/manifest.mpd", error);
+  g_object_unref (stream);
+
+  return success;
+}
+
+GTUBER_TEST_MAIN_START ()
+
+GTUBER_TEST_CASE (1)
+{
+  GtuberMediaInfo *info = g_object_new (GTUBER_TYPE_MEDIA_INFO, NULL);
+  GtuberAdaptiveStream *astream;
+  GtuberStream *stream;
+  GPtrArray *astreams;
+  GError *error = NULL;
+  guint64 start = 0, end = 0;
+
+  g_assert_true (_parse_dash_string (dash_segment_base_mpd, info, &error));
+  g_assert_no_error (error);
+
+  assert_equals_int (gtuber_media_info_get_duration (info), 65);
+
+  astreams = gtuber_media_info_get_adaptive_streams (info);
+  assert_equals_int (astreams->len, 2);
+
+  astream = g_ptr_array_index (astreams, 0);
+  stream = GTUBER_STREAM (astream);
+
+  assert_equals_int (gtuber_adaptive_stream_get_manifest_type (astream),
+      GTUBER_ADAPTIVE_STREAM_MANIFEST_DASH);
+  assert_equals_string (gtuber_stream_get_uri (stream),
+      "https://www.example.com/media/video_720.mp4");
+  assert_equals_string (gtuber_stream_get_video_codec (stream), "avc1.4d401f");
+  g_assert_null (gtuber_stream_get_audio_codec (stream));
+  assert_equals_int (gtuber_stream_get_height (stream), 720);
+  assert_equals_int (gtuber_stream_get_fps (stream), 30);
+  assert_equals_int (gtuber_stream_get_bitrate (stream), 2000000);
+
+  g_assert_true (gtuber_adaptive_stream_get_init_range (astream, &start, &end));
+  assert_equals_int (start, 0);
+  assert_equals_int (end, 699);
+  g_assert_true (gtuber_adaptive_stream_get_index_range (astream, &start, &end));
+  assert_equals_int (start, 700);
+  assert_equals_int (end, 999);
+
+  astream = g_ptr_array_index (astreams, 1);
+  stream = GTUBER_STREAM (astream);
+
+  assert_equals_string (gtuber_stream_get_uri (stream),
+      "https://cdn.example.com/audio.mp4");
+  assert_equals_string (gtuber_stream_get_audio_codec (stream), "mp4a.40.2");
+  g_assert_null (gtuber_stream_get_video_codec (stream));
+  g_assert_false (gtuber_adaptive_stream_get_index_range (astream, &start, &end));
+
+  g_object_unref (info);
+}
+
+GTUBER_TEST_CASE (2)
+{
+  GtuberMediaInfo *info = g_object_new (GTUBER_TYPE_MEDIA_INFO, NULL);
+  GError *error = NULL;
+
+  g_assert_false (_parse_dash_string (dash_segment_template_mpd, info, &error));
+  g_assert_error (error, GTUBER_WEBSITE_ERROR, GTUBER_WEBSITE_ERROR_PARSE_FAILED);
+
+  g_clear_error (&error);
+  g_object_unref (info);
+}
+
+GTUBER_TEST_MAIN_END ()
@@ -0,0 +1,110 @@
+#include "../tests.h"
+#include "utils/json/gtuber-utils-json.h"
+
+static const gchar *json_data =
+  "{"
+    "\"id\":\"abc\","
+    "\"skipped\":{\"a\":[1,2,3]},"
+    "\"formats\":["
+      "{\"itag\":18,\"url\":\"https://example.com/18\",\"live\":false},"
+      "{\"itag\":\"22\",\"url\":\"https://example.com/22\",\"live\":true}"
+    "]"
+  "}";
+
+static JsonNode *
+_parse_json_data (void)
+{
+  JsonParser *parser = json_parser_new ();
+  JsonNode *root;
+  GError *error = NULL;
+
+  json_parser_load_from_data (parser, json_data, -1, &error);
+  g_assert_no_error (error);
+
+  root = json_node_copy (json_parser_get_root (parser));
+  g_object_unref (parser);
+
+  return root;
+}
+
+GTUBER_TEST_MAIN_START ()
+
+/* Compiled paths */
+GTUBER_TEST_CASE (1)
+{
+  JsonNode *root = _parse_json_data ();
+  GtuberUtilsJsonPath *path;
+
+  path = gtuber_utils_json_path_new ("formats[1].url");
+  g_assert_nonnull (path);
+  assert_equals_string (gtuber_utils_json_path_get_string (path, root),
+      "https://example.com/22");
+  gtuber_utils_json_path_free (path);
+
+  path = gtuber_utils_json_path_new ("formats[1].itag");
+  assert_equals_int (gtuber_utils_json_path_get_int (path, root), 22);
+  gtuber_utils_json_path_free (path);
+
+  path = gtuber_utils_json_path_new ("formats[0].live");
+  g_assert_false (gtuber_utils_json_path_get_boolean (path, root));
+  gtuber_utils_json_path_free (path);
+
+  path = gtuber_utils_json_path_new ("formats[5].url");
+  g_assert_null (gtuber_utils_json_path_get_node (path, root));
+  gtuber_utils_json_path_free (path);
+
+  /* Malformed ones are rejected */
+  g_assert_null (gtuber_utils_json_path_new ("formats[1.url"));
+  g_assert_null (gtuber_utils_json_path_new ("formats[].url"));
+  g_assert_null (gtuber_utils_json_path_new ("formats[*].url"));
+  g_assert_null (gtuber_utils_json_path_new ("formats]1[.url"));
+  g_assert_null (gtuber_utils_json_path_new ("formats[0]].url"));
+
+  json_node_unref (root);
+}
+
+/* Streaming extractor */
+GTUBER_TEST_CASE (2)
+{
+  GtuberUtilsJsonSchema *schema;
+  GtuberUtilsJsonPath *path;
+  GInputStream *stream;
+  JsonNode *root;
+  JsonObject *root_obj;
+  GError *error = NULL;
+
+  schema = gtuber_utils_json_schema_new ("id", "formats[*].{itag,url}", NULL);
+  g_assert_nonnull (schema);
+
+  stream = g_memory_input_stream_new_from_data (json_data, -1, NULL);
+  root = gtuber_utils_json_extract_stream (stream, schema, &error);
+  g_object_unref (stream);
+
+  g_assert_no_error (error);
+  g_assert_nonnull (root);
+
+  root_obj = json_node_get_object (root);
+  g_assert_true (json_object_has_member (root_obj, "id"));
+  g_assert_false (json_object_has_member (root_obj, "skipped"));
+
+  path = gtuber_utils_json_path_new ("formats[0].url");
+  assert_equals_string (gtuber_utils_json_path_get_string (path, root),
+      "https://example.com/18");
+  gtuber_utils_json_path_free (path);
+
+  path = gtuber_utils_json_path_new ("formats[1].live");
+  g_assert_null (gtuber_utils_json_path_get_node (path, root));
+  gtuber_utils_json_path_free (path);
+
+  json_node_unref (root);
+  gtuber_utils_json_schema_free (schema);
+
+  /* Malformed ones are rejected */
+  g_assert_null (gtuber_utils_json_schema_new ("formats[0].url", NULL));
+  g_assert_null (gtuber_utils_json_schema_new ("formats[*.url", NULL));
+  g_assert_null (gtuber_utils_json_schema_new ("formats]*[.url", NULL));
+  g_assert_null (gtuber_utils_json_schema_new ("id", "formats[*].{itag,url", NULL));
+  g_assert_null (gtuber_utils_json_schema_new ("formats[*].itag}", NULL));
+}
+
+GTUBER_TEST_MAIN_END ()
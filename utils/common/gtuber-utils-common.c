@@ -373,6 +373,8 @@ unknown:
   return GTUBER_STREAM_MIME_TYPE_UNKNOWN;
 }
 
+#define HLS_CHUNK_SIZE 8192
+
 typedef enum
 {
   HLS_PARAM_NONE,
@@ -412,7 +414,12 @@ get_hls_param_type (const gchar *param)
 static gboolean
 get_is_audio_codec (const gchar *codec)
 {
-  if (g_str_has_prefix (codec, "mp4a"))
+  if (g_str_has_prefix (codec, "mp4a")
+      || g_str_has_prefix (codec, "opus")
+      || g_str_has_prefix (codec, "vorbis")
+      || g_str_has_prefix (codec, "ac-3")
+      || g_str_has_prefix (codec, "ec-3")
+      || g_str_has_prefix (codec, "flac"))
     return TRUE;
 
   return FALSE;
@@ -448,227 +455,1131 @@ _unquote_str (gchar *string)
     memmove (string, string + 1, strlen (string));
 }
 
-gboolean
-gtuber_utils_common_parse_hls_input_stream_with_base_uri (GInputStream *stream,
-    GtuberMediaInfo *info, const gchar *base_uri, GError **error)
+struct _GtuberUtilsCommonHlsParser
 {
-  GDataInputStream *dstream = g_data_input_stream_new (stream);
-  GtuberAdaptiveStream *astream = NULL;
-  gchar *line;
-  guint itag = 1;
-  gboolean success = FALSE;
-
-  g_debug ("Parsing HLS...");
+  GtuberMediaInfo *info;
+  gchar *base_uri;
 
-  while ((line = g_data_input_stream_read_line (dstream, NULL, NULL, error))) {
-    guint line_offset = 0;
+  GString *pending;
+  GtuberAdaptiveStream *astream;
+  guint itag;
 
-    if (g_str_has_prefix (line, "#EXT-X-MEDIA:"))
-      line_offset = 13;
-    else if (g_str_has_prefix (line, "#EXT-X-STREAM-INF:"))
-      line_offset = 18;
+  gboolean success;
+};
 
-    if (line_offset > 0) {
-      gchar **params = g_strsplit_set (line + line_offset, ",=", 0);
-      gchar *str;
-      gint i = 0;
-      guint group_itag = 0;
-      HlsParamType last = HLS_PARAM_NONE;
-      GtuberStream *bstream;
+static void
+_hls_parser_read_line (GtuberUtilsCommonHlsParser *parser, gchar *line)
+{
+  GtuberMediaInfo *info = parser->info;
+  guint line_offset = 0;
+
+  if (g_str_has_prefix (line, "#EXT-X-MEDIA:"))
+    line_offset = 13;
+  else if (g_str_has_prefix (line, "#EXT-X-STREAM-INF:"))
+    line_offset = 18;
+
+  if (line_offset > 0) {
+    gchar **params = g_strsplit_set (line + line_offset, ",=", 0);
+    gchar *str;
+    gint i = 0;
+    guint group_itag = 0;
+    HlsParamType last = HLS_PARAM_NONE;
+    GtuberStream *bstream;
+
+    if (!parser->astream) {
+      parser->astream = gtuber_adaptive_stream_new ();
+
+      gtuber_adaptive_stream_set_manifest_type (parser->astream,
+          GTUBER_ADAPTIVE_STREAM_MANIFEST_HLS);
+      gtuber_stream_set_itag ((GtuberStream *) parser->astream, parser->itag);
+
+      g_debug ("Created new adaptive stream, itag: %u", parser->itag);
+    }
 
-      if (!astream) {
-        astream = gtuber_adaptive_stream_new ();
+    bstream = GTUBER_STREAM (parser->astream);
 
-        gtuber_adaptive_stream_set_manifest_type (astream,
-            GTUBER_ADAPTIVE_STREAM_MANIFEST_HLS);
-        gtuber_stream_set_itag ((GtuberStream *) astream, itag);
+    while ((str = params[i])) {
+      HlsParamType current;
 
-        g_debug ("Created new adaptive stream, itag: %u", itag);
+      if (!strlen (str)) {
+        i++;
+        continue;
       }
 
-      bstream = GTUBER_STREAM (astream);
-
-      while ((str = params[i])) {
-        HlsParamType current;
-
-        if (!strlen (str)) {
-          i++;
-          continue;
-        }
-
-        current = get_hls_param_type (str);
-        if (current != HLS_PARAM_NONE) {
-          last = current;
-          i++;
-          continue;
-        }
+      current = get_hls_param_type (str);
+      if (current != HLS_PARAM_NONE) {
+        last = current;
+        i++;
+        continue;
+      }
 
-        _unquote_str (str);
+      _unquote_str (str);
 
-        switch (last) {
-          case HLS_PARAM_BANDWIDTH:{
-            guint old_bitrate, bitrate;
+      switch (last) {
+        case HLS_PARAM_BANDWIDTH:{
+          guint old_bitrate, bitrate;
 
-            old_bitrate = gtuber_stream_get_bitrate (bstream);
-            bitrate = g_ascii_strtoull (str, NULL, 10);
+          old_bitrate = gtuber_stream_get_bitrate (bstream);
+          bitrate = g_ascii_strtoull (str, NULL, 10);
 
-            /* Use average bitrate if available */
-            if (old_bitrate == 0 || old_bitrate > bitrate) {
-              g_debug ("HLS stream bitrate: %s", str);
-              gtuber_stream_set_bitrate (bstream, bitrate);
-            }
-            break;
+          /* Use average bitrate if available */
+          if (old_bitrate == 0 || old_bitrate > bitrate) {
+            g_debug ("HLS stream bitrate: %s", str);
+            gtuber_stream_set_bitrate (bstream, bitrate);
           }
-          case HLS_PARAM_RESOLUTION:{
-            gchar **resolution = g_strsplit (str, "x", 3);
-            if (resolution[0] && resolution[1]) {
-              g_debug ("HLS stream width: %s, height: %s", resolution[0], resolution[1]);
-              gtuber_stream_set_width (bstream, g_ascii_strtoull (resolution[0], NULL, 10));
-              gtuber_stream_set_height (bstream, g_ascii_strtoull (resolution[1], NULL, 10));
-            }
-            g_strfreev (resolution);
-            break;
+          break;
+        }
+        case HLS_PARAM_RESOLUTION:{
+          gchar **resolution = g_strsplit (str, "x", 3);
+          if (resolution[0] && resolution[1]) {
+            g_debug ("HLS stream width: %s, height: %s", resolution[0], resolution[1]);
+            gtuber_stream_set_width (bstream, g_ascii_strtoull (resolution[0], NULL, 10));
+            gtuber_stream_set_height (bstream, g_ascii_strtoull (resolution[1], NULL, 10));
           }
-          case HLS_PARAM_FRAME_RATE:{
-            guint fps = round (g_ascii_strtod (str, NULL));
-            g_debug ("HLS stream fps: %i", fps);
-            gtuber_stream_set_fps (bstream, fps);
-            break;
+          g_strfreev (resolution);
+          break;
+        }
+        case HLS_PARAM_FRAME_RATE:{
+          guint fps = round (g_ascii_strtod (str, NULL));
+          g_debug ("HLS stream fps: %i", fps);
+          gtuber_stream_set_fps (bstream, fps);
+          break;
+        }
+        case HLS_PARAM_CODECS:
+          if (!get_is_audio_codec (str)) {
+            g_debug ("HLS stream video codec: %s", str);
+            gtuber_stream_set_video_codec (bstream, str);
+          } else {
+            g_debug ("HLS stream audio codec: %s", str);
+            gtuber_stream_set_audio_codec (bstream, str);
           }
-          case HLS_PARAM_CODECS:
-            if (!get_is_audio_codec (str)) {
-              g_debug ("HLS stream video codec: %s", str);
-              gtuber_stream_set_video_codec (bstream, str);
-            } else {
-              g_debug ("HLS stream audio codec: %s", str);
-              gtuber_stream_set_audio_codec (bstream, str);
-            }
-            break;
-          case HLS_PARAM_URI:
-            g_free (line);
-            line = g_strdup (str);
-            break;
-          case HLS_PARAM_GROUP_ID:
-          case HLS_PARAM_AUDIO:{
-            if (group_itag == 0)
-              group_itag = g_str_hash (str);
-            if (last == HLS_PARAM_GROUP_ID) {
-              g_debug ("Replaced itag from GROUP-ID: %u", group_itag);
-              gtuber_stream_set_itag (bstream, group_itag);
-            }
-            break;
+          break;
+        case HLS_PARAM_URI:
+          g_free (line);
+          line = g_strdup (str);
+          break;
+        case HLS_PARAM_GROUP_ID:
+        case HLS_PARAM_AUDIO:{
+          if (group_itag == 0)
+            group_itag = g_str_hash (str);
+          if (last == HLS_PARAM_GROUP_ID) {
+            g_debug ("Replaced itag from GROUP-ID: %u", group_itag);
+            gtuber_stream_set_itag (bstream, group_itag);
           }
-          default:
-            break;
+          break;
         }
-        i++;
+        default:
+          break;
       }
-      g_strfreev (params);
+      i++;
+    }
+    g_strfreev (params);
 
-      /* Move audio codec from video-only to audio-only stream */
-      if (group_itag > 0
-          && gtuber_stream_get_video_codec (bstream) != NULL
-          && gtuber_stream_get_audio_codec (bstream) != NULL) {
-        GPtrArray *astreams;
-        guint j;
+    /* Move audio codec from video-only to audio-only stream */
+    if (group_itag > 0
+        && gtuber_stream_get_video_codec (bstream) != NULL
+        && gtuber_stream_get_audio_codec (bstream) != NULL) {
+      GPtrArray *astreams;
+      guint j;
 
-        astreams = gtuber_media_info_get_adaptive_streams (info);
+      astreams = gtuber_media_info_get_adaptive_streams (info);
 
-        for (j = 0; j < astreams->len; j++) {
-          GtuberAdaptiveStream *tmp_astream;
-          GtuberAdaptiveStreamManifest manifest_type;
+      for (j = 0; j < astreams->len; j++) {
+        GtuberAdaptiveStream *tmp_astream;
+        GtuberAdaptiveStreamManifest manifest_type;
 
-          tmp_astream = g_ptr_array_index (astreams, j);
-          manifest_type = gtuber_adaptive_stream_get_manifest_type (tmp_astream);
+        tmp_astream = g_ptr_array_index (astreams, j);
+        manifest_type = gtuber_adaptive_stream_get_manifest_type (tmp_astream);
 
-          /* We might already have some non-HLS adaptive streams
-           * added by website plugin, make sure to update HLS only */
-          if (manifest_type != GTUBER_ADAPTIVE_STREAM_MANIFEST_HLS
-              || gtuber_stream_get_itag ((GtuberStream *) tmp_astream) != group_itag)
-            continue;
+        /* We might already have some non-HLS adaptive streams
+         * added by website plugin, make sure to update HLS only */
+        if (manifest_type != GTUBER_ADAPTIVE_STREAM_MANIFEST_HLS
+            || gtuber_stream_get_itag ((GtuberStream *) tmp_astream) != group_itag)
+          continue;
 
-          gtuber_stream_set_audio_codec ((GtuberStream *) tmp_astream,
-              gtuber_stream_get_audio_codec (bstream));
-          gtuber_stream_set_audio_codec (bstream, NULL);
-        }
+        gtuber_stream_set_audio_codec ((GtuberStream *) tmp_astream,
+            gtuber_stream_get_audio_codec (bstream));
+        gtuber_stream_set_audio_codec (bstream, NULL);
       }
     }
-    if (astream && !g_str_has_prefix (line, "#")) {
-      gboolean duplicate = FALSE;
+  }
+  if (parser->astream && !g_str_has_prefix (line, "#")) {
+    gboolean duplicate = FALSE;
 
-      if (base_uri) {
-        gchar *full_uri;
+    if (parser->base_uri) {
+      gchar *full_uri;
 
-        if (!g_uri_is_valid (line, G_URI_FLAGS_ENCODED, NULL)) {
-          full_uri = g_uri_resolve_relative (base_uri, line,
-              G_URI_FLAGS_ENCODED, NULL);
-        } else {
-          full_uri = gtuber_utils_common_replace_uri_source (line, base_uri);
-        }
-        g_debug ("Resolved URI: %s", full_uri);
+      if (!g_uri_is_valid (line, G_URI_FLAGS_ENCODED, NULL)) {
+        full_uri = g_uri_resolve_relative (parser->base_uri, line,
+            G_URI_FLAGS_ENCODED, NULL);
+      } else {
+        full_uri = gtuber_utils_common_replace_uri_source (line, parser->base_uri);
+      }
+      g_debug ("Resolved URI: %s", full_uri);
 
-        if (full_uri) {
-          g_free (line);
-          line = full_uri;
-        }
+      if (full_uri) {
+        g_free (line);
+        line = full_uri;
       }
+    }
 
-      /* HLS streams with seperate audio might have URI duplicates,
-       * due to possible multiple video+audio combinations.
-       * Lets simply drop them, so they will not appear twice */
-      if (!gtuber_stream_get_audio_codec ((GtuberStream *) astream)) {
-        GPtrArray *astreams;
-        guint j;
+    /* HLS streams with seperate audio might have URI duplicates,
+     * due to possible multiple video+audio combinations.
+     * Lets simply drop them, so they will not appear twice */
+    if (!gtuber_stream_get_audio_codec ((GtuberStream *) parser->astream)) {
+      GPtrArray *astreams;
+      guint j;
 
-        g_debug ("Checking for duplicated URIs...");
-        astreams = gtuber_media_info_get_adaptive_streams (info);
+      g_debug ("Checking for duplicated URIs...");
+      astreams = gtuber_media_info_get_adaptive_streams (info);
 
-        for (j = 0; j < astreams->len; j++) {
-          GtuberStream *tmp_stream;
-          const gchar *present_uri;
+      for (j = 0; j < astreams->len; j++) {
+        GtuberStream *tmp_stream;
+        const gchar *present_uri;
 
-          tmp_stream = (GtuberStream *) g_ptr_array_index (astreams, j);
-          present_uri = gtuber_stream_get_uri (tmp_stream);
+        tmp_stream = (GtuberStream *) g_ptr_array_index (astreams, j);
+        present_uri = gtuber_stream_get_uri (tmp_stream);
 
-          if ((duplicate = strcmp (present_uri, line) == 0))
-            break;
-        }
-        g_debug ("Duplicated URIs found: %s", duplicate ? "yes" : "no");
+        if ((duplicate = strcmp (present_uri, line) == 0))
+          break;
       }
+      g_debug ("Duplicated URIs found: %s", duplicate ? "yes" : "no");
+    }
 
-      g_debug ("%s adaptive stream, itag: %u",
-          duplicate ? "Dropped duplicated" : "Added",
-          gtuber_stream_get_itag ((GtuberStream *) astream));
+    g_debug ("%s adaptive stream, itag: %u",
+        duplicate ? "Dropped duplicated" : "Added",
+        gtuber_stream_get_itag ((GtuberStream *) parser->astream));
 
-      if (!duplicate) {
-        gtuber_stream_set_uri ((GtuberStream *) astream, line);
-        g_debug ("HLS stream URI: %s", line);
+    if (!duplicate) {
+      gtuber_stream_set_uri ((GtuberStream *) parser->astream, line);
+      g_debug ("HLS stream URI: %s", line);
 
-        gtuber_media_info_add_adaptive_stream (info, astream);
-      } else {
-        g_object_unref (astream);
-      }
+      gtuber_media_info_add_adaptive_stream (info, parser->astream);
+    } else {
+      g_object_unref (parser->astream);
+    }
+
+    parser->astream = NULL;
+    parser->success = TRUE;
+
+    parser->itag++;
+  }
+  g_free (line);
+}
+
+static void
+_hls_parser_take_pending_line (GtuberUtilsCommonHlsParser *parser)
+{
+  GString *pending = parser->pending;
+
+  if (pending->len > 0 && pending->str[pending->len - 1] == '\r')
+    g_string_truncate (pending, pending->len - 1);
 
-      astream = NULL;
-      success = TRUE;
+  _hls_parser_read_line (parser, g_strndup (pending->str, pending->len));
+  g_string_truncate (pending, 0);
+}
+
+/**
+ * gtuber_utils_common_hls_parser_new:
+ * @info: a #GtuberMediaInfo
+ * @base_uri: (nullable): base URI to resolve relative stream URIs with
+ *
+ * Creates a new push parser that fills #GtuberMediaInfo with
+ *   #GtuberAdaptiveStream(s) from HLS manifest data as it arrives.
+ *
+ * Returns: (transfer full): a new #GtuberUtilsCommonHlsParser.
+ */
+GtuberUtilsCommonHlsParser *
+gtuber_utils_common_hls_parser_new (GtuberMediaInfo *info, const gchar *base_uri)
+{
+  GtuberUtilsCommonHlsParser *parser;
+
+  parser = g_new0 (GtuberUtilsCommonHlsParser, 1);
+  parser->info = g_object_ref (info);
+  parser->base_uri = g_strdup (base_uri);
+  parser->pending = g_string_new (NULL);
+  parser->itag = 1;
+
+  g_debug ("Parsing HLS...");
+
+  return parser;
+}
 
-      itag++;
+/**
+ * gtuber_utils_common_hls_parser_push_data:
+ * @parser: a #GtuberUtilsCommonHlsParser
+ * @data: next chunk of HLS manifest
+ * @size: size of @data
+ *
+ * Parses all complete lines from @data. Incomplete line at the end
+ *   is kept until the rest of it is pushed.
+ */
+void
+gtuber_utils_common_hls_parser_push_data (GtuberUtilsCommonHlsParser *parser,
+    const gchar *data, gsize size)
+{
+  const gchar *end = data + size;
+
+  while (data < end) {
+    const gchar *line_end;
+
+    if (!(line_end = memchr (data, '\n', end - data))) {
+      g_string_append_len (parser->pending, data, end - data);
+      break;
     }
-    g_free (line);
+
+    g_string_append_len (parser->pending, data, line_end - data);
+    _hls_parser_take_pending_line (parser);
+
+    data = line_end + 1;
   }
-  g_debug ("HLS parsing %ssuccessful", success ? "" : "un");
+}
 
-  /* When stream not added */
-  if (astream)
-    g_object_unref (astream);
+/**
+ * gtuber_utils_common_hls_parser_finish:
+ * @parser: a #GtuberUtilsCommonHlsParser
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * Parses remaining data after all of it was pushed.
+ *
+ * Returns: %TRUE if info was successfully updated, %FALSE otherwise.
+ */
+gboolean
+gtuber_utils_common_hls_parser_finish (GtuberUtilsCommonHlsParser *parser,
+    GError **error)
+{
+  if (parser->pending->len > 0)
+    _hls_parser_take_pending_line (parser);
 
-  g_object_unref (dstream);
+  g_debug ("HLS parsing %ssuccessful", parser->success ? "" : "un");
 
-  if (!success && *error == NULL) {
+  if (!parser->success) {
     g_set_error (error, GTUBER_WEBSITE_ERROR,
         GTUBER_WEBSITE_ERROR_PARSE_FAILED,
         "Could not extract adaptive streams from HLS");
   }
 
+  return parser->success;
+}
+
+/**
+ * gtuber_utils_common_hls_parser_free:
+ * @parser: a #GtuberUtilsCommonHlsParser
+ *
+ * Frees @parser. Can be called at any time, also when not all
+ *   data was pushed into it (e.g. due to a read error).
+ */
+void
+gtuber_utils_common_hls_parser_free (GtuberUtilsCommonHlsParser *parser)
+{
+  /* When stream not added */
+  if (parser->astream)
+    g_object_unref (parser->astream);
+
+  g_object_unref (parser->info);
+  g_free (parser->base_uri);
+  g_string_free (parser->pending, TRUE);
+
+  g_free (parser);
+}
+
+gboolean
+gtuber_utils_common_parse_hls_input_stream_with_base_uri (GInputStream *stream,
+    GtuberMediaInfo *info, const gchar *base_uri, GError **error)
+{
+  GtuberUtilsCommonHlsParser *parser;
+  gchar *buf;
+  gssize n_read;
+  gboolean success = FALSE;
+
+  parser = gtuber_utils_common_hls_parser_new (info, base_uri);
+  buf = g_malloc (HLS_CHUNK_SIZE);
+
+  while ((n_read = g_input_stream_read (stream, buf, HLS_CHUNK_SIZE, NULL, error)) > 0)
+    gtuber_utils_common_hls_parser_push_data (parser, buf, n_read);
+
+  if (n_read == 0)
+    success = gtuber_utils_common_hls_parser_finish (parser, error);
+
+  g_free (buf);
+  gtuber_utils_common_hls_parser_free (parser);
+
   return success;
 }
+
+#define DASH_CHUNK_SIZE 8192
+
+typedef enum
+{
+  DASH_LEVEL_MPD,
+  DASH_LEVEL_PERIOD,
+  DASH_LEVEL_ADAPTATION_SET,
+  DASH_LEVEL_REPRESENTATION,
+  DASH_N_LEVELS,
+} DashLevelType;
+
+/* Values inherited by child elements */
+typedef struct
+{
+  gchar *base_uri;
+  gchar *mime_type;
+  gchar *codecs;
+
+  guint width;
+  guint height;
+  guint fps;
+  guint bitrate;
+
+  guint64 init_start;
+  guint64 init_end;
+  guint64 index_start;
+  guint64 index_end;
+
+  gboolean has_base_url;
+  gboolean has_init;
+  gboolean has_index;
+  gboolean has_template;
+} DashLevel;
+
+struct _GtuberUtilsCommonDashParser
+{
+  GtuberMediaInfo *info;
+  GMarkupParseContext *context;
+
+  DashLevel levels[DASH_N_LEVELS];
+  gint level;
+
+  GString *text;
+  gboolean in_base_url;
+
+  guint itag;
+  gboolean success;
+};
+
+static void
+_dash_level_clear (DashLevel *level)
+{
+  g_free (level->base_uri);
+  g_free (level->mime_type);
+  g_free (level->codecs);
+
+  memset (level, 0, sizeof (DashLevel));
+}
+
+static void
+_dash_level_copy (DashLevel *dest, const DashLevel *src)
+{
+  *dest = *src;
+
+  dest->base_uri = g_strdup (src->base_uri);
+  dest->mime_type = g_strdup (src->mime_type);
+  dest->codecs = g_strdup (src->codecs);
+}
+
+static gboolean
+_dash_parse_range (const gchar *range, guint64 *start, guint64 *end)
+{
+  gchar *endptr = NULL;
+
+  *start = g_ascii_strtoull (range, &endptr, 10);
+  if (!endptr || *endptr != '-')
+    return FALSE;
+
+  *end = g_ascii_strtoull (endptr + 1, NULL, 10);
+
+  return (*end >= *start);
+}
+
+static guint
+_dash_parse_frame_rate (const gchar *frame_rate)
+{
+  gchar *endptr = NULL;
+  gdouble fps;
+
+  fps = g_ascii_strtod (frame_rate, &endptr);
+  if (endptr && *endptr == '/') {
+    gdouble den = g_ascii_strtod (endptr + 1, NULL);
+    fps = (den > 0) ? fps / den : 0;
+  }
+
+  return (guint) round (fps);
+}
+
+/* Supports "PT#H#M#S" durations used in MPDs */
+static guint
+_dash_parse_duration (const gchar *duration)
+{
+  const gchar *ptr;
+  gdouble total = 0;
+
+  if (!(ptr = strchr (duration, 'T')))
+    return 0;
+
+  ptr++;
+  while (*ptr) {
+    gchar *endptr = NULL;
+    gdouble value;
+
+    value = g_ascii_strtod (ptr, &endptr);
+    if (!endptr || endptr == ptr)
+      break;
+
+    switch (*endptr) {
+      case 'H':
+        total += value * 3600;
+        break;
+      case 'M':
+        total += value * 60;
+        break;
+      case 'S':
+        total += value;
+        break;
+      default:
+        return 0;
+    }
+    ptr = endptr + 1;
+  }
+
+  return (guint) total;
+}
+
+static const gchar *
+_dash_local_name (const gchar *element_name)
+{
+  const gchar *local_name = strchr (element_name, ':');
+
+  return (local_name) ? local_name + 1 : element_name;
+}
+
+static void
+_dash_read_stream_attributes (DashLevel *level,
+    const gchar **attribute_names, const gchar **attribute_values)
+{
+  guint i;
+
+  for (i = 0; attribute_names[i]; i++) {
+    const gchar *name = attribute_names[i];
+    const gchar *value = attribute_values[i];
+
+    if (!strcmp (name, "mimeType")) {
+      g_free (level->mime_type);
+      level->mime_type = g_strdup (value);
+    } else if (!strcmp (name, "codecs")) {
+      g_free (level->codecs);
+      level->codecs = g_strdup (value);
+    } else if (!strcmp (name, "width")) {
+      level->width = g_ascii_strtoull (value, NULL, 10);
+    } else if (!strcmp (name, "height")) {
+      level->height = g_ascii_strtoull (value, NULL, 10);
+    } else if (!strcmp (name, "frameRate")) {
+      level->fps = _dash_parse_frame_rate (value);
+    } else if (!strcmp (name, "bandwidth")) {
+      level->bitrate = g_ascii_strtoull (value, NULL, 10);
+    }
+  }
+}
+
+static gboolean
+_dash_add_stream (GtuberUtilsCommonDashParser *parser, DashLevel *level,
+    GError **error)
+{
+  GtuberAdaptiveStream *astream;
+  GtuberStream *stream;
+
+  /* We can only describe streams with single media URI, skipping
+   * others would leave caller with incomplete list of streams */
+  if (level->has_template) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_PARSE_FAILED,
+        "DASH representation uses unsupported segment addressing");
+    return FALSE;
+  }
+  if (!level->has_base_url) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_PARSE_FAILED,
+        "DASH representation is missing media URI");
+    return FALSE;
+  }
+
+  astream = gtuber_adaptive_stream_new ();
+  stream = GTUBER_STREAM (astream);
+
+  gtuber_adaptive_stream_set_manifest_type (astream, GTUBER_ADAPTIVE_STREAM_MANIFEST_DASH);
+
+  gtuber_stream_set_itag (stream, parser->itag);
+  gtuber_stream_set_uri (stream, level->base_uri);
+  g_debug ("DASH stream URI: %s", level->base_uri);
+
+  if (level->mime_type) {
+    gtuber_stream_set_mime_type (stream,
+        gtuber_utils_common_get_mime_type_from_string (level->mime_type));
+  }
+
+  if (level->codecs) {
+    gchar **codecs;
+    guint i;
+
+    codecs = g_strsplit (level->codecs, ",", 0);
+    for (i = 0; codecs[i]; i++) {
+      gchar *codec = g_strstrip (codecs[i]);
+
+      if (get_is_audio_codec (codec))
+        gtuber_stream_set_audio_codec (stream, codec);
+      else
+        gtuber_stream_set_video_codec (stream, codec);
+    }
+    g_strfreev (codecs);
+  }
+
+  gtuber_stream_set_width (stream, level->width);
+  gtuber_stream_set_height (stream, level->height);
+  gtuber_stream_set_fps (stream, level->fps);
+  gtuber_stream_set_bitrate (stream, level->bitrate);
+
+  if (level->has_init)
+    gtuber_adaptive_stream_set_init_range (astream, level->init_start, level->init_end);
+  if (level->has_index)
+    gtuber_adaptive_stream_set_index_range (astream, level->index_start, level->index_end);
+
+  g_debug ("Added adaptive stream, itag: %u", parser->itag);
+  gtuber_media_info_add_adaptive_stream (parser->info, astream);
+
+  parser->itag++;
+  parser->success = TRUE;
+
+  return TRUE;
+}
+
+static void
+_dash_start_element (GMarkupParseContext *context, const gchar *element_name,
+    const gchar **attribute_names, const gchar **attribute_values,
+    gpointer user_data, GError **error)
+{
+  GtuberUtilsCommonDashParser *parser = user_data;
+  const gchar *name = _dash_local_name (element_name);
+  DashLevel *level;
+  guint i;
+
+  if (!strcmp (name, "MPD")) {
+    if (parser->level >= DASH_LEVEL_MPD)
+      return;
+
+    parser->level = DASH_LEVEL_MPD;
+
+    for (i = 0; attribute_names[i]; i++) {
+      if (!strcmp (attribute_names[i], "mediaPresentationDuration")
+          && gtuber_media_info_get_duration (parser->info) == 0) {
+        gtuber_media_info_set_duration (parser->info,
+            _dash_parse_duration (attribute_values[i]));
+      }
+    }
+    return;
+  }
+
+  /* Ignore everything outside of MPD element */
+  if (parser->level < DASH_LEVEL_MPD)
+    return;
+
+  if ((!strcmp (name, "Period") && parser->level == DASH_LEVEL_MPD)
+      || (!strcmp (name, "AdaptationSet") && parser->level == DASH_LEVEL_PERIOD)
+      || (!strcmp (name, "Representation") && parser->level == DASH_LEVEL_ADAPTATION_SET)) {
+    _dash_level_copy (&parser->levels[parser->level + 1], &parser->levels[parser->level]);
+    parser->level++;
+
+    _dash_read_stream_attributes (&parser->levels[parser->level],
+        attribute_names, attribute_values);
+    return;
+  }
+
+  level = &parser->levels[parser->level];
+
+  if (!strcmp (name, "BaseURL")) {
+    parser->in_base_url = TRUE;
+    g_string_truncate (parser->text, 0);
+  } else if (!strcmp (name, "SegmentBase")) {
+    for (i = 0; attribute_names[i]; i++) {
+      if (!strcmp (attribute_names[i], "indexRange")) {
+        level->has_index = _dash_parse_range (attribute_values[i],
+            &level->index_start, &level->index_end);
+      }
+    }
+  } else if (!strcmp (name, "Initialization")) {
+    for (i = 0; attribute_names[i]; i++) {
+      if (!strcmp (attribute_names[i], "range")) {
+        level->has_init = _dash_parse_range (attribute_values[i],
+            &level->init_start, &level->init_end);
+      }
+    }
+  } else if (!strcmp (name, "SegmentTemplate") || !strcmp (name, "SegmentList")) {
+    level->has_template = TRUE;
+  }
+}
+
+static void
+_dash_end_element (GMarkupParseContext *context, const gchar *element_name,
+    gpointer user_data, GError **error)
+{
+  GtuberUtilsCommonDashParser *parser = user_data;
+  const gchar *name = _dash_local_name (element_name);
+  DashLevel *level;
+
+  if (parser->level < DASH_LEVEL_MPD)
+    return;
+
+  level = &parser->levels[parser->level];
+
+  if (!strcmp (name, "BaseURL") && parser->in_base_url) {
+    gchar *text, *full_uri = NULL;
+
+    parser->in_base_url = FALSE;
+    text = g_strstrip (parser->text->str);
+
+    /* BaseURL is relative to the one inherited from parent element */
+    if (level->base_uri)
+      full_uri = g_uri_resolve_relative (level->base_uri, text, G_URI_FLAGS_ENCODED, NULL);
+    if (!full_uri)
+      full_uri = g_strdup (text);
+
+    g_free (level->base_uri);
+    level->base_uri = full_uri;
+    level->has_base_url = TRUE;
+  } else if ((!strcmp (name, "Representation") && parser->level == DASH_LEVEL_REPRESENTATION)
+      || (!strcmp (name, "AdaptationSet") && parser->level == DASH_LEVEL_ADAPTATION_SET)
+      || (!strcmp (name, "Period") && parser->level == DASH_LEVEL_PERIOD)) {
+    if (parser->level == DASH_LEVEL_REPRESENTATION
+        && !_dash_add_stream (parser, level, error))
+      return;
+
+    _dash_level_clear (level);
+    parser->level--;
+  } else if (!strcmp (name, "MPD") && parser->level == DASH_LEVEL_MPD) {
+    /* Keep base URI for possible next MPD element */
+    parser->level = -1;
+  }
+}
+
+static void
+_dash_text (GMarkupParseContext *context, const gchar *text, gsize text_len,
+    gpointer user_data, GError **error)
+{
+  GtuberUtilsCommonDashParser *parser = user_data;
+
+  if (parser->in_base_url)
+    g_string_append_len (parser->text, text, text_len);
+}
+
+static const GMarkupParser dash_markup_parser = {
+  _dash_start_element,
+  _dash_end_element,
+  _dash_text,
+  NULL,
+  NULL
+};
+
+/**
+ * gtuber_utils_common_dash_parser_new:
+ * @info: a #GtuberMediaInfo
+ * @base_uri: (nullable): URI of the manifest to resolve relative stream URIs with
+ *
+ * Creates a new push parser that fills #GtuberMediaInfo with
+ *   #GtuberAdaptiveStream(s) from DASH manifest data as it arrives.
+ *
+ * Only representations addressed with a single media URI (`BaseURL`
+ *   with optional `SegmentBase`) are supported. Parsing fails on any
+ *   other (`SegmentTemplate` or `SegmentList`), as streams added until
+ *   then would not be the complete list.
+ *
+ * Returns: (transfer full): a new #GtuberUtilsCommonDashParser.
+ */
+GtuberUtilsCommonDashParser *
+gtuber_utils_common_dash_parser_new (GtuberMediaInfo *info, const gchar *base_uri)
+{
+  GtuberUtilsCommonDashParser *parser;
+
+  parser = g_new0 (GtuberUtilsCommonDashParser, 1);
+  parser->info = g_object_ref (info);
+  parser->context = g_markup_parse_context_new (&dash_markup_parser,
+      0, parser, NULL);
+  parser->levels[DASH_LEVEL_MPD].base_uri = g_strdup (base_uri);
+  parser->level = -1;
+  parser->text = g_string_new (NULL);
+  parser->itag = 1;
+
+  g_debug ("Parsing DASH...");
+
+  return parser;
+}
+
+/**
+ * gtuber_utils_common_dash_parser_push_data:
+ * @parser: a #GtuberUtilsCommonDashParser
+ * @data: next chunk of DASH manifest
+ * @size: size of @data
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * Returns: %TRUE if data was parsed, %FALSE on invalid XML.
+ */
+gboolean
+gtuber_utils_common_dash_parser_push_data (GtuberUtilsCommonDashParser *parser,
+    const gchar *data, gsize size, GError **error)
+{
+  return g_markup_parse_context_parse (parser->context, data, size, error);
+}
+
+/**
+ * gtuber_utils_common_dash_parser_finish:
+ * @parser: a #GtuberUtilsCommonDashParser
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * Returns: %TRUE if info was successfully updated, %FALSE otherwise.
+ */
+gboolean
+gtuber_utils_common_dash_parser_finish (GtuberUtilsCommonDashParser *parser,
+    GError **error)
+{
+  if (!g_markup_parse_context_end_parse (parser->context, error))
+    return FALSE;
+
+  g_debug ("DASH parsing %ssuccessful", parser->success ? "" : "un");
+
+  if (!parser->success) {
+    g_set_error (error, GTUBER_WEBSITE_ERROR,
+        GTUBER_WEBSITE_ERROR_PARSE_FAILED,
+        "Could not extract adaptive streams from DASH");
+  }
+
+  return parser->success;
+}
+
+void
+gtuber_utils_common_dash_parser_free (GtuberUtilsCommonDashParser *parser)
+{
+  guint i;
+
+  for (i = 0; i < DASH_N_LEVELS; i++)
+    _dash_level_clear (&parser->levels[i]);
+
+  g_markup_parse_context_free (parser->context);
+  g_object_unref (parser->info);
+  g_string_free (parser->text, TRUE);
+
+  g_free (parser);
+}
+
+/**
+ * gtuber_utils_common_parse_dash_input_stream:
+ * @stream: a #GInputStream
+ * @info: a #GtuberMediaInfo
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * A convenience function that reads #GInputStream pointing to DASH manifest
+ *   and fills #GtuberMediaInfo with #GtuberAdaptiveStream(s) from it.
+ *
+ * Returns: %TRUE if info was successfully updated, %FALSE otherwise.
+ */
+gboolean
+gtuber_utils_common_parse_dash_input_stream (GInputStream *stream,
+    GtuberMediaInfo *info, GError **error)
+{
+  return gtuber_utils_common_parse_dash_input_stream_with_base_uri (stream, info, NULL, error);
+}
+
+gboolean
+gtuber_utils_common_parse_dash_input_stream_with_base_uri (GInputStream *stream,
+    GtuberMediaInfo *info, const gchar *base_uri, GError **error)
+{
+  GtuberUtilsCommonDashParser *parser;
+  gchar *buf;
+  gssize n_read;
+  gboolean success = FALSE;
+
+  parser = gtuber_utils_common_dash_parser_new (info, base_uri);
+  buf = g_malloc (DASH_CHUNK_SIZE);
+
+  while ((n_read = g_input_stream_read (stream, buf, DASH_CHUNK_SIZE, NULL, error)) > 0) {
+    if (!gtuber_utils_common_dash_parser_push_data (parser, buf, n_read, error)) {
+      n_read = -1;
+      break;
+    }
+  }
+
+  if (n_read == 0)
+    success = gtuber_utils_common_dash_parser_finish (parser, error);
+
+  g_free (buf);
+  gtuber_utils_common_dash_parser_free (parser);
+
+  return success;
+}
+
+/* Instances health smoothing factor and expiration (7 days) */
+#define INSTANCE_HEALTH_ALPHA 0.3
+#define INSTANCE_HEALTH_EXP (7 * 24 * 3600)
+
+/* Assumed health of instances without any history */
+#define INSTANCE_DEFAULT_RTT_MS 1000.0
+#define INSTANCE_DEFAULT_SUCCESS 0.9
+
+/* Success rate below which first (requested) instance loses its priority */
+#define INSTANCE_PREFERRED_MIN_SUCCESS 0.5
+
+typedef struct
+{
+  gchar *name;
+  gdouble rtt_ms;
+  gdouble success;
+  gboolean known;
+  gboolean tried;
+} InstanceHealth;
+
+struct _GtuberUtilsCommonInstancePool
+{
+  gchar *plugin_name;
+  GPtrArray *instances;
+
+  InstanceHealth *current;
+  gint64 request_start;
+};
+
+static void
+_instance_health_free (InstanceHealth *health)
+{
+  g_free (health->name);
+  g_free (health);
+}
+
+static gchar *
+_instance_health_cache_key (const gchar *name)
+{
+  return g_strjoin (".", "instance_health", name, NULL);
+}
+
+static void
+_instance_health_load (InstanceHealth *health, const gchar *plugin_name)
+{
+  gchar *key, *value;
+
+  health->rtt_ms = INSTANCE_DEFAULT_RTT_MS;
+  health->success = INSTANCE_DEFAULT_SUCCESS;
+
+  key = _instance_health_cache_key (health->name);
+  value = gtuber_cache_plugin_read (plugin_name, key);
+  g_free (key);
+
+  if (value) {
+    gchar **parts = g_strsplit (value, " ", 2);
+
+    if (parts[0] && parts[1]) {
+      health->rtt_ms = g_ascii_strtod (parts[0], NULL);
+      health->success = CLAMP (g_ascii_strtod (parts[1], NULL), 0.0, 1.0);
+      health->known = TRUE;
+    }
+
+    g_strfreev (parts);
+    g_free (value);
+  }
+
+  g_debug ("Instance %s, RTT: %.0f ms, success rate: %.2f%s",
+      health->name, health->rtt_ms, health->success,
+      health->known ? "" : " (default)");
+}
+
+static void
+_instance_health_save (InstanceHealth *health, const gchar *plugin_name)
+{
+  gchar *key, *value;
+  gchar rtt_str[G_ASCII_DTOSTR_BUF_SIZE];
+  gchar success_str[G_ASCII_DTOSTR_BUF_SIZE];
+
+  g_ascii_formatd (rtt_str, sizeof (rtt_str), "%.0f", health->rtt_ms);
+  g_ascii_formatd (success_str, sizeof (success_str), "%.3f", health->success);
+
+  key = _instance_health_cache_key (health->name);
+  value = g_strjoin (" ", rtt_str, success_str, NULL);
+
+  gtuber_cache_plugin_write (plugin_name, key, value, INSTANCE_HEALTH_EXP);
+
+  g_free (key);
+  g_free (value);
+}
+
+/* Lower is better, slow instances that work are preferred
+ * over fast ones that fail most of the time */
+static gdouble
+_instance_health_get_score (InstanceHealth *health)
+{
+  return health->rtt_ms / MAX (health->success, 0.01);
+}
+
+/**
+ * gtuber_utils_common_instance_pool_new:
+ * @plugin_name: name of the plugin used for caching instances health
+ * @instances: %NULL terminated list of interchangeable instances
+ *   in order of preference
+ *
+ * Creates a pool that picks instance for the next request and allows
+ *   failing over to the next one. The first instance (e.g. the one user
+ *   requested) is always tried first, unless it has been failing lately.
+ *   Otherwise the fastest healthy instance is picked. Learned health of
+ *   each instance is kept in plugin cache.
+ *
+ * Returns: (transfer full): a new #GtuberUtilsCommonInstancePool.
+ */
+GtuberUtilsCommonInstancePool *
+gtuber_utils_common_instance_pool_new (const gchar *plugin_name,
+    const gchar *const *instances)
+{
+  GtuberUtilsCommonInstancePool *pool;
+  guint i;
+
+  pool = g_new0 (GtuberUtilsCommonInstancePool, 1);
+  pool->plugin_name = g_strdup (plugin_name);
+  pool->instances = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) _instance_health_free);
+
+  for (i = 0; instances && instances[i]; i++) {
+    InstanceHealth *health;
+    guint j;
+    gboolean duplicate = FALSE;
+
+    for (j = 0; j < pool->instances->len; j++) {
+      health = g_ptr_array_index (pool->instances, j);
+
+      if ((duplicate = !strcmp (health->name, instances[i])))
+        break;
+    }
+    if (duplicate)
+      continue;
+
+    health = g_new0 (InstanceHealth, 1);
+    health->name = g_strdup (instances[i]);
+    _instance_health_load (health, plugin_name);
+
+    g_ptr_array_add (pool->instances, health);
+  }
+
+  return pool;
+}
+
+/**
+ * gtuber_utils_common_instance_pool_start_request:
+ * @pool: a #GtuberUtilsCommonInstancePool
+ *
+ * Picks instance for the next request and starts measuring its RTT.
+ *   Once picked instance stays the same until its failure is reported.
+ *
+ * Returns: (transfer none) (nullable): name of instance to use or %NULL
+ *   when all instances already failed.
+ */
+const gchar *
+gtuber_utils_common_instance_pool_start_request (GtuberUtilsCommonInstancePool *pool)
+{
+  if (!pool->current) {
+    InstanceHealth *preferred = NULL;
+    gdouble best_score = G_MAXDOUBLE;
+    guint i;
+
+    if (pool->instances->len > 0)
+      preferred = g_ptr_array_index (pool->instances, 0);
+
+    if (preferred && !preferred->tried
+        && preferred->success >= INSTANCE_PREFERRED_MIN_SUCCESS) {
+      pool->current = preferred;
+    } else {
+      for (i = 0; i < pool->instances->len; i++) {
+        InstanceHealth *health = g_ptr_array_index (pool->instances, i);
+        gdouble score;
+
+        if (health->tried)
+          continue;
+
+        /* On equal score keep order of preference */
+        if ((score = _instance_health_get_score (health)) < best_score) {
+          best_score = score;
+          pool->current = health;
+        }
+      }
+    }
+
+    if (!pool->current)
+      return NULL;
+
+    pool->current->tried = TRUE;
+    g_debug ("Picked instance: %s", pool->current->name);
+  }
+
+  pool->request_start = g_get_monotonic_time ();
+
+  return pool->current->name;
+}
+
+/**
+ * gtuber_utils_common_instance_pool_report_success:
+ * @pool: a #GtuberUtilsCommonInstancePool
+ *
+ * Reports that current instance responded correctly.
+ */
+void
+gtuber_utils_common_instance_pool_report_success (GtuberUtilsCommonInstancePool *pool)
+{
+  InstanceHealth *health = pool->current;
+  gdouble rtt_ms;
+
+  if (!health)
+    return;
+
+  rtt_ms = (g_get_monotonic_time () - pool->request_start) / 1000.0;
+
+  health->rtt_ms = (health->known)
+      ? (1.0 - INSTANCE_HEALTH_ALPHA) * health->rtt_ms + INSTANCE_HEALTH_ALPHA * rtt_ms
+      : rtt_ms;
+  health->success = (1.0 - INSTANCE_HEALTH_ALPHA) * health->success + INSTANCE_HEALTH_ALPHA;
+  health->known = TRUE;
+
+  g_debug ("Instance %s responded in %.0f ms", health->name, rtt_ms);
+  _instance_health_save (health, pool->plugin_name);
+}
+
+/**
+ * gtuber_utils_common_instance_pool_report_failure:
+ * @pool: a #GtuberUtilsCommonInstancePool
+ *
+ * Reports that current instance failed, so next request will use
+ *   a different one.
+ *
+ * Returns: %TRUE if there is still some other instance to try.
+ */
+gboolean
+gtuber_utils_common_instance_pool_report_failure (GtuberUtilsCommonInstancePool *pool)
+{
+  InstanceHealth *health = pool->current;
+  guint i;
+
+  if (health) {
+    health->success = (1.0 - INSTANCE_HEALTH_ALPHA) * health->success;
+    health->known = TRUE;
+
+    g_debug ("Instance %s failed", health->name);
+    _instance_health_save (health, pool->plugin_name);
+
+    pool->current = NULL;
+  }
+
+  for (i = 0; i < pool->instances->len; i++) {
+    health = g_ptr_array_index (pool->instances, i);
+
+    if (!health->tried)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+void
+gtuber_utils_common_instance_pool_free (GtuberUtilsCommonInstancePool *pool)
+{
+  g_free (pool->plugin_name);
+  g_ptr_array_unref (pool->instances);
+
+  g_free (pool);
+}
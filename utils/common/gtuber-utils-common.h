@@ -26,6 +26,10 @@
 
 G_BEGIN_DECLS
 
+typedef struct _GtuberUtilsCommonHlsParser GtuberUtilsCommonHlsParser;
+typedef struct _GtuberUtilsCommonDashParser GtuberUtilsCommonDashParser;
+typedef struct _GtuberUtilsCommonInstancePool GtuberUtilsCommonInstancePool;
+
 gboolean             gtuber_utils_common_uri_matches_hosts                    (GUri *uri, gint *match, const gchar *search_host, ...) G_GNUC_NULL_TERMINATED;
 
 gboolean             gtuber_utils_common_uri_matches_hosts_array              (GUri *uri, gint *match, const gchar *const *hosts);
@@ -52,4 +56,34 @@ gboolean             gtuber_utils_common_parse_hls_input_stream               (G
 
 gboolean             gtuber_utils_common_parse_hls_input_stream_with_base_uri (GInputStream *stream, GtuberMediaInfo *info, const gchar *base_uri, GError **error);
 
+GtuberUtilsCommonHlsParser * gtuber_utils_common_hls_parser_new              (GtuberMediaInfo *info, const gchar *base_uri);
+
+void                 gtuber_utils_common_hls_parser_push_data                 (GtuberUtilsCommonHlsParser *parser, const gchar *data, gsize size);
+
+gboolean             gtuber_utils_common_hls_parser_finish                    (GtuberUtilsCommonHlsParser *parser, GError **error);
+
+void                 gtuber_utils_common_hls_parser_free                      (GtuberUtilsCommonHlsParser *parser);
+
+gboolean             gtuber_utils_common_parse_dash_input_stream              (GInputStream *stream, GtuberMediaInfo *info, GError **error);
+
+gboolean             gtuber_utils_common_parse_dash_input_stream_with_base_uri (GInputStream *stream, GtuberMediaInfo *info, const gchar *base_uri, GError **error);
+
+GtuberUtilsCommonDashParser * gtuber_utils_common_dash_parser_new            (GtuberMediaInfo *info, const gchar *base_uri);
+
+gboolean             gtuber_utils_common_dash_parser_push_data                (GtuberUtilsCommonDashParser *parser, const gchar *data, gsize size, GError **error);
+
+gboolean             gtuber_utils_common_dash_parser_finish                   (GtuberUtilsCommonDashParser *parser, GError **error);
+
+void                 gtuber_utils_common_dash_parser_free                     (GtuberUtilsCommonDashParser *parser);
+
+GtuberUtilsCommonInstancePool * gtuber_utils_common_instance_pool_new        (const gchar *plugin_name, const gchar *const *instances);
+
+const gchar *        gtuber_utils_common_instance_pool_start_request          (GtuberUtilsCommonInstancePool *pool);
+
+void                 gtuber_utils_common_instance_pool_report_success         (GtuberUtilsCommonInstancePool *pool);
+
+gboolean             gtuber_utils_common_instance_pool_report_failure         (GtuberUtilsCommonInstancePool *pool);
+
+void                 gtuber_utils_common_instance_pool_free                   (GtuberUtilsCommonInstancePool *pool);
+
 G_END_DECLS
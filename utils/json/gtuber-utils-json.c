@@ -19,6 +19,28 @@
 
 #include "gtuber-utils-json.h"
 
+#define JSON_CHUNK_SIZE 16384
+
+typedef struct
+{
+  gchar *member;
+  guint index;
+} JsonPathElem;
+
+struct _GtuberUtilsJsonPath
+{
+  JsonPathElem *elems;
+  guint n_elems;
+};
+
+typedef struct
+{
+  const GtuberUtilsJsonField *fields;
+  guint n_fields;
+  gpointer dest;
+  guint n_found;
+} JsonProjectData;
+
 static inline GQuark
 _json_parser_get_quark (void)
 {
@@ -314,3 +336,1166 @@ gtuber_utils_json_parser_debug (JsonParser *parser)
   g_debug ("Parser data:\n%s", data);
   g_free (data);
 }
+
+static gboolean
+_json_node_holds_value_type (JsonNode *node, GType type)
+{
+  return (JSON_NODE_HOLDS_VALUE (node)
+      && json_node_get_value_type (node) == type);
+}
+
+static gboolean
+_json_node_read_int (JsonNode *node, gint64 *value)
+{
+  if (!JSON_NODE_HOLDS_VALUE (node))
+    return FALSE;
+
+  /* Some APIs send numbers as strings */
+  *value = (json_node_get_value_type (node) == G_TYPE_STRING)
+      ? g_ascii_strtoll (json_node_get_string (node), NULL, 10)
+      : json_node_get_int (node);
+
+  return TRUE;
+}
+
+static gboolean
+_json_node_read_field (JsonNode *node, GtuberUtilsJsonFieldType type, gpointer dest)
+{
+  switch (type) {
+    case GTUBER_UTILS_JSON_FIELD_STRING:
+      if (!_json_node_holds_value_type (node, G_TYPE_STRING))
+        return FALSE;
+      *(const gchar **) dest = json_node_get_string (node);
+      return TRUE;
+    case GTUBER_UTILS_JSON_FIELD_INT:
+      return _json_node_read_int (node, (gint64 *) dest);
+    case GTUBER_UTILS_JSON_FIELD_BOOLEAN:
+      if (!_json_node_holds_value_type (node, G_TYPE_BOOLEAN))
+        return FALSE;
+      *(gboolean *) dest = json_node_get_boolean (node);
+      return TRUE;
+    case GTUBER_UTILS_JSON_FIELD_OBJECT:
+      if (!JSON_NODE_HOLDS_OBJECT (node))
+        return FALSE;
+      *(JsonObject **) dest = json_node_get_object (node);
+      return TRUE;
+    case GTUBER_UTILS_JSON_FIELD_ARRAY:
+      if (!JSON_NODE_HOLDS_ARRAY (node))
+        return FALSE;
+      *(JsonArray **) dest = json_node_get_array (node);
+      return TRUE;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+
+  return FALSE;
+}
+
+/**
+ * gtuber_utils_json_path_new:
+ * @path_str: a path to value, with members separated by dots and
+ *   array elements selected with brackets, e.g. `a.b[0].c`
+ *
+ * Compiles path to value once, so it can be used to quickly
+ * obtain values from many JSON nodes without #JsonReader.
+ *
+ * Returns: (transfer full) (nullable): a new #GtuberUtilsJsonPath
+ *   or %NULL when path is malformed.
+ */
+GtuberUtilsJsonPath *
+gtuber_utils_json_path_new (const gchar *path_str)
+{
+  GtuberUtilsJsonPath *path;
+  GArray *elems;
+  const gchar *ptr = path_str;
+  guint i;
+
+  elems = g_array_new (FALSE, TRUE, sizeof (JsonPathElem));
+
+  while (*ptr) {
+    JsonPathElem elem = { NULL, 0 };
+
+    if (*ptr == '[') {
+      gchar *end = NULL;
+
+      /* Only a single index within brackets is allowed */
+      if (!g_ascii_isdigit (ptr[1]))
+        goto invalid;
+
+      elem.index = g_ascii_strtoull (ptr + 1, &end, 10);
+      if (*end != ']')
+        goto invalid;
+
+      ptr = end + 1;
+    } else {
+      gsize len = strcspn (ptr, ".[]");
+
+      if (ptr[len] == ']')
+        goto invalid;
+
+      elem.member = g_strndup (ptr, len);
+      ptr += len;
+    }
+    g_array_append_val (elems, elem);
+
+    if (*ptr == '.')
+      ptr++;
+  }
+
+  path = g_new (GtuberUtilsJsonPath, 1);
+  path->n_elems = elems->len;
+  path->elems = (JsonPathElem *) g_array_free (elems, FALSE);
+
+  return path;
+
+invalid:
+  g_warning ("Malformed JSON path: %s", path_str);
+
+  for (i = 0; i < elems->len; i++)
+    g_free (g_array_index (elems, JsonPathElem, i).member);
+
+  g_array_free (elems, TRUE);
+
+  return NULL;
+}
+
+void
+gtuber_utils_json_path_free (GtuberUtilsJsonPath *path)
+{
+  guint i;
+
+  for (i = 0; i < path->n_elems; i++)
+    g_free (path->elems[i].member);
+
+  g_free (path->elems);
+  g_free (path);
+}
+
+/**
+ * gtuber_utils_json_path_get_node:
+ * @path: a #GtuberUtilsJsonPath
+ * @node: a #JsonNode to start from
+ *
+ * Returns: (transfer none) (nullable): a #JsonNode at @path or %NULL when not found.
+ */
+JsonNode *
+gtuber_utils_json_path_get_node (const GtuberUtilsJsonPath *path, JsonNode *node)
+{
+  guint i;
+
+  for (i = 0; node && i < path->n_elems; i++) {
+    const JsonPathElem *elem = &path->elems[i];
+
+    if (elem->member) {
+      if (!JSON_NODE_HOLDS_OBJECT (node))
+        return NULL;
+
+      node = json_object_get_member (json_node_get_object (node), elem->member);
+    } else {
+      JsonArray *array;
+
+      if (!JSON_NODE_HOLDS_ARRAY (node))
+        return NULL;
+
+      array = json_node_get_array (node);
+      node = (elem->index < json_array_get_length (array))
+          ? json_array_get_element (array, elem->index)
+          : NULL;
+    }
+  }
+
+  return node;
+}
+
+const gchar *
+gtuber_utils_json_path_get_string (const GtuberUtilsJsonPath *path, JsonNode *node)
+{
+  const gchar *value = NULL;
+
+  if ((node = gtuber_utils_json_path_get_node (path, node)))
+    _json_node_read_field (node, GTUBER_UTILS_JSON_FIELD_STRING, &value);
+
+  return value;
+}
+
+gint64
+gtuber_utils_json_path_get_int (const GtuberUtilsJsonPath *path, JsonNode *node)
+{
+  gint64 value = 0;
+
+  if ((node = gtuber_utils_json_path_get_node (path, node)))
+    _json_node_read_int (node, &value);
+
+  return value;
+}
+
+gboolean
+gtuber_utils_json_path_get_boolean (const GtuberUtilsJsonPath *path, JsonNode *node)
+{
+  gboolean value = FALSE;
+
+  if ((node = gtuber_utils_json_path_get_node (path, node)))
+    _json_node_read_field (node, GTUBER_UTILS_JSON_FIELD_BOOLEAN, &value);
+
+  return value;
+}
+
+static void
+_project_member_cb (JsonObject *object, const gchar *name,
+    JsonNode *node, JsonProjectData *data)
+{
+  guint i;
+
+  if (data->n_found == data->n_fields)
+    return;
+
+  for (i = 0; i < data->n_fields; i++) {
+    const GtuberUtilsJsonField *field = &data->fields[i];
+
+    if (strcmp (field->name, name))
+      continue;
+
+    if (_json_node_read_field (node, field->type,
+        G_STRUCT_MEMBER_P (data->dest, field->offset)))
+      data->n_found++;
+
+    break;
+  }
+}
+
+/**
+ * gtuber_utils_json_project:
+ * @object: a #JsonObject
+ * @fields: (array length=n_fields): fields to extract
+ * @n_fields: number of fields
+ * @dest: struct to fill, described by @fields
+ *
+ * Extracts values of multiple members into a struct in a single
+ * pass over object members. Members that are missing or hold
+ * a value of different type leave their struct fields untouched.
+ *
+ * Strings, objects and arrays are owned by @object.
+ *
+ * Returns: number of fields that were filled.
+ */
+guint
+gtuber_utils_json_project (JsonObject *object,
+    const GtuberUtilsJsonField *fields, guint n_fields, gpointer dest)
+{
+  JsonProjectData data;
+
+  data.fields = fields;
+  data.n_fields = n_fields;
+  data.dest = dest;
+  data.n_found = 0;
+
+  json_object_foreach_member (object,
+      (JsonObjectForeach) _project_member_cb, &data);
+
+  return data.n_found;
+}
+
+typedef struct _JsonSchemaNode JsonSchemaNode;
+
+struct _JsonSchemaNode
+{
+  GHashTable *members;
+  JsonSchemaNode *elements;
+
+  gboolean capture;
+};
+
+struct _GtuberUtilsJsonSchema
+{
+  JsonSchemaNode *root;
+};
+
+typedef enum
+{
+  JSON_MODE_SKIP,
+  JSON_MODE_SELECT,
+  JSON_MODE_CAPTURE,
+} JsonMode;
+
+typedef enum
+{
+  JSON_LEX_NONE,
+  JSON_LEX_STRING,
+  JSON_LEX_STRING_ESCAPE,
+  JSON_LEX_STRING_UNICODE,
+  JSON_LEX_NUMBER,
+  JSON_LEX_LITERAL,
+} JsonLexState;
+
+typedef struct
+{
+  JsonNode *node;
+  const JsonSchemaNode *schema;
+
+  gchar *key;
+  gboolean want_key;
+} JsonFrame;
+
+struct _GtuberUtilsJsonExtractor
+{
+  const JsonSchemaNode *schema_root;
+
+  GArray *frames;
+  guint skip_depth;
+
+  JsonLexState lex;
+  GString *token;
+  gboolean keep_token;
+  gboolean token_is_key;
+
+  gchar unicode[5];
+  guint n_unicode;
+  gunichar high_surrogate;
+
+  JsonNode *root;
+};
+
+static void
+_json_schema_node_free (JsonSchemaNode *snode)
+{
+  if (snode->members)
+    g_hash_table_unref (snode->members);
+  if (snode->elements)
+    _json_schema_node_free (snode->elements);
+
+  g_free (snode);
+}
+
+static JsonSchemaNode *
+_json_schema_node_get_member (JsonSchemaNode *snode, const gchar *name)
+{
+  JsonSchemaNode *child;
+
+  if (!snode->members) {
+    snode->members = g_hash_table_new_full (g_str_hash, g_str_equal,
+        (GDestroyNotify) g_free, (GDestroyNotify) _json_schema_node_free);
+  }
+
+  if (!(child = g_hash_table_lookup (snode->members, name))) {
+    child = g_new0 (JsonSchemaNode, 1);
+    g_hash_table_insert (snode->members, g_strdup (name), child);
+  }
+
+  return child;
+}
+
+static gboolean
+_json_schema_path_is_valid (const gchar *path)
+{
+  const gchar *ptr;
+  gboolean in_list = FALSE;
+
+  for (ptr = path; *ptr; ptr++) {
+    switch (*ptr) {
+      case '[':
+        /* Only "[*]" is supported, not within members list */
+        if (in_list || !g_str_has_prefix (ptr, "[*]"))
+          return FALSE;
+        ptr += 2;
+        break;
+      case ']':
+        return FALSE;
+      case '{':
+        if (in_list)
+          return FALSE;
+        in_list = TRUE;
+        break;
+      case '}':
+        if (!in_list)
+          return FALSE;
+        in_list = FALSE;
+        break;
+      default:
+        break;
+    }
+  }
+
+  return !in_list;
+}
+
+static void
+_json_schema_add_path (JsonSchemaNode *snode, const gchar *ptr)
+{
+  while (*ptr) {
+    gsize len;
+    gchar *name;
+
+    if (*ptr == '.') {
+      ptr++;
+      continue;
+    }
+    if (g_str_has_prefix (ptr, "[*]")) {
+      if (!snode->elements)
+        snode->elements = g_new0 (JsonSchemaNode, 1);
+
+      snode = snode->elements;
+      ptr += 3;
+      continue;
+    }
+    if (*ptr == '{') {
+      const gchar *end, *rest;
+      gchar *list, **names;
+      guint i;
+
+      /* Path was validated, so list is always closed */
+      end = strchr (ptr, '}');
+      list = g_strndup (ptr + 1, end - ptr - 1);
+      rest = end + 1;
+
+      /* Remaining path applies to each listed member */
+      names = g_strsplit (list, ",", 0);
+      for (i = 0; names[i]; i++) {
+        g_strstrip (names[i]);
+        if (*names[i] != '\0')
+          _json_schema_add_path (_json_schema_node_get_member (snode, names[i]), rest);
+      }
+      g_strfreev (names);
+      g_free (list);
+
+      return;
+    }
+
+    len = strcspn (ptr, ".[{");
+    name = g_strndup (ptr, len);
+    snode = _json_schema_node_get_member (snode, name);
+    g_free (name);
+
+    ptr += len;
+  }
+
+  snode->capture = TRUE;
+}
+
+/**
+ * gtuber_utils_json_schema_new:
+ * @first_path: path to value that should be extracted
+ * @...: %NULL terminated list of more paths
+ *
+ * Compiles a schema of wanted values for #GtuberUtilsJsonExtractor.
+ * Members are separated by dots, `[*]` selects every array element
+ * and `{a,b}` selects multiple members at once, for example:
+ * `streamingData.adaptiveFormats[*].{url,itag,bitrate}`.
+ *
+ * Whole value is extracted when path ends at it.
+ *
+ * Returns: (transfer full) (nullable): a new #GtuberUtilsJsonSchema
+ *   or %NULL when any of paths is malformed.
+ */
+GtuberUtilsJsonSchema *
+gtuber_utils_json_schema_new (const gchar *first_path, ...)
+{
+  GtuberUtilsJsonSchema *schema;
+  va_list args;
+  const gchar *path = first_path;
+
+  schema = g_new (GtuberUtilsJsonSchema, 1);
+  schema->root = g_new0 (JsonSchemaNode, 1);
+
+  va_start (args, first_path);
+  while (path) {
+    if (!_json_schema_path_is_valid (path)) {
+      g_warning ("Malformed JSON schema path: %s", path);
+
+      gtuber_utils_json_schema_free (schema);
+      schema = NULL;
+      break;
+    }
+    _json_schema_add_path (schema->root, path);
+    path = va_arg (args, const gchar *);
+  }
+  va_end (args);
+
+  return schema;
+}
+
+void
+gtuber_utils_json_schema_free (GtuberUtilsJsonSchema *schema)
+{
+  _json_schema_node_free (schema->root);
+  g_free (schema);
+}
+
+/**
+ * gtuber_utils_json_extractor_new:
+ * @schema: a #GtuberUtilsJsonSchema
+ *
+ * Creates a new push parser that builds a #JsonNode tree only out of
+ * values described by @schema while skipping over everything else.
+ *
+ * Schema must stay valid while extractor is in use.
+ *
+ * Returns: (transfer full): a new #GtuberUtilsJsonExtractor.
+ */
+GtuberUtilsJsonExtractor *
+gtuber_utils_json_extractor_new (const GtuberUtilsJsonSchema *schema)
+{
+  GtuberUtilsJsonExtractor *extractor;
+
+  extractor = g_new0 (GtuberUtilsJsonExtractor, 1);
+  extractor->schema_root = schema->root;
+  extractor->frames = g_array_new (FALSE, TRUE, sizeof (JsonFrame));
+  extractor->token = g_string_new (NULL);
+  extractor->lex = JSON_LEX_NONE;
+
+  return extractor;
+}
+
+void
+gtuber_utils_json_extractor_free (GtuberUtilsJsonExtractor *extractor)
+{
+  guint i;
+
+  for (i = 0; i < extractor->frames->len; i++) {
+    JsonFrame *frame = &g_array_index (extractor->frames, JsonFrame, i);
+
+    json_node_unref (frame->node);
+    g_free (frame->key);
+  }
+
+  g_array_unref (extractor->frames);
+  g_string_free (extractor->token, TRUE);
+
+  if (extractor->root)
+    json_node_unref (extractor->root);
+
+  g_free (extractor);
+}
+
+static inline JsonFrame *
+_extractor_get_frame (GtuberUtilsJsonExtractor *extractor)
+{
+  return (extractor->frames->len > 0)
+      ? &g_array_index (extractor->frames, JsonFrame, extractor->frames->len - 1)
+      : NULL;
+}
+
+static JsonMode
+_extractor_get_value_mode (GtuberUtilsJsonExtractor *extractor,
+    const JsonSchemaNode **schema)
+{
+  JsonFrame *frame;
+  const JsonSchemaNode *child = NULL;
+
+  *schema = NULL;
+
+  if (!(frame = _extractor_get_frame (extractor))) {
+    /* Only first root value is taken */
+    if (extractor->root)
+      return JSON_MODE_SKIP;
+
+    child = extractor->schema_root;
+  } else if (!frame->schema) {
+    return JSON_MODE_CAPTURE;
+  } else if (JSON_NODE_HOLDS_OBJECT (frame->node)) {
+    if (frame->key && frame->schema->members)
+      child = g_hash_table_lookup (frame->schema->members, frame->key);
+  } else {
+    child = frame->schema->elements;
+  }
+
+  if (!child)
+    return JSON_MODE_SKIP;
+
+  *schema = child;
+
+  return (child->capture) ? JSON_MODE_CAPTURE : JSON_MODE_SELECT;
+}
+
+static void
+_extractor_take_value (GtuberUtilsJsonExtractor *extractor, JsonNode *node)
+{
+  JsonFrame *frame;
+
+  if (!(frame = _extractor_get_frame (extractor))) {
+    if (node)
+      extractor->root = node;
+    return;
+  }
+
+  if (JSON_NODE_HOLDS_OBJECT (frame->node)) {
+    if (node && frame->key)
+      json_object_set_member (json_node_get_object (frame->node), frame->key, node);
+    else if (node)
+      json_node_unref (node);
+
+    g_clear_pointer (&frame->key, g_free);
+  } else if (node) {
+    json_array_add_element (json_node_get_array (frame->node), node);
+  }
+}
+
+static void
+_extractor_begin_container (GtuberUtilsJsonExtractor *extractor, gboolean is_object)
+{
+  JsonFrame new_frame = { NULL, NULL, NULL, FALSE };
+  const JsonSchemaNode *schema;
+  JsonMode mode;
+
+  mode = _extractor_get_value_mode (extractor, &schema);
+
+  if (mode == JSON_MODE_SKIP) {
+    _extractor_take_value (extractor, NULL);
+    extractor->skip_depth = 1;
+    return;
+  }
+
+  if (is_object) {
+    new_frame.node = json_node_new (JSON_NODE_OBJECT);
+    json_node_take_object (new_frame.node, json_object_new ());
+    new_frame.want_key = TRUE;
+  } else {
+    new_frame.node = json_node_new (JSON_NODE_ARRAY);
+    json_node_take_array (new_frame.node, json_array_new ());
+  }
+  new_frame.schema = (mode == JSON_MODE_SELECT) ? schema : NULL;
+
+  _extractor_take_value (extractor, json_node_ref (new_frame.node));
+  g_array_append_val (extractor->frames, new_frame);
+}
+
+static gboolean
+_extractor_end_container (GtuberUtilsJsonExtractor *extractor, GError **error)
+{
+  JsonFrame *frame;
+
+  if (!(frame = _extractor_get_frame (extractor))) {
+    g_set_error (error, JSON_PARSER_ERROR,
+        JSON_PARSER_ERROR_PARSE,
+        "Unexpected end of container");
+    return FALSE;
+  }
+
+  json_node_unref (frame->node);
+  g_free (frame->key);
+
+  g_array_set_size (extractor->frames, extractor->frames->len - 1);
+
+  return TRUE;
+}
+
+static void
+_extractor_begin_scalar (GtuberUtilsJsonExtractor *extractor,
+    JsonLexState lex, gboolean is_key)
+{
+  const JsonSchemaNode *schema;
+
+  extractor->lex = lex;
+  extractor->token_is_key = is_key;
+
+  /* Keys are always needed to match schema, values only when captured */
+  extractor->keep_token = (extractor->skip_depth == 0
+      && (is_key || _extractor_get_value_mode (extractor, &schema) == JSON_MODE_CAPTURE));
+
+  g_string_truncate (extractor->token, 0);
+}
+
+static gboolean
+_extractor_end_scalar (GtuberUtilsJsonExtractor *extractor, GError **error)
+{
+  JsonLexState lex = extractor->lex;
+  const gchar *str = extractor->token->str;
+  JsonNode *node = NULL;
+
+  extractor->lex = JSON_LEX_NONE;
+
+  if (extractor->skip_depth > 0)
+    return TRUE;
+
+  if (!extractor->keep_token) {
+    if (!extractor->token_is_key)
+      _extractor_take_value (extractor, NULL);
+    return TRUE;
+  }
+
+  if (extractor->token_is_key) {
+    JsonFrame *frame = _extractor_get_frame (extractor);
+
+    g_free (frame->key);
+    frame->key = g_strndup (str, extractor->token->len);
+
+    return TRUE;
+  }
+
+  switch (lex) {
+    case JSON_LEX_STRING:
+      node = json_node_new (JSON_NODE_VALUE);
+      json_node_set_string (node, str);
+      break;
+    case JSON_LEX_NUMBER:
+      node = json_node_new (JSON_NODE_VALUE);
+      if (strpbrk (str, ".eE"))
+        json_node_set_double (node, g_ascii_strtod (str, NULL));
+      else
+        json_node_set_int (node, g_ascii_strtoll (str, NULL, 10));
+      break;
+    case JSON_LEX_LITERAL:
+      if (!strcmp (str, "null")) {
+        node = json_node_new (JSON_NODE_NULL);
+      } else if (!strcmp (str, "true") || !strcmp (str, "false")) {
+        node = json_node_new (JSON_NODE_VALUE);
+        json_node_set_boolean (node, str[0] == 't');
+      } else {
+        g_set_error (error, JSON_PARSER_ERROR,
+            JSON_PARSER_ERROR_INVALID_BAREWORD,
+            "Invalid literal: %s", str);
+        return FALSE;
+      }
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+
+  _extractor_take_value (extractor, node);
+
+  return TRUE;
+}
+
+static void
+_extractor_append_unichar (GtuberUtilsJsonExtractor *extractor, gunichar uc)
+{
+  gchar buf[6];
+  gint len;
+
+  len = g_unichar_to_utf8 (uc, buf);
+  g_string_append_len (extractor->token, buf, len);
+}
+
+static void
+_extractor_read_unicode (GtuberUtilsJsonExtractor *extractor)
+{
+  gunichar uc;
+
+  extractor->unicode[4] = '\0';
+  uc = g_ascii_strtoull (extractor->unicode, NULL, 16);
+
+  if (uc >= 0xD800 && uc <= 0xDBFF) {
+    extractor->high_surrogate = uc;
+    return;
+  }
+  if (uc >= 0xDC00 && uc <= 0xDFFF && extractor->high_surrogate) {
+    uc = 0x10000 + ((extractor->high_surrogate - 0xD800) << 10) + (uc - 0xDC00);
+  }
+  extractor->high_surrogate = 0;
+
+  _extractor_append_unichar (extractor, uc);
+}
+
+static gboolean
+_extractor_read_structural (GtuberUtilsJsonExtractor *extractor, gchar c, GError **error)
+{
+  JsonFrame *frame = _extractor_get_frame (extractor);
+
+  /* Only count nesting until skipped value ends */
+  if (extractor->skip_depth > 0) {
+    switch (c) {
+      case '{':
+      case '[':
+        extractor->skip_depth++;
+        break;
+      case '}':
+      case ']':
+        extractor->skip_depth--;
+        break;
+      case '"':
+        _extractor_begin_scalar (extractor, JSON_LEX_STRING, FALSE);
+        break;
+      default:
+        break;
+    }
+    return TRUE;
+  }
+
+  switch (c) {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+      break;
+    case '{':
+    case '[':
+      _extractor_begin_container (extractor, c == '{');
+      break;
+    case '}':
+    case ']':
+      return _extractor_end_container (extractor, error);
+    case ':':
+      if (frame)
+        frame->want_key = FALSE;
+      break;
+    case ',':
+      if (frame && JSON_NODE_HOLDS_OBJECT (frame->node))
+        frame->want_key = TRUE;
+      break;
+    case '"':
+      _extractor_begin_scalar (extractor, JSON_LEX_STRING,
+          frame && JSON_NODE_HOLDS_OBJECT (frame->node) && frame->want_key);
+      break;
+    default:
+      if (c == '-' || g_ascii_isdigit (c)) {
+        _extractor_begin_scalar (extractor, JSON_LEX_NUMBER, FALSE);
+      } else if (g_ascii_isalpha (c)) {
+        _extractor_begin_scalar (extractor, JSON_LEX_LITERAL, FALSE);
+      } else {
+        g_set_error (error, JSON_PARSER_ERROR,
+            JSON_PARSER_ERROR_PARSE,
+            "Unexpected character: '%c'", c);
+        return FALSE;
+      }
+      if (extractor->keep_token)
+        g_string_append_c (extractor->token, c);
+      break;
+  }
+
+  return TRUE;
+}
+
+/**
+ * gtuber_utils_json_extractor_push_data:
+ * @extractor: a #GtuberUtilsJsonExtractor
+ * @data: next chunk of JSON data
+ * @size: size of @data
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * Parses next chunk of JSON data. Values can be split between chunks.
+ *
+ * Returns: %TRUE if data was parsed, %FALSE on error.
+ */
+gboolean
+gtuber_utils_json_extractor_push_data (GtuberUtilsJsonExtractor *extractor,
+    const gchar *data, gsize size, GError **error)
+{
+  const gchar *end = data + size;
+
+  while (data < end) {
+    gchar c = *data;
+
+    switch (extractor->lex) {
+      case JSON_LEX_NONE:
+        if (!_extractor_read_structural (extractor, c, error))
+          return FALSE;
+        break;
+      case JSON_LEX_STRING:{
+        const gchar *run = data;
+
+        /* Consume whole run of plain characters at once */
+        while (run < end && *run != '"' && *run != '\\')
+          run++;
+
+        if (extractor->keep_token)
+          g_string_append_len (extractor->token, data, run - data);
+
+        if (run == end) {
+          data = end;
+          continue;
+        }
+        data = run;
+
+        if (*data == '\\') {
+          extractor->lex = JSON_LEX_STRING_ESCAPE;
+        } else if (!_extractor_end_scalar (extractor, error)) {
+          return FALSE;
+        }
+        break;
+      }
+      case JSON_LEX_STRING_ESCAPE:
+        extractor->lex = JSON_LEX_STRING;
+
+        if (c == 'u') {
+          extractor->lex = JSON_LEX_STRING_UNICODE;
+          extractor->n_unicode = 0;
+        } else if (extractor->keep_token) {
+          switch (c) {
+            case 'b':
+              c = '\b';
+              break;
+            case 'f':
+              c = '\f';
+              break;
+            case 'n':
+              c = '\n';
+              break;
+            case 'r':
+              c = '\r';
+              break;
+            case 't':
+              c = '\t';
+              break;
+            default:
+              break;
+          }
+          g_string_append_c (extractor->token, c);
+        }
+        break;
+      case JSON_LEX_STRING_UNICODE:
+        extractor->unicode[extractor->n_unicode++] = c;
+
+        if (extractor->n_unicode == 4) {
+          if (extractor->keep_token)
+            _extractor_read_unicode (extractor);
+
+          extractor->lex = JSON_LEX_STRING;
+        }
+        break;
+      case JSON_LEX_NUMBER:
+      case JSON_LEX_LITERAL:
+        if (g_ascii_isalnum (c) || c == '.' || c == '-' || c == '+') {
+          if (extractor->keep_token)
+            g_string_append_c (extractor->token, c);
+          break;
+        }
+        if (!_extractor_end_scalar (extractor, error))
+          return FALSE;
+
+        /* Terminating character needs to be read again */
+        continue;
+      default:
+        g_assert_not_reached ();
+        break;
+    }
+    data++;
+  }
+
+  return TRUE;
+}
+
+/**
+ * gtuber_utils_json_extractor_finish:
+ * @extractor: a #GtuberUtilsJsonExtractor
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * Finishes parsing after all data was pushed.
+ *
+ * Returns: (transfer full) (nullable): a #JsonNode tree with
+ *   extracted values or %NULL on error.
+ */
+JsonNode *
+gtuber_utils_json_extractor_finish (GtuberUtilsJsonExtractor *extractor,
+    GError **error)
+{
+  JsonNode *root;
+
+  if ((extractor->lex == JSON_LEX_NUMBER || extractor->lex == JSON_LEX_LITERAL)
+      && !_extractor_end_scalar (extractor, error))
+    return NULL;
+
+  if (extractor->lex != JSON_LEX_NONE || extractor->skip_depth > 0
+      || extractor->frames->len > 0) {
+    g_set_error (error, JSON_PARSER_ERROR,
+        JSON_PARSER_ERROR_PARSE,
+        "Unexpected end of JSON data");
+    return NULL;
+  }
+  if (!extractor->root) {
+    g_set_error (error, JSON_PARSER_ERROR,
+        JSON_PARSER_ERROR_PARSE,
+        "No requested values in JSON data");
+    return NULL;
+  }
+
+  root = extractor->root;
+  extractor->root = NULL;
+
+  return root;
+}
+
+/**
+ * gtuber_utils_json_extract_stream:
+ * @stream: a #GInputStream
+ * @schema: a #GtuberUtilsJsonSchema
+ * @error: (nullable): return location for a #GError, or %NULL
+ *
+ * A convenience function that reads #GInputStream in chunks
+ * with #GtuberUtilsJsonExtractor.
+ *
+ * Returns: (transfer full) (nullable): a #JsonNode tree with
+ *   extracted values or %NULL on error.
+ */
+JsonNode *
+gtuber_utils_json_extract_stream (GInputStream *stream,
+    const GtuberUtilsJsonSchema *schema, GError **error)
+{
+  GtuberUtilsJsonExtractor *extractor;
+  JsonNode *root = NULL;
+  gchar *buf;
+  gssize n_read;
+
+  extractor = gtuber_utils_json_extractor_new (schema);
+  buf = g_malloc (JSON_CHUNK_SIZE);
+
+  while ((n_read = g_input_stream_read (stream, buf, JSON_CHUNK_SIZE, NULL, error)) > 0) {
+    if (!gtuber_utils_json_extractor_push_data (extractor, buf, n_read, error)) {
+      n_read = -1;
+      break;
+    }
+  }
+
+  if (n_read == 0)
+    root = gtuber_utils_json_extractor_finish (extractor, error);
+
+  g_free (buf);
+  gtuber_utils_json_extractor_free (extractor);
+
+  if (root && !g_log_writer_default_would_drop (G_LOG_LEVEL_DEBUG, G_LOG_DOMAIN)) {
+    gchar *data = _json_node_to_string_internal (root, TRUE);
+
+    g_debug ("Extracted data:\n%s", data);
+    g_free (data);
+  }
+
+  return root;
+}
+
+struct _GtuberUtilsJsonTemplate
+{
+  /* Literal parts, with slot names between them */
+  GPtrArray *parts;
+  GPtrArray *slots;
+
+  gsize literal_len;
+};
+
+/**
+ * gtuber_utils_json_template_new:
+ * @skeleton: a JSON data with placeholders
+ *
+ * Compiles JSON request body skeleton, so it can be quickly filled
+ * with values later. Placeholders are written as `@name@` in places
+ * where string value is expected (without quotes), thus skeleton
+ * cannot contain `@` character for any other purpose.
+ *
+ * Returns: (transfer full): a new #GtuberUtilsJsonTemplate.
+ */
+GtuberUtilsJsonTemplate *
+gtuber_utils_json_template_new (const gchar *skeleton)
+{
+  GtuberUtilsJsonTemplate *tmpl;
+  const gchar *ptr = skeleton;
+
+  tmpl = g_new (GtuberUtilsJsonTemplate, 1);
+  tmpl->parts = g_ptr_array_new_with_free_func (g_free);
+  tmpl->slots = g_ptr_array_new_with_free_func (g_free);
+  tmpl->literal_len = 0;
+
+  while (TRUE) {
+    const gchar *start, *end;
+
+    if (!(start = strchr (ptr, '@'))
+        || !(end = strchr (start + 1, '@'))) {
+      g_ptr_array_add (tmpl->parts, g_strdup (ptr));
+      tmpl->literal_len += strlen (ptr);
+      break;
+    }
+
+    g_ptr_array_add (tmpl->parts, g_strndup (ptr, start - ptr));
+    g_ptr_array_add (tmpl->slots, g_strndup (start + 1, end - start - 1));
+    tmpl->literal_len += start - ptr;
+
+    ptr = end + 1;
+  }
+
+  return tmpl;
+}
+
+void
+gtuber_utils_json_template_free (GtuberUtilsJsonTemplate *tmpl)
+{
+  g_ptr_array_unref (tmpl->parts);
+  g_ptr_array_unref (tmpl->slots);
+
+  g_free (tmpl);
+}
+
+static void
+_json_string_append_escaped (GString *string, const gchar *value)
+{
+  const gchar *ptr;
+
+  if (!value) {
+    g_string_append (string, "null");
+    return;
+  }
+
+  g_string_append_c (string, '"');
+
+  for (ptr = value; *ptr; ptr++) {
+    switch (*ptr) {
+      case '"':
+        g_string_append (string, "\\\"");
+        break;
+      case '\\':
+        g_string_append (string, "\\\\");
+        break;
+      case '\n':
+        g_string_append (string, "\\n");
+        break;
+      case '\r':
+        g_string_append (string, "\\r");
+        break;
+      case '\t':
+        g_string_append (string, "\\t");
+        break;
+      default:
+        if ((guchar) *ptr < 0x20)
+          g_string_append_printf (string, "\\u%04x", (guchar) *ptr);
+        else
+          g_string_append_c (string, *ptr);
+        break;
+    }
+  }
+
+  g_string_append_c (string, '"');
+}
+
+/**
+ * gtuber_utils_json_template_fill:
+ * @tmpl: a #GtuberUtilsJsonTemplate
+ * @first_name: name of the first placeholder
+ * @...: value of the first placeholder, followed optionally by more
+ *   name/value pairs, followed by %NULL
+ *
+ * Fills template placeholders with escaped JSON strings.
+ * Placeholders with %NULL or without value become `null`.
+ *
+ * Returns: (transfer full): JSON data.
+ */
+gchar *
+gtuber_utils_json_template_fill (const GtuberUtilsJsonTemplate *tmpl,
+    const gchar *first_name, ...)
+{
+  va_list args;
+  GString *string;
+  GHashTable *values;
+  const gchar *name = first_name;
+  guint i;
+
+  values = g_hash_table_new (g_str_hash, g_str_equal);
+
+  va_start (args, first_name);
+  while (name) {
+    g_hash_table_insert (values, (gpointer) name, va_arg (args, gchar *));
+    name = va_arg (args, const gchar *);
+  }
+  va_end (args);
+
+  string = g_string_sized_new (tmpl->literal_len + 256);
+
+  for (i = 0; i < tmpl->parts->len; i++) {
+    g_string_append (string, g_ptr_array_index (tmpl->parts, i));
+
+    if (i < tmpl->slots->len) {
+      _json_string_append_escaped (string,
+          g_hash_table_lookup (values, g_ptr_array_index (tmpl->slots, i)));
+    }
+  }
+
+  g_hash_table_unref (values);
+
+  return g_string_free (string, FALSE);
+}
@@ -28,8 +28,15 @@ G_BEGIN_DECLS
 /*
  * Fills JSON data into gchar pointer, it is safe to call "break"
  * inside passed code block to cancel this operation.
+ * Generated data is compact, as it is meant for request bodies.
  */
-#define GTUBER_UTILS_JSON_BUILD_OBJECT(dest, ...) {                    \
+#define GTUBER_UTILS_JSON_BUILD_OBJECT(dest, ...)                      \
+    GTUBER_UTILS_JSON_BUILD_OBJECT_FULL (dest, FALSE, __VA_ARGS__)
+
+/*
+ * Same as above, but allows generating human readable data.
+ */
+#define GTUBER_UTILS_JSON_BUILD_OBJECT_FULL(dest, pretty, ...) {       \
     JsonBuilder *_utils_builder = json_builder_new ();                 \
     gboolean _obj_ok = FALSE;                                          \
     *dest = NULL;                                                      \
@@ -42,8 +49,10 @@ G_BEGIN_DECLS
     if (_obj_ok) {                                                     \
       JsonGenerator *_utils_gen = json_generator_new ();               \
       JsonNode *_utils_root = json_builder_get_root (_utils_builder);  \
-      json_generator_set_pretty (_utils_gen, TRUE);                    \
-      json_generator_set_indent (_utils_gen, 2);                       \
+      if (pretty) {                                                    \
+        json_generator_set_pretty (_utils_gen, TRUE);                  \
+        json_generator_set_indent (_utils_gen, 2);                     \
+      }                                                                \
       json_generator_set_root (_utils_gen, _utils_root);               \
       *dest = json_generator_to_data (_utils_gen, NULL);               \
       g_object_unref (_utils_gen);                                     \
@@ -105,6 +114,32 @@ G_BEGIN_DECLS
 #define GTUBER_UTILS_JSON_ARRAY_INDEX(index)                           \
     GUINT_TO_POINTER (index + 1)
 
+/* Describes where to store member value, for use with project function */
+#define GTUBER_UTILS_JSON_FIELD(name, type, struct_type, member)       \
+    { name, GTUBER_UTILS_JSON_FIELD_##type,                            \
+      G_STRUCT_OFFSET (struct_type, member) }
+
+typedef enum
+{
+  GTUBER_UTILS_JSON_FIELD_STRING,
+  GTUBER_UTILS_JSON_FIELD_INT,
+  GTUBER_UTILS_JSON_FIELD_BOOLEAN,
+  GTUBER_UTILS_JSON_FIELD_OBJECT,
+  GTUBER_UTILS_JSON_FIELD_ARRAY,
+} GtuberUtilsJsonFieldType;
+
+typedef struct
+{
+  const gchar *name;
+  GtuberUtilsJsonFieldType type;
+  glong offset;
+} GtuberUtilsJsonField;
+
+typedef struct _GtuberUtilsJsonPath GtuberUtilsJsonPath;
+typedef struct _GtuberUtilsJsonSchema GtuberUtilsJsonSchema;
+typedef struct _GtuberUtilsJsonExtractor GtuberUtilsJsonExtractor;
+typedef struct _GtuberUtilsJsonTemplate GtuberUtilsJsonTemplate;
+
 JsonReader *         gtuber_utils_json_read_stream          (GInputStream *stream, GError **error);
 
 JsonReader *         gtuber_utils_json_read_data            (const gchar *data, GError **error);
@@ -129,4 +164,38 @@ gchar *              gtuber_utils_json_reader_to_string     (JsonReader *reader)
 
 void                 gtuber_utils_json_parser_debug         (JsonParser *parser);
 
+GtuberUtilsJsonPath * gtuber_utils_json_path_new            (const gchar *path_str);
+
+void                 gtuber_utils_json_path_free            (GtuberUtilsJsonPath *path);
+
+JsonNode *           gtuber_utils_json_path_get_node        (const GtuberUtilsJsonPath *path, JsonNode *node);
+
+const gchar *        gtuber_utils_json_path_get_string      (const GtuberUtilsJsonPath *path, JsonNode *node);
+
+gint64               gtuber_utils_json_path_get_int         (const GtuberUtilsJsonPath *path, JsonNode *node);
+
+gboolean             gtuber_utils_json_path_get_boolean     (const GtuberUtilsJsonPath *path, JsonNode *node);
+
+guint                gtuber_utils_json_project              (JsonObject *object, const GtuberUtilsJsonField *fields, guint n_fields, gpointer dest);
+
+GtuberUtilsJsonSchema * gtuber_utils_json_schema_new        (const gchar *first_path, ...) G_GNUC_NULL_TERMINATED;
+
+void                 gtuber_utils_json_schema_free          (GtuberUtilsJsonSchema *schema);
+
+GtuberUtilsJsonExtractor * gtuber_utils_json_extractor_new  (const GtuberUtilsJsonSchema *schema);
+
+gboolean             gtuber_utils_json_extractor_push_data  (GtuberUtilsJsonExtractor *extractor, const gchar *data, gsize size, GError **error);
+
+JsonNode *           gtuber_utils_json_extractor_finish     (GtuberUtilsJsonExtractor *extractor, GError **error);
+
+void                 gtuber_utils_json_extractor_free       (GtuberUtilsJsonExtractor *extractor);
+
+JsonNode *           gtuber_utils_json_extract_stream       (GInputStream *stream, const GtuberUtilsJsonSchema *schema, GError **error);
+
+GtuberUtilsJsonTemplate * gtuber_utils_json_template_new    (const gchar *skeleton);
+
+void                 gtuber_utils_json_template_free        (GtuberUtilsJsonTemplate *tmpl);
+
+gchar *              gtuber_utils_json_template_fill        (const GtuberUtilsJsonTemplate *tmpl, const gchar *first_name, ...) G_GNUC_NULL_TERMINATED;
+
 G_END_DECLS
@@ -55,54 +55,203 @@ _iterate_nodes_for_prop (xmlNode *start_node, const gchar *search_str)
   return value;
 }
 
-static gchar *
-_obtain_json_data (const xmlChar *content, const gchar *search_str)
+#define XML_CHUNK_SIZE 8192
+
+typedef enum
 {
-  gchar **data, *value = NULL;
-  guint i;
+  JSON_SCAN_SEARCH,
+  JSON_SCAN_SEEK_OPEN,
+  JSON_SCAN_OBJECT,
+  JSON_SCAN_DONE,
+} JsonScanState;
 
-  if (!content)
-    return NULL;
+struct _GtuberUtilsXmlJsonScanner
+{
+  gchar *name;
+  gsize name_len;
 
-  data = g_strsplit ((const gchar *) content, search_str, 0);
-
-  /* Start after first occurence */
-  for (i = 1; i < g_strv_length (data); i++) {
-    const gchar *text = data[i];
-    gsize index, open_index = 0;
-    gint open_brackets = 0;
-    gboolean was_open = FALSE, found = FALSE;
-
-    /* Find index of last closing bracket */
-    for (index = 0; index < strlen (text); index++) {
-      if (text[index] == '{') {
-        if (!was_open) {
-          was_open = TRUE;
-          open_index = index;
-        }
-        open_brackets++;
-      } else if (was_open && text[index] == '}') {
-        open_brackets--;
-      }
+  /* Partial match table of searched name */
+  gsize *fallback;
+  gsize matched;
+
+  JsonScanState state;
+  guint depth;
+  gboolean in_string;
+  gboolean escaped;
+
+  GString *json;
+};
+
+/**
+ * gtuber_utils_xml_json_scanner_new:
+ * @json_name: name of JS variable holding JSON object
+ *
+ * Creates a scanner that finds JSON object assigned to @json_name
+ * in HTML data pushed to it in chunks, without building a DOM.
+ *
+ * Returns: (transfer full): a new #GtuberUtilsXmlJsonScanner.
+ */
+GtuberUtilsXmlJsonScanner *
+gtuber_utils_xml_json_scanner_new (const gchar *json_name)
+{
+  GtuberUtilsXmlJsonScanner *scanner;
+  gsize i, len = 0;
+
+  g_return_val_if_fail (json_name != NULL && *json_name != '\0', NULL);
+
+  scanner = g_new0 (GtuberUtilsXmlJsonScanner, 1);
+  scanner->name = g_strdup (json_name);
+  scanner->name_len = strlen (json_name);
+  scanner->fallback = g_new0 (gsize, scanner->name_len);
+  scanner->state = JSON_SCAN_SEARCH;
+
+  for (i = 1; i < scanner->name_len; i++) {
+    while (len > 0 && json_name[i] != json_name[len])
+      len = scanner->fallback[len - 1];
+    if (json_name[i] == json_name[len])
+      len++;
 
-      if ((found = was_open && open_brackets == 0))
+    scanner->fallback[i] = len;
+  }
+
+  return scanner;
+}
+
+void
+gtuber_utils_xml_json_scanner_free (GtuberUtilsXmlJsonScanner *scanner)
+{
+  g_free (scanner->name);
+  g_free (scanner->fallback);
+
+  if (scanner->json)
+    g_string_free (scanner->json, TRUE);
+
+  g_free (scanner);
+}
+
+static void
+_json_scanner_search_char (GtuberUtilsXmlJsonScanner *scanner, gchar c)
+{
+  while (scanner->matched > 0 && c != scanner->name[scanner->matched])
+    scanner->matched = scanner->fallback[scanner->matched - 1];
+
+  if (c == scanner->name[scanner->matched])
+    scanner->matched++;
+
+  if (scanner->matched == scanner->name_len) {
+    scanner->matched = scanner->fallback[scanner->matched - 1];
+    scanner->state = JSON_SCAN_SEEK_OPEN;
+  }
+}
+
+/**
+ * gtuber_utils_xml_json_scanner_push_data:
+ * @scanner: a #GtuberUtilsXmlJsonScanner
+ * @data: next chunk of HTML data
+ * @size: size of @data
+ *
+ * Scans next chunk of data. Brace matching skips braces
+ * within JSON strings, so data can be pushed only until
+ * this function returns %TRUE.
+ *
+ * Returns: %TRUE when whole JSON object was found, %FALSE otherwise.
+ */
+gboolean
+gtuber_utils_xml_json_scanner_push_data (GtuberUtilsXmlJsonScanner *scanner,
+    const gchar *data, gsize size)
+{
+  gsize i, obj_start = 0;
+  gboolean in_object = (scanner->state == JSON_SCAN_OBJECT);
+
+  for (i = 0; i < size && scanner->state != JSON_SCAN_DONE; i++) {
+    const gchar c = data[i];
+
+    switch (scanner->state) {
+      case JSON_SCAN_SEARCH:
+        _json_scanner_search_char (scanner, c);
+        break;
+      case JSON_SCAN_SEEK_OPEN:
+        if (c == '{') {
+          if (!scanner->json)
+            scanner->json = g_string_sized_new (XML_CHUNK_SIZE);
+
+          scanner->state = JSON_SCAN_OBJECT;
+          scanner->depth = 1;
+          obj_start = i;
+          in_object = TRUE;
+        } else if (!g_ascii_isspace (c) && !strchr ("=:\"']", c)) {
+          /* Only a name reference, not an assignment */
+          scanner->state = JSON_SCAN_SEARCH;
+          _json_scanner_search_char (scanner, c);
+        }
+        break;
+      case JSON_SCAN_OBJECT:
+        if (scanner->in_string) {
+          if (scanner->escaped)
+            scanner->escaped = FALSE;
+          else if (c == '\\')
+            scanner->escaped = TRUE;
+          else if (c == '"')
+            scanner->in_string = FALSE;
+        } else if (c == '"') {
+          scanner->in_string = TRUE;
+        } else if (c == '{') {
+          scanner->depth++;
+        } else if (c == '}' && --scanner->depth == 0) {
+          scanner->state = JSON_SCAN_DONE;
+        }
+        break;
+      default:
+        g_assert_not_reached ();
         break;
     }
+  }
 
-    if (found) {
-      GString *string = g_string_new (text);
+  /* Append whole object part of this chunk at once */
+  if (in_object)
+    g_string_append_len (scanner->json, data + obj_start, i - obj_start);
 
-      /* Create our substring */
-      g_string_truncate (string, index + 1);
-      if (open_index > 0)
-        g_string_erase (string, 0, open_index);
+  return (scanner->state == JSON_SCAN_DONE);
+}
 
-      value = g_string_free (string, FALSE);
-      break;
-    }
+/**
+ * gtuber_utils_xml_json_scanner_finish:
+ * @scanner: a #GtuberUtilsXmlJsonScanner
+ *
+ * Returns: (transfer full) (nullable): found JSON object data
+ *   or %NULL if it was not found.
+ */
+gchar *
+gtuber_utils_xml_json_scanner_finish (GtuberUtilsXmlJsonScanner *scanner)
+{
+  gchar *value = NULL;
+
+  if (scanner->state == JSON_SCAN_DONE) {
+    value = g_string_free (scanner->json, FALSE);
+    scanner->json = NULL;
   }
 
-  g_strfreev (data);
+  g_debug ("JSON %s %s", scanner->name, (value) ? "found" : "not found");
+
+  return value;
+}
+
+static gchar *
+_obtain_json_data (const xmlChar *content, const gchar *search_str)
+{
+  GtuberUtilsXmlJsonScanner *scanner;
+  gchar *value = NULL;
+
+  if (!content)
+    return NULL;
+
+  scanner = gtuber_utils_xml_json_scanner_new (search_str);
+
+  if (gtuber_utils_xml_json_scanner_push_data (scanner,
+      (const gchar *) content, strlen ((const gchar *) content)))
+    value = gtuber_utils_xml_json_scanner_finish (scanner);
+
+  gtuber_utils_xml_json_scanner_free (scanner);
 
   return value;
 }
@@ -174,3 +323,50 @@ gtuber_utils_xml_obtain_json_in_node (xmlDoc *doc, const gchar *json_name)
 
   return value;
 }
+
+/**
+ * gtuber_utils_xml_obtain_json_in_stream:
+ * @stream: a #GInputStream with HTML data
+ * @json_name: name of JS variable holding JSON object
+ * @error: (nullable): return location for a #GError
+ *
+ * Reads HTML @stream only until JSON object assigned to @json_name
+ * is complete. This is much faster than loading whole HTML document
+ * with gtuber_utils_xml_load_html_from_data() in order to get JSON
+ * data from page scripts.
+ *
+ * Returns: (transfer full) (nullable): found JSON object data
+ *   or %NULL if it was not found.
+ */
+gchar *
+gtuber_utils_xml_obtain_json_in_stream (GInputStream *stream,
+    const gchar *json_name, GError **error)
+{
+  GtuberUtilsXmlJsonScanner *scanner;
+  gchar *buf, *value = NULL;
+  gboolean found = FALSE;
+
+  g_debug ("Stream JSON search: %s", json_name);
+
+  scanner = gtuber_utils_xml_json_scanner_new (json_name);
+  buf = g_malloc (XML_CHUNK_SIZE);
+
+  while (!found) {
+    gssize n_read;
+
+    n_read = g_input_stream_read (stream, buf, XML_CHUNK_SIZE, NULL, error);
+    if (n_read <= 0)
+      break;
+
+    found = gtuber_utils_xml_json_scanner_push_data (scanner, buf, n_read);
+  }
+
+  g_free (buf);
+
+  if (found)
+    value = gtuber_utils_xml_json_scanner_finish (scanner);
+
+  gtuber_utils_xml_json_scanner_free (scanner);
+
+  return value;
+}
@@ -19,15 +19,27 @@
 
 #pragma once
 
-#include <glib.h>
+#include <gio/gio.h>
 #include <libxml/tree.h>
 
 G_BEGIN_DECLS
 
+typedef struct _GtuberUtilsXmlJsonScanner GtuberUtilsXmlJsonScanner;
+
 xmlDoc *          gtuber_utils_xml_load_html_from_data         (const gchar *data, GError **error);
 
 const gchar *     gtuber_utils_xml_get_property_content        (xmlDoc *doc, const gchar *name);
 
 gchar *           gtuber_utils_xml_obtain_json_in_node         (xmlDoc *doc, const gchar *json_name);
 
+gchar *           gtuber_utils_xml_obtain_json_in_stream       (GInputStream *stream, const gchar *json_name, GError **error);
+
+GtuberUtilsXmlJsonScanner * gtuber_utils_xml_json_scanner_new  (const gchar *json_name);
+
+gboolean          gtuber_utils_xml_json_scanner_push_data      (GtuberUtilsXmlJsonScanner *scanner, const gchar *data, gsize size);
+
+gchar *           gtuber_utils_xml_json_scanner_finish         (GtuberUtilsXmlJsonScanner *scanner);
+
+void              gtuber_utils_xml_json_scanner_free           (GtuberUtilsXmlJsonScanner *scanner);
+
 G_END_DECLS